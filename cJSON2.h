@@ -6,11 +6,16 @@ extern "C"
 {
 #endif
 
+#include <stdint.h>
 #include <stdlib.h>
 
+/* Bytes of each node set aside for its short key and string value */
+#define CJSON_INLINE_STRINGS_SIZE   ( 24 )
+
 /****************************************
 Types
 ****************************************/
+
 typedef enum {
     cJSON_False,
     cJSON_True,
@@ -21,6 +26,23 @@ typedef enum {
     cJSON_Object
 } cJSON_ValueType;
 
+typedef enum {
+    cJSON_InArena           = 1 << 0,   /* Node and its strings are owned by a cJSON_Arena  */
+    cJSON_StringsReferenced = 1 << 1,   /* string and valuestring are not owned by the node */
+    cJSON_IsInt64           = 1 << 2,   /* valueint64 holds the number's exact value        */
+    cJSON_IsLazy            = 1 << 3,   /* Container not parsed yet, valuestring is its text */
+    cJSON_KeyInterned       = 1 << 4,   /* string is shared with other nodes of the document */
+    cJSON_KeyInline         = 1 << 5,   /* string is stored in the node's inline_strings     */
+    cJSON_ValueInline       = 1 << 6,   /* valuestring is stored in the node's inline_strings */
+    cJSON_IsIndexed         = 1 << 7    /* Container whose valuestring indexes its children */
+} cJSON_NodeFlag;
+
+typedef enum {
+    cJSON_ParseStructuralIndex = 1 << 0,    /* Index every token before building the tree */
+    cJSON_ParseLazy            = 1 << 1,    /* Parse nested containers on first access    */
+    cJSON_ParseInternKeys      = 1 << 2     /* Share one copy of each repeated object key */
+} cJSON_ParseFlag;
+
 
 typedef struct cJSON {
    struct cJSON * prev;
@@ -29,12 +51,18 @@ typedef struct cJSON {
    struct cJSON * child; 
    
    cJSON_ValueType type;
+   unsigned int    flags;
    
    char *   valuestring;
-   int      valueint;
+   int      valueint;           /* Or the number of children of a container */
    double   valuedouble;
+   int64_t  valueint64;
    
    char * string;
+
+   /* Short keys and string values are stored here rather than allocated on
+      their own, the key first. string and valuestring point into it. */
+   char     inline_strings[CJSON_INLINE_STRINGS_SIZE];
 } cJSON;
 
 typedef struct cJSON_Hooks {
@@ -43,21 +71,298 @@ typedef struct cJSON_Hooks {
       void (*free_fn)(void *ptr);
 } cJSON_Hooks;
 
+typedef struct cJSON_Arena cJSON_Arena;
+
+/* A read-only tree whose nodes sit in one pool and refer to each other by
+   32-bit index, for documents too large to hold as cJSON nodes. Its nodes are
+   named by their index in the pool; the root is 0. */
+typedef struct cJSON_Compact cJSON_Compact;
+
+/* A read-only document parsed into a flat tape of tokens rather than a tree of
+   nodes. Its values are named by their index in the tape; the root is 0. */
+typedef struct cJSON_Document cJSON_Document;
+
+typedef struct cJSON_Parser cJSON_Parser;
+
+/* A JSON Pointer compiled once to be run against many documents. */
+typedef struct cJSON_Query cJSON_Query;
+
+/* Receives each record parsed by cJSON_ParseNDJSON(), or NULL if the record
+   is not valid JSON. record_offset is where the record starts in the input.
+   The handler owns the record and must free it with cJSON_Delete(). Returns
+   nonzero to continue or 0 to stop. */
+typedef int (*cJSON_RecordHandler)(void *user_data, size_t record_offset, cJSON *record);
+
+/* Event callbacks for cJSON_ParseSax(). Each returns nonzero to continue or 0
+   to stop the parse. Any callback may be NULL. Strings and keys are decoded and
+   are not null-terminated. They point into the input unless they contain
+   escape sequences, and are only valid during the callback. Integers that fit
+   in 64 bits are reported through int64 if it is set, and through number
+   otherwise. */
+typedef struct cJSON_SaxHandler {
+      int (*start_object)(void *user_data);
+      int (*end_object)(void *user_data);
+      int (*start_array)(void *user_data);
+      int (*end_array)(void *user_data);
+      int (*key)(void *user_data, char const *key, size_t key_len);
+      int (*string)(void *user_data, char const *value, size_t value_len);
+      int (*number)(void *user_data, double value);
+      int (*int64)(void *user_data, int64_t value);
+      int (*boolean)(void *user_data, int value);
+      int (*null)(void *user_data);
+} cJSON_SaxHandler;
+
 
 /****************************************
 Functions
 ****************************************/
+cJSON_Arena * cJSON_ArenaCreate
+    (
+    void
+    );
+
+cJSON_Arena * cJSON_ArenaCreateWithHooks
+    (
+    cJSON_Hooks const * hooks
+    );
+
+void cJSON_ArenaDelete
+    (
+    cJSON_Arena * arena
+    );
+
+void cJSON_ArenaReset
+    (
+    cJSON_Arena * arena
+    );
+
+void cJSON_CompactDelete
+    (
+    cJSON_Compact * compact
+    );
+
+uint32_t cJSON_CompactGetArrayItem
+    (
+    cJSON_Compact const *   compact,
+    uint32_t                array,
+    uint32_t                index
+    );
+
+uint32_t cJSON_CompactGetChild
+    (
+    cJSON_Compact const *   compact,
+    uint32_t                node
+    );
+
+int64_t cJSON_CompactGetInt64
+    (
+    cJSON_Compact const *   compact,
+    uint32_t                node
+    );
+
+char const * cJSON_CompactGetKey
+    (
+    cJSON_Compact const *   compact,
+    uint32_t                node,
+    size_t *                key_len_out
+    );
+
+size_t cJSON_CompactGetMemorySize
+    (
+    cJSON_Compact const * compact
+    );
+
+uint32_t cJSON_CompactGetNext
+    (
+    cJSON_Compact const *   compact,
+    uint32_t                node
+    );
+
+size_t cJSON_CompactGetNodeCount
+    (
+    cJSON_Compact const * compact
+    );
+
+double cJSON_CompactGetNumber
+    (
+    cJSON_Compact const *   compact,
+    uint32_t                node
+    );
+
+uint32_t cJSON_CompactGetObjectItem
+    (
+    cJSON_Compact const *   compact,
+    uint32_t                object,
+    char const *            key
+    );
+
+uint32_t cJSON_CompactGetParent
+    (
+    cJSON_Compact const *   compact,
+    uint32_t                node
+    );
+
+uint32_t cJSON_CompactGetSize
+    (
+    cJSON_Compact const *   compact,
+    uint32_t                node
+    );
+
+char const * cJSON_CompactGetString
+    (
+    cJSON_Compact const *   compact,
+    uint32_t                node,
+    size_t *                string_len_out
+    );
+
+cJSON_ValueType cJSON_CompactGetType
+    (
+    cJSON_Compact const *   compact,
+    uint32_t                node
+    );
+
+int cJSON_CompactIsInt64
+    (
+    cJSON_Compact const *   compact,
+    uint32_t                node
+    );
+
+cJSON_Compact * cJSON_CompactParse
+    (
+    char const *    json_str,
+    size_t          json_len
+    );
+
+cJSON_Compact * cJSON_CompactParseWithHooks
+    (
+    char const *        json_str,
+    size_t              json_len,
+    cJSON_Hooks const * hooks
+    );
+
 void cJSON_Delete
     (
     cJSON * json
     );
 
+void cJSON_DeleteItemFromArray
+    (
+    cJSON * json_array,
+    int     index
+    );
+
+void cJSON_DeleteItemFromObject
+    (
+    cJSON *         json_object,
+    char const *    key
+    );
+
 void cJSON_DeleteWithHooks
     (
     cJSON *             json,
     cJSON_Hooks const * hooks
     );
 
+cJSON * cJSON_DetachItemFromArray
+    (
+    cJSON * json_array,
+    int     index
+    );
+
+cJSON * cJSON_DetachItemFromObject
+    (
+    cJSON *         json_object,
+    char const *    key
+    );
+
+void cJSON_DocumentDelete
+    (
+    cJSON_Document * document
+    );
+
+size_t cJSON_DocumentGetArrayItem
+    (
+    cJSON_Document const *  document,
+    size_t                  array,
+    size_t                  index
+    );
+
+size_t cJSON_DocumentGetChild
+    (
+    cJSON_Document const *  document,
+    size_t                  value
+    );
+
+int64_t cJSON_DocumentGetInt64
+    (
+    cJSON_Document const *  document,
+    size_t                  value
+    );
+
+char const * cJSON_DocumentGetKey
+    (
+    cJSON_Document const *  document,
+    size_t                  value,
+    size_t *                key_len_out
+    );
+
+size_t cJSON_DocumentGetNext
+    (
+    cJSON_Document const *  document,
+    size_t                  value
+    );
+
+double cJSON_DocumentGetNumber
+    (
+    cJSON_Document const *  document,
+    size_t                  value
+    );
+
+size_t cJSON_DocumentGetObjectItem
+    (
+    cJSON_Document const *  document,
+    size_t                  object,
+    char const *            key
+    );
+
+size_t cJSON_DocumentGetSize
+    (
+    cJSON_Document const *  document,
+    size_t                  value
+    );
+
+char const * cJSON_DocumentGetString
+    (
+    cJSON_Document const *  document,
+    size_t                  value,
+    size_t *                string_len_out
+    );
+
+cJSON_ValueType cJSON_DocumentGetType
+    (
+    cJSON_Document const *  document,
+    size_t                  value
+    );
+
+int cJSON_DocumentIsInt64
+    (
+    cJSON_Document const *  document,
+    size_t                  value
+    );
+
+cJSON_Document * cJSON_DocumentParse
+    (
+    char const *    json_str,
+    size_t          json_len
+    );
+
+cJSON_Document * cJSON_DocumentParseWithHooks
+    (
+    char const *        json_str,
+    size_t              json_len,
+    cJSON_Hooks const * hooks
+    );
+
 cJSON * cJSON_GetArrayItem
     (
     cJSON const *   json_array,
@@ -86,12 +391,134 @@ cJSON * cJSON_Parse
     char const *        json_str
     );
 
+cJSON * cJSON_ParseArena
+    (
+    char const *        json_str,
+    cJSON_Arena *       arena
+    );
+
+cJSON * cJSON_ParseFile
+    (
+    char const *    path,
+    unsigned int    flags
+    );
+
+cJSON * cJSON_ParseFileWithHooks
+    (
+    char const *        path,
+    unsigned int        flags,
+    cJSON_Hooks const * hooks
+    );
+
+cJSON * cJSON_ParseInSitu
+    (
+    char *              json_str,
+    size_t              json_len,
+    cJSON_Hooks const * hooks
+    );
+
+int cJSON_ParseNDJSON
+    (
+    char const *        ndjson_str,
+    size_t              ndjson_len,
+    unsigned int        thread_cnt,
+    int                 in_order,
+    cJSON_RecordHandler handler,
+    void *              user_data
+    );
+
+cJSON * cJSON_ParseParallel
+    (
+    char const *    json_str,
+    size_t          json_len,
+    unsigned int    thread_cnt
+    );
+
+int cJSON_ParseSax
+    (
+    char const *                json_str,
+    size_t                      json_len,
+    cJSON_SaxHandler const *    handler,
+    void *                      user_data
+    );
+
+cJSON * cJSON_ParseSelect
+    (
+    char const *            json_str,
+    size_t                  json_len,
+    char const * const *    paths,
+    size_t                  path_cnt
+    );
+
+cJSON * cJSON_ParseSelectWithHooks
+    (
+    char const *            json_str,
+    size_t                  json_len,
+    char const * const *    paths,
+    size_t                  path_cnt,
+    cJSON_Hooks const *     hooks
+    );
+
 cJSON * cJSON_ParseWithHooks
     (
     char const *        json_str,
     cJSON_Hooks const * hooks
     );
 
+cJSON * cJSON_ParseWithFlags
+    (
+    char const *        json_str,
+    size_t              json_len,
+    unsigned int        flags,
+    cJSON_Hooks const * hooks
+    );
+
+cJSON * cJSON_ParseWithLength
+    (
+    char const *        json_str,
+    size_t              json_len,
+    cJSON_Hooks const * hooks
+    );
+
+cJSON_Parser * cJSON_ParserCreate
+    (
+    void
+    );
+
+cJSON_Parser * cJSON_ParserCreateWithHooks
+    (
+    cJSON_Hooks const * hooks
+    );
+
+void cJSON_ParserDelete
+    (
+    cJSON_Parser * parser
+    );
+
+int cJSON_ParserFeed
+    (
+    cJSON_Parser *  parser,
+    char const *    chunk,
+    size_t          chunk_len
+    );
+
+cJSON * cJSON_ParserFinish
+    (
+    cJSON_Parser * parser
+    );
+
+cJSON * cJSON_ParserParse
+    (
+    cJSON_Parser *  parser,
+    char const *    json_str,
+    size_t          json_len
+    );
+
+void cJSON_ParserReset
+    (
+    cJSON_Parser * parser
+    );
+
 char * cJSON_Print
     (
     cJSON const * json
@@ -103,6 +530,36 @@ char * cJSON_PrintWithHooks
     cJSON_Hooks const * hooks
     );
 
+cJSON_Query * cJSON_QueryCompile
+    (
+    char const * path
+    );
+
+cJSON_Query * cJSON_QueryCompileWithHooks
+    (
+    char const *        path,
+    cJSON_Hooks const * hooks
+    );
+
+void cJSON_QueryDelete
+    (
+    cJSON_Query * query
+    );
+
+size_t cJSON_QueryRun
+    (
+    cJSON_Query const * query,
+    cJSON const *       json,
+    cJSON **            matches,
+    size_t              match_max
+    );
+
+int cJSON_Validate
+    (
+    char const *    json_str,
+    size_t          json_len
+    );
+
 #ifdef __cplusplus
 }
 #endif
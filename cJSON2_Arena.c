@@ -0,0 +1,243 @@
+/*
+ * Contains the arena (bump) allocator used to parse whole documents out of a
+ * small number of large chunks.
+ */
+
+#include <stddef.h>
+#include <string.h>
+
+#include "cJSON2.h"
+#include "cJSON2_private.h"
+
+#define ARENA_ALIGNMENT         ( sizeof( double ) )
+#define ARENA_CHUNK_SIZE        ( 64 * 1024 )
+
+/****************************************
+Private Types
+****************************************/
+typedef struct arena_chunk
+    {
+    struct arena_chunk *    next;
+    size_t                  size;       /* Number of usable bytes in data   */
+    size_t                  used;       /* Number of bytes handed out       */
+    double                  data[1];    /* Start of usable memory, aligned  */
+    } arena_chunk;
+
+struct cJSON_Arena
+    {
+    cJSON_Hooks     hooks;
+    arena_chunk *   first;
+    arena_chunk *   crnt;               /* Chunk allocations are carved from */
+    };
+
+
+/****************************************
+Private Function Declarations
+****************************************/
+static arena_chunk * arena_chunk_new
+    (
+    cJSON_Arena *   arena,
+    size_t          min_size
+    );
+
+
+/****************************************
+Public Functions
+****************************************/
+
+/**********************************************************
+*	cJSON_ArenaCreate
+*
+*	Create an arena with default hooks.
+*
+**********************************************************/
+cJSON_Arena * cJSON_ArenaCreate
+    (
+    void
+    )
+{
+cJSON_Hooks default_hooks;
+
+default_hooks.malloc_fn  = malloc;
+default_hooks.realloc_fn = realloc;
+default_hooks.free_fn    = free;
+
+return cJSON_ArenaCreateWithHooks( &default_hooks );
+}
+
+
+/**********************************************************
+*	cJSON_ArenaCreateWithHooks
+*
+*	Create an arena whose chunks are allocated with the
+*   provided hooks. Returns NULL on error. The caller must
+*   release the arena with cJSON_ArenaDelete().
+*
+**********************************************************/
+cJSON_Arena * cJSON_ArenaCreateWithHooks
+    (
+    cJSON_Hooks const * hooks
+    )
+{
+cJSON_Arena * arena;
+
+arena = (cJSON_Arena*)hooks->malloc_fn( sizeof( *arena ) );
+
+if( NULL != arena )
+    {
+    arena->hooks = *hooks;
+    arena->first = NULL;
+    arena->crnt  = NULL;
+    }
+
+return arena;
+}
+
+
+/**********************************************************
+*	cJSON_ArenaDelete
+*
+*	Releases an arena along with every tree that was parsed
+*   into it. This is O(chunks), not O(nodes).
+*
+**********************************************************/
+void cJSON_ArenaDelete
+    (
+    cJSON_Arena * arena
+    )
+{
+arena_chunk * chunk;
+arena_chunk * next_chunk;
+
+if( NULL == arena )
+    {
+    return;
+    }
+
+for( chunk = arena->first; NULL != chunk; chunk = next_chunk )
+    {
+    next_chunk = chunk->next;
+    arena->hooks.free_fn( chunk );
+    }
+
+arena->hooks.free_fn( arena );
+}
+
+
+/**********************************************************
+*	cJSON_ArenaReset
+*
+*	Releases every tree that was parsed into the arena but
+*   keeps its chunks so that later parses do not need to go
+*   back to the allocator.
+*
+**********************************************************/
+void cJSON_ArenaReset
+    (
+    cJSON_Arena * arena
+    )
+{
+arena_chunk * chunk;
+
+if( NULL == arena )
+    {
+    return;
+    }
+
+for( chunk = arena->first; NULL != chunk; chunk = chunk->next )
+    {
+    chunk->used = 0;
+    }
+
+arena->crnt = arena->first;
+}
+
+
+/**********************************************************
+*	arena_alloc
+*
+*	Carves size bytes out of the arena, adding a chunk if
+*   the remaining chunks are too small. Returns NULL if a
+*   new chunk could not be allocated.
+*
+**********************************************************/
+void * arena_alloc
+    (
+    cJSON_Arena *   arena,
+    size_t          size
+    )
+{
+arena_chunk *   chunk;
+void *          ptr;
+
+// Keep every allocation aligned for the widest member of a node.
+size = ( size + ARENA_ALIGNMENT - 1 ) & ~( ARENA_ALIGNMENT - 1 );
+
+// Walk forward through retained chunks until one has room.
+chunk = arena->crnt;
+while( ( NULL != chunk ) && ( chunk->size - chunk->used < size ) )
+    {
+    chunk = chunk->next;
+    }
+
+if( NULL == chunk )
+    {
+    chunk = arena_chunk_new( arena, size );
+    if( NULL == chunk )
+        {
+        return NULL;
+        }
+    }
+
+arena->crnt = chunk;
+ptr = (char*)chunk->data + chunk->used;
+chunk->used += size;
+
+return ptr;
+}
+
+
+/**********************************************************
+*	arena_chunk_new
+*
+*	Allocates a chunk large enough to hold min_size bytes
+*   and appends it to the arena's chunk list.
+*
+**********************************************************/
+static arena_chunk * arena_chunk_new
+    (
+    cJSON_Arena *   arena,
+    size_t          min_size
+    )
+{
+arena_chunk *   chunk;
+arena_chunk *   last;
+size_t          size;
+
+size = ( min_size > ARENA_CHUNK_SIZE ) ? min_size : ARENA_CHUNK_SIZE;
+
+chunk = (arena_chunk*)arena->hooks.malloc_fn( offsetof( arena_chunk, data ) + size );
+if( NULL == chunk )
+    {
+    return NULL;
+    }
+
+chunk->next = NULL;
+chunk->size = size;
+chunk->used = 0;
+
+// Append to the end of the list so that retained chunks are handed out
+// before this one after the next reset.
+if( NULL == arena->first )
+    {
+    arena->first = chunk;
+    }
+else
+    {
+    for( last = arena->first; NULL != last->next; last = last->next )
+        ;
+    last->next = chunk;
+    }
+
+return chunk;
+}
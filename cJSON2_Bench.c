@@ -0,0 +1,452 @@
+/*
+ * Contains the parser benchmark. It times whole-document parses of generated,
+ * token-dense inputs and, where the kernel allows it, counts the branch
+ * mispredictions they cause. It also reports how many bytes each parsed value
+ * takes as a cJSON node and as a compact tree node.
+ */
+
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#if defined( __linux__ )
+    #include <linux/perf_event.h>
+    #include <sys/syscall.h>
+    #include <unistd.h>
+#endif
+
+#include "cJSON2.h"
+
+#define BENCH_INPUT_SIZE        ( 8 * 1024 * 1024 )
+#define BENCH_MIN_SECONDS       ( 1.0 )
+
+/****************************************
+Private Types
+****************************************/
+typedef struct
+    {
+    char const *    description;
+    char const *    item;           /* Repeated to fill an array */
+    } bench_input;
+
+// Sits in front of each counted allocation to remember its size.
+typedef union
+    {
+    size_t      size;
+    max_align_t align;
+    } counted_header;
+
+
+/****************************************
+Private Function Declarations
+****************************************/
+static char * bench_input_build
+    (
+    bench_input const * input,
+    size_t *            json_len_out
+    );
+
+static int branch_counter_open
+    (
+    void
+    );
+
+static unsigned long long branch_counter_read
+    (
+    int fd
+    );
+
+static void * counted_malloc
+    (
+    size_t size
+    );
+
+static void * counted_realloc
+    (
+    void *  ptr,
+    size_t  size
+    );
+
+static void counted_free
+    (
+    void * ptr
+    );
+
+static size_t node_count
+    (
+    cJSON const * json
+    );
+
+static double seconds_now
+    (
+    void
+    );
+
+
+/****************************************
+Private Variables
+****************************************/
+static bench_input const bench_inputs[] =
+    {
+    {   "Small integers",   "7,"                                                    },
+    {   "Literals",         "true,null,false,"                                      },
+    {   "Mixed numbers",    "-12,3.25,1e-3,65536,"                                  },
+    {   "Records",          "{\"id\":12,\"ok\":true,\"tag\":null,\"name\":\"x\"},"  },
+    {   "Nested arrays",    "[[1],[],[[0]]],"                                       },
+    };
+
+static size_t counted_bytes;    /* Live bytes allocated through the counting hooks */
+
+
+/**********************************************************
+*	main
+*
+*	Runs each benchmark input and prints its throughput and
+*   branch mispredictions per thousand input bytes, then the
+*   memory each parsed value takes in a cJSON tree and in a
+*   compact tree.
+*
+**********************************************************/
+int main
+    (
+    void
+    )
+{
+char *              json_str;
+size_t              json_len;
+size_t              i;
+int                 counter_fd;
+int                 parse_cnt;
+double              start;
+double              elapsed;
+unsigned long long  branch_misses;
+size_t              tree_bytes;
+cJSON_Hooks         hooks;
+cJSON_Hooks         counted_hooks;
+cJSON *             json;
+cJSON_Compact *     compact;
+
+hooks.malloc_fn  = malloc;
+hooks.realloc_fn = realloc;
+hooks.free_fn    = free;
+
+counted_hooks.malloc_fn  = counted_malloc;
+counted_hooks.realloc_fn = counted_realloc;
+counted_hooks.free_fn    = counted_free;
+
+counter_fd = branch_counter_open();
+
+printf( "%-16s %10s %16s\n", "Input", "MB/s", "Misses/KB" );
+
+for( i = 0; i < sizeof( bench_inputs ) / sizeof( bench_inputs[0] ); i++ )
+    {
+    json_str = bench_input_build( &bench_inputs[i], &json_len );
+    if( NULL == json_str )
+        {
+        return 1;
+        }
+
+    // Parse repeatedly for long enough to smooth out timer resolution.
+    branch_misses = branch_counter_read( counter_fd );
+    start         = seconds_now();
+    elapsed       = 0;
+    parse_cnt     = 0;
+
+    do
+        {
+        json = cJSON_ParseWithLength( json_str, json_len, &hooks );
+        if( NULL == json )
+            {
+            printf( "%-16s failed to parse\n", bench_inputs[i].description );
+            break;
+            }
+
+        cJSON_Delete( json );
+        parse_cnt++;
+        elapsed = seconds_now() - start;
+        } while( elapsed < BENCH_MIN_SECONDS );
+
+    branch_misses = branch_counter_read( counter_fd ) - branch_misses;
+
+    if( 0 == parse_cnt )
+        {
+        // Already reported
+        }
+    else if( counter_fd < 0 )
+        {
+        printf( "%-16s %10.1f %16s\n", bench_inputs[i].description, parse_cnt * json_len / elapsed / 1e6, "n/a" );
+        }
+    else
+        {
+        printf( "%-16s %10.1f %16.2f\n", bench_inputs[i].description, parse_cnt * json_len / elapsed / 1e6, branch_misses * 1024.0 / ( (double)parse_cnt * json_len ) );
+        }
+
+    free( json_str );
+    }
+
+printf( "\n%-16s %10s %16s %16s\n", "Input", "Values", "Tree B/value", "Compact B/value" );
+
+for( i = 0; i < sizeof( bench_inputs ) / sizeof( bench_inputs[0] ); i++ )
+    {
+    json_str = bench_input_build( &bench_inputs[i], &json_len );
+    if( NULL == json_str )
+        {
+        return 1;
+        }
+
+    // Both layouts are measured by what they hold on to once parsed, which
+    // for the tree includes the allocator's share of every node.
+    json       = cJSON_ParseWithLength( json_str, json_len, &counted_hooks );
+    tree_bytes = counted_bytes;
+    compact    = cJSON_CompactParseWithHooks( json_str, json_len, &hooks );
+
+    if( ( NULL == json ) || ( NULL == compact ) )
+        {
+        printf( "%-16s failed to parse\n", bench_inputs[i].description );
+        }
+    else
+        {
+        printf( "%-16s %10zu %16.1f %16.1f\n", bench_inputs[i].description, node_count( json ),
+                (double)tree_bytes / node_count( json ),
+                (double)cJSON_CompactGetMemorySize( compact ) / cJSON_CompactGetNodeCount( compact ) );
+        }
+
+    cJSON_DeleteWithHooks( json, &counted_hooks );
+    cJSON_CompactDelete( compact );
+    free( json_str );
+    }
+
+return 0;
+}
+
+
+/**********************************************************
+*	bench_input_build
+*
+*	Builds an array holding enough copies of the input's item
+*   to fill BENCH_INPUT_SIZE bytes.
+*
+**********************************************************/
+static char * bench_input_build
+    (
+    bench_input const * input,
+    size_t *            json_len_out
+    )
+{
+char *  json_str;
+size_t  item_len;
+size_t  json_len;
+
+item_len = strlen( input->item );
+json_str = (char*)malloc( BENCH_INPUT_SIZE + item_len + 2 );
+if( NULL == json_str )
+    {
+    return NULL;
+    }
+
+json_str[0] = '[';
+for( json_len = 1; json_len < BENCH_INPUT_SIZE; json_len += item_len )
+    {
+    memcpy( &json_str[json_len], input->item, item_len );
+    }
+
+// Replace the last item's trailing comma with the closing bracket.
+json_str[json_len - 1] = ']';
+json_str[json_len]     = '\0';
+
+*json_len_out = json_len;
+
+return json_str;
+}
+
+
+/**********************************************************
+*	branch_counter_open
+*
+*	Starts counting this process's branch mispredictions.
+*   Returns a counter, or -1 if there are no hardware
+*   counters to use.
+*
+**********************************************************/
+static int branch_counter_open
+    (
+    void
+    )
+{
+#if defined( __linux__ )
+struct perf_event_attr  attr;
+int                     fd;
+
+memset( &attr, 0, sizeof( attr ) );
+attr.size           = sizeof( attr );
+attr.type           = PERF_TYPE_HARDWARE;
+attr.config         = PERF_COUNT_HW_BRANCH_MISSES;
+attr.exclude_kernel = 1;
+attr.exclude_hv     = 1;
+
+fd = (int)syscall( SYS_perf_event_open, &attr, 0, -1, -1, 0 );
+
+return ( fd < 0 ) ? -1 : fd;
+#else
+return -1;
+#endif
+}
+
+
+/**********************************************************
+*	branch_counter_read
+*
+*	Returns the number of branch mispredictions counted so
+*   far, or 0 if there is no counter.
+*
+**********************************************************/
+static unsigned long long branch_counter_read
+    (
+    int fd
+    )
+{
+unsigned long long count;
+
+count = 0;
+
+#if defined( __linux__ )
+if( ( fd < 0 ) || ( sizeof( count ) != read( fd, &count, sizeof( count ) ) ) )
+    {
+    count = 0;
+    }
+#endif
+
+return count;
+}
+
+
+/**********************************************************
+*	counted_free
+*
+*	Frees a block from counted_malloc() and stops counting
+*   its bytes.
+*
+**********************************************************/
+static void counted_free
+    (
+    void * ptr
+    )
+{
+counted_header * header;
+
+if( NULL == ptr )
+    {
+    return;
+    }
+
+header         = (counted_header*)ptr - 1;
+counted_bytes -= header->size;
+free( header );
+}
+
+
+/**********************************************************
+*	counted_malloc
+*
+*	Allocates a block and counts its bytes, along with the
+*   header that remembers its size.
+*
+**********************************************************/
+static void * counted_malloc
+    (
+    size_t size
+    )
+{
+counted_header * header;
+
+header = (counted_header*)malloc( sizeof( *header ) + size );
+if( NULL == header )
+    {
+    return NULL;
+    }
+
+header->size   = sizeof( *header ) + size;
+counted_bytes += header->size;
+
+return &header[1];
+}
+
+
+/**********************************************************
+*	counted_realloc
+*
+*	Resizes a block from counted_malloc() and updates the
+*   count.
+*
+**********************************************************/
+static void * counted_realloc
+    (
+    void *  ptr,
+    size_t  size
+    )
+{
+counted_header *    header;
+size_t              old_size;
+
+if( NULL == ptr )
+    {
+    return counted_malloc( size );
+    }
+
+header   = (counted_header*)ptr - 1;
+old_size = header->size;
+header   = (counted_header*)realloc( header, sizeof( *header ) + size );
+if( NULL == header )
+    {
+    return NULL;
+    }
+
+header->size   = sizeof( *header ) + size;
+counted_bytes += header->size - old_size;
+
+return &header[1];
+}
+
+
+/**********************************************************
+*	node_count
+*
+*	Returns the number of nodes in a cJSON tree.
+*
+**********************************************************/
+static size_t node_count
+    (
+    cJSON const * json
+    )
+{
+size_t          cnt;
+cJSON const *   child;
+
+cnt = 1;
+for( child = json->child; NULL != child; child = child->next )
+    {
+    cnt += node_count( child );
+    }
+
+return cnt;
+}
+
+
+/**********************************************************
+*	seconds_now
+*
+*	Returns a monotonic time in seconds.
+*
+**********************************************************/
+static double seconds_now
+    (
+    void
+    )
+{
+struct timespec now;
+
+clock_gettime( CLOCK_MONOTONIC, &now );
+
+return now.tv_sec + now.tv_nsec / 1e9;
+}
@@ -0,0 +1,1001 @@
+/*
+ * Contains the compact tree, a read-only tree of nodes for documents too large
+ * to hold as cJSON nodes. Its nodes live in one pool and refer to each other by
+ * 32-bit index instead of by pointer, hold their value in a union and pack
+ * their type beside their parent's index, which brings a node down to 20 bytes
+ * from the 80 of a cJSON node. Keys and strings are kept in a pool of their own
+ * instead of being allocated one by one.
+ *
+ * Nodes are named by their index in the pool. The root is node 0, which is
+ * never another node's child or sibling, so the accessors return 0 for "no
+ * such node".
+ */
+
+#include <string.h>
+
+#include "cJSON2.h"
+#include "cJSON2_private.h"
+
+#define COMPACT_TYPE_BITS       ( 4 )
+#define COMPACT_TYPE_MASK       ( ( 1u << COMPACT_TYPE_BITS ) - 1 )
+#define COMPACT_MAX_NODE_CNT    ( (uint32_t)-1 >> COMPACT_TYPE_BITS )
+
+#define compact_type( _node )   ( (compact_node_type)( (_node)->parent_type & COMPACT_TYPE_MASK ) )
+
+#define compact_parent( _node ) ( (_node)->parent_type >> COMPACT_TYPE_BITS )
+
+/****************************************
+Private Types
+****************************************/
+
+// cJSON_ValueType, but with integers told apart from other numbers.
+typedef enum
+    {
+    COMPACT_TYPE_FALSE,
+    COMPACT_TYPE_TRUE,
+    COMPACT_TYPE_NULL,
+    COMPACT_TYPE_DOUBLE,
+    COMPACT_TYPE_STRING,
+    COMPACT_TYPE_ARRAY,
+    COMPACT_TYPE_OBJECT,
+    COMPACT_TYPE_INT64,
+    } compact_node_type;
+
+typedef struct
+    {
+    uint32_t    next;           /* Next sibling, or 0                       */
+    uint32_t    parent_type;    /* Parent's index above the type bits       */
+    uint32_t    key;            /* Key's offset in the string pool, or 0    */
+    uint32_t    value[2];       /* Bits of a double or int64, a string's    */
+                                /* offset, or a container's first child and */
+                                /* number of children                       */
+    } compact_node;
+
+struct cJSON_Compact
+    {
+    cJSON_Hooks     hooks;
+    compact_node *  nodes;
+    size_t          node_cnt;
+    size_t          nodes_size;
+    char *          strings;        /* Length, text and terminator of each  */
+    size_t          strings_len;
+    size_t          strings_size;
+    };
+
+typedef struct
+    {
+    uint32_t node;
+    uint32_t last_child;            /* 0 until the first child is added     */
+    } open_container;
+
+typedef struct
+    {
+    cJSON_Compact *     compact;
+    open_container *    open;       /* Containers not closed yet, innermost last */
+    size_t              open_cnt;
+    size_t              open_size;
+    uint32_t            key;        /* Key for the next node, or 0          */
+    } compact_builder;
+
+
+/****************************************
+Private Function Declarations
+****************************************/
+static compact_node * build_node
+    (
+    compact_builder *   builder,
+    compact_node_type   type
+    );
+
+static uint32_t build_text
+    (
+    compact_builder *   builder,
+    char const *        text,
+    size_t              text_len
+    );
+
+static int on_boolean
+    (
+    void *  builder,
+    int     value
+    );
+
+static int on_container_end
+    (
+    void * builder
+    );
+
+static int on_int64
+    (
+    void *  builder,
+    int64_t value
+    );
+
+static int on_key
+    (
+    void *          builder,
+    char const *    key,
+    size_t          key_len
+    );
+
+static int on_null
+    (
+    void * builder
+    );
+
+static int on_number
+    (
+    void *  builder,
+    double  value
+    );
+
+static int on_start_array
+    (
+    void * builder
+    );
+
+static int on_start_object
+    (
+    void * builder
+    );
+
+static int on_string
+    (
+    void *          builder,
+    char const *    value,
+    size_t          value_len
+    );
+
+static int open_container_push
+    (
+    compact_builder *   builder,
+    compact_node_type   type
+    );
+
+static char const * text_at
+    (
+    cJSON_Compact const *   compact,
+    uint32_t                offset,
+    size_t *                text_len_out
+    );
+
+
+/****************************************
+Private Variables
+****************************************/
+static cJSON_SaxHandler const compact_events =
+    {
+    on_start_object,
+    on_container_end,
+    on_start_array,
+    on_container_end,
+    on_key,
+    on_string,
+    on_number,
+    on_int64,
+    on_boolean,
+    on_null,
+    };
+
+
+/****************************************
+Public Functions
+****************************************/
+
+/**********************************************************
+*	cJSON_CompactDelete
+*
+*	Frees a compact tree and everything in it.
+*
+**********************************************************/
+void cJSON_CompactDelete
+    (
+    cJSON_Compact * compact
+    )
+{
+if( NULL == compact )
+    {
+    return;
+    }
+
+if( NULL != compact->nodes )
+    {
+    compact->hooks.free_fn( compact->nodes );
+    }
+
+if( NULL != compact->strings )
+    {
+    compact->hooks.free_fn( compact->strings );
+    }
+
+compact->hooks.free_fn( compact );
+}
+
+
+/**********************************************************
+*	cJSON_CompactGetArrayItem
+*
+*	Returns the node at the provided index of an array, or 0
+*   if there is none.
+*
+**********************************************************/
+uint32_t cJSON_CompactGetArrayItem
+    (
+    cJSON_Compact const *   compact,
+    uint32_t                array,
+    uint32_t                index
+    )
+{
+uint32_t item;
+
+if( ( NULL == compact ) || ( COMPACT_TYPE_ARRAY != compact_type( &compact->nodes[array] ) ) )
+    {
+    return 0;
+    }
+
+for( item = compact->nodes[array].value[0]; ( 0 != item ) && ( 0 != index ); index-- )
+    {
+    item = compact->nodes[item].next;
+    }
+
+return item;
+}
+
+
+/**********************************************************
+*	cJSON_CompactGetChild
+*
+*	Returns the first node in an array or object, or 0 if
+*   it is empty or not a container.
+*
+**********************************************************/
+uint32_t cJSON_CompactGetChild
+    (
+    cJSON_Compact const *   compact,
+    uint32_t                node
+    )
+{
+compact_node_type type;
+
+if( NULL == compact )
+    {
+    return 0;
+    }
+
+type = compact_type( &compact->nodes[node] );
+
+return ( ( COMPACT_TYPE_ARRAY == type ) || ( COMPACT_TYPE_OBJECT == type ) ) ? compact->nodes[node].value[0] : 0;
+}
+
+
+/**********************************************************
+*	cJSON_CompactGetInt64
+*
+*	Returns a number's exact value if it was written as an
+*   integer that fits in 64 bits, otherwise returns 0. See
+*   cJSON_CompactIsInt64().
+*
+**********************************************************/
+int64_t cJSON_CompactGetInt64
+    (
+    cJSON_Compact const *   compact,
+    uint32_t                node
+    )
+{
+int64_t value;
+
+if( !cJSON_CompactIsInt64( compact, node ) )
+    {
+    return 0;
+    }
+
+memcpy( &value, compact->nodes[node].value, sizeof( value ) );
+
+return value;
+}
+
+
+/**********************************************************
+*	cJSON_CompactGetKey
+*
+*	Returns the key of an object member and its length, or
+*   NULL if the node is not in an object. The key is null-
+*   terminated, but may also hold escaped null characters.
+*
+**********************************************************/
+char const * cJSON_CompactGetKey
+    (
+    cJSON_Compact const *   compact,
+    uint32_t                node,
+    size_t *                key_len_out
+    )
+{
+if( ( NULL == compact ) || ( 0 == compact->nodes[node].key ) )
+    {
+    return NULL;
+    }
+
+return text_at( compact, compact->nodes[node].key, key_len_out );
+}
+
+
+/**********************************************************
+*	cJSON_CompactGetMemorySize
+*
+*	Returns the number of bytes allocated to hold a compact
+*   tree, including its nodes and strings.
+*
+**********************************************************/
+size_t cJSON_CompactGetMemorySize
+    (
+    cJSON_Compact const * compact
+    )
+{
+if( NULL == compact )
+    {
+    return 0;
+    }
+
+return sizeof( *compact ) + compact->nodes_size + compact->strings_size;
+}
+
+
+/**********************************************************
+*	cJSON_CompactGetNext
+*
+*	Returns the node following the provided one in its array
+*   or object, or 0 if it is the last one.
+*
+**********************************************************/
+uint32_t cJSON_CompactGetNext
+    (
+    cJSON_Compact const *   compact,
+    uint32_t                node
+    )
+{
+return ( NULL == compact ) ? 0 : compact->nodes[node].next;
+}
+
+
+/**********************************************************
+*	cJSON_CompactGetNodeCount
+*
+*	Returns the number of nodes in a compact tree.
+*
+**********************************************************/
+size_t cJSON_CompactGetNodeCount
+    (
+    cJSON_Compact const * compact
+    )
+{
+return ( NULL == compact ) ? 0 : compact->node_cnt;
+}
+
+
+/**********************************************************
+*	cJSON_CompactGetNumber
+*
+*	Returns a number's value, or 0 if the node is not a
+*   number.
+*
+**********************************************************/
+double cJSON_CompactGetNumber
+    (
+    cJSON_Compact const *   compact,
+    uint32_t                node
+    )
+{
+double              number;
+compact_node_type   type;
+
+if( NULL == compact )
+    {
+    return 0;
+    }
+
+type = compact_type( &compact->nodes[node] );
+
+if( COMPACT_TYPE_INT64 == type )
+    {
+    return (double)cJSON_CompactGetInt64( compact, node );
+    }
+else if( COMPACT_TYPE_DOUBLE == type )
+    {
+    memcpy( &number, compact->nodes[node].value, sizeof( number ) );
+    return number;
+    }
+
+return 0;
+}
+
+
+/**********************************************************
+*	cJSON_CompactGetObjectItem
+*
+*	Returns the first member of an object with the provided
+*   key, or 0 if there is none.
+*
+**********************************************************/
+uint32_t cJSON_CompactGetObjectItem
+    (
+    cJSON_Compact const *   compact,
+    uint32_t                object,
+    char const *            key
+    )
+{
+char const *    item_key;
+size_t          item_key_len;
+size_t          key_len;
+uint32_t        item;
+
+if( ( NULL == compact ) || ( NULL == key ) || ( COMPACT_TYPE_OBJECT != compact_type( &compact->nodes[object] ) ) )
+    {
+    return 0;
+    }
+
+key_len = strlen( key );
+
+for( item = compact->nodes[object].value[0]; 0 != item; item = compact->nodes[item].next )
+    {
+    item_key = text_at( compact, compact->nodes[item].key, &item_key_len );
+    if( ( key_len == item_key_len ) && ( 0 == memcmp( key, item_key, key_len ) ) )
+        {
+        return item;
+        }
+    }
+
+return 0;
+}
+
+
+/**********************************************************
+*	cJSON_CompactGetParent
+*
+*	Returns the array or object holding a node. The root has
+*   no parent and returns its own index, 0.
+*
+**********************************************************/
+uint32_t cJSON_CompactGetParent
+    (
+    cJSON_Compact const *   compact,
+    uint32_t                node
+    )
+{
+return ( NULL == compact ) ? 0 : compact_parent( &compact->nodes[node] );
+}
+
+
+/**********************************************************
+*	cJSON_CompactGetSize
+*
+*	Returns the number of nodes in an array or object, or 0
+*   if the node is not a container.
+*
+**********************************************************/
+uint32_t cJSON_CompactGetSize
+    (
+    cJSON_Compact const *   compact,
+    uint32_t                node
+    )
+{
+compact_node_type type;
+
+if( NULL == compact )
+    {
+    return 0;
+    }
+
+type = compact_type( &compact->nodes[node] );
+
+return ( ( COMPACT_TYPE_ARRAY == type ) || ( COMPACT_TYPE_OBJECT == type ) ) ? compact->nodes[node].value[1] : 0;
+}
+
+
+/**********************************************************
+*	cJSON_CompactGetString
+*
+*	Returns a string's decoded text and its length, or NULL
+*   if the node is not a string. The text is null-
+*   terminated, but may also hold escaped null characters.
+*
+**********************************************************/
+char const * cJSON_CompactGetString
+    (
+    cJSON_Compact const *   compact,
+    uint32_t                node,
+    size_t *                string_len_out
+    )
+{
+if( ( NULL == compact ) || ( COMPACT_TYPE_STRING != compact_type( &compact->nodes[node] ) ) )
+    {
+    return NULL;
+    }
+
+return text_at( compact, compact->nodes[node].value[0], string_len_out );
+}
+
+
+/**********************************************************
+*	cJSON_CompactGetType
+*
+*	Returns the type of a node, or cJSON_Null if there is no
+*   compact tree.
+*
+**********************************************************/
+cJSON_ValueType cJSON_CompactGetType
+    (
+    cJSON_Compact const *   compact,
+    uint32_t                node
+    )
+{
+compact_node_type type;
+
+if( NULL == compact )
+    {
+    return cJSON_Null;
+    }
+
+type = compact_type( &compact->nodes[node] );
+
+return ( COMPACT_TYPE_INT64 == type ) ? cJSON_Number : (cJSON_ValueType)type;
+}
+
+
+/**********************************************************
+*	cJSON_CompactIsInt64
+*
+*	Returns 1 if a node is a number written as an integer
+*   that fits in 64 bits, whose exact value is returned by
+*   cJSON_CompactGetInt64(). Otherwise returns 0.
+*
+**********************************************************/
+int cJSON_CompactIsInt64
+    (
+    cJSON_Compact const *   compact,
+    uint32_t                node
+    )
+{
+return ( NULL != compact ) && ( COMPACT_TYPE_INT64 == compact_type( &compact->nodes[node] ) );
+}
+
+
+/**********************************************************
+*	cJSON_CompactParse
+*
+*	Parse the first json_len characters of a JSON string
+*   into a compact tree with default hooks.
+*
+**********************************************************/
+cJSON_Compact * cJSON_CompactParse
+    (
+    char const *    json_str,
+    size_t          json_len
+    )
+{
+cJSON_Hooks default_hooks;
+
+default_hooks.malloc_fn  = malloc;
+default_hooks.realloc_fn = realloc;
+default_hooks.free_fn    = free;
+
+return cJSON_CompactParseWithHooks( json_str, json_len, &default_hooks );
+}
+
+
+/**********************************************************
+*	cJSON_CompactParseWithHooks
+*
+*	Parse the first json_len characters of a JSON string
+*   into a compact tree allocated with the provided hooks.
+*   On error, or if the document has more nodes or string
+*   text than 32-bit indices can reach, this returns NULL.
+*   Otherwise, the caller must free the returned tree with
+*   cJSON_CompactDelete().
+*
+**********************************************************/
+cJSON_Compact * cJSON_CompactParseWithHooks
+    (
+    char const *        json_str,
+    size_t              json_len,
+    cJSON_Hooks const * hooks
+    )
+{
+compact_builder builder;
+cJSON_Compact * compact;
+int             is_valid;
+
+if( ( NULL == json_str ) || ( NULL == hooks ) )
+    {
+    return NULL;
+    }
+
+compact = (cJSON_Compact*)hooks->malloc_fn( sizeof( *compact ) );
+if( NULL == compact )
+    {
+    return NULL;
+    }
+
+memset( compact, 0, sizeof( *compact ) );
+compact->hooks = *hooks;
+
+memset( &builder, 0, sizeof( builder ) );
+builder.compact = compact;
+
+// Offset 0 of the string pool holds nothing, so that a key of 0 means none.
+is_valid = buffer_reserve( hooks, (void**)&compact->strings, &compact->strings_size, 1 );
+compact->strings_len = 1;
+
+is_valid = ( is_valid ) && ( sax_parse( json_str, json_len, &compact_events, &builder, hooks ) );
+
+if( NULL != builder.open )
+    {
+    hooks->free_fn( builder.open );
+    }
+
+if( !is_valid )
+    {
+    cJSON_CompactDelete( compact );
+    return NULL;
+    }
+
+return compact;
+}
+
+
+/****************************************
+Private Functions
+****************************************/
+
+/**********************************************************
+*	build_node
+*
+*	Adds a node to the pool and links it in as the last
+*   child of the innermost open container, with the key
+*   reported just before it. Returns NULL if memory runs out
+*   or the pool is full.
+*
+**********************************************************/
+static compact_node * build_node
+    (
+    compact_builder *   builder,
+    compact_node_type   type
+    )
+{
+cJSON_Compact *     compact;
+compact_node *      node;
+open_container *    parent;
+void *              nodes;
+uint32_t            index;
+
+compact = builder->compact;
+nodes   = compact->nodes;
+
+if( ( compact->node_cnt >= COMPACT_MAX_NODE_CNT )
+ || ( !buffer_reserve( &compact->hooks, &nodes, &compact->nodes_size, ( compact->node_cnt + 1 ) * sizeof( *compact->nodes ) ) ) )
+    {
+    return NULL;
+    }
+
+compact->nodes = (compact_node*)nodes;
+index          = (uint32_t)compact->node_cnt++;
+node           = &compact->nodes[index];
+
+memset( node, 0, sizeof( *node ) );
+node->key    = builder->key;
+builder->key = 0;
+
+if( 0 == builder->open_cnt )
+    {
+    node->parent_type = type;
+    return node;
+    }
+
+parent            = &builder->open[builder->open_cnt - 1];
+node->parent_type = ( parent->node << COMPACT_TYPE_BITS ) | type;
+
+if( 0 == parent->last_child )
+    {
+    compact->nodes[parent->node].value[0] = index;
+    }
+else
+    {
+    compact->nodes[parent->last_child].next = index;
+    }
+
+parent->last_child = index;
+compact->nodes[parent->node].value[1]++;
+
+return node;
+}
+
+
+/**********************************************************
+*	build_text
+*
+*	Adds a key or string to the string pool, as its length
+*   followed by its text and a null terminator. Returns its
+*   offset, or 0 if memory runs out or the pool is full.
+*
+**********************************************************/
+static uint32_t build_text
+    (
+    compact_builder *   builder,
+    char const *        text,
+    size_t              text_len
+    )
+{
+cJSON_Compact * compact;
+void *          strings;
+uint32_t        stored_len;
+size_t          offset;
+
+compact = builder->compact;
+strings = compact->strings;
+offset  = compact->strings_len;
+
+stored_len = (uint32_t)text_len;
+if( ( stored_len != text_len ) || ( offset + sizeof( stored_len ) + text_len + 1 > (uint32_t)-1 )
+ || ( !buffer_reserve( &compact->hooks, &strings, &compact->strings_size, offset + sizeof( stored_len ) + text_len + 1 ) ) )
+    {
+    return 0;
+    }
+
+compact->strings = (char*)strings;
+memcpy( &compact->strings[offset], &stored_len, sizeof( stored_len ) );
+memcpy( &compact->strings[offset + sizeof( stored_len )], text, text_len );
+compact->strings[offset + sizeof( stored_len ) + text_len] = '\0';
+compact->strings_len = offset + sizeof( stored_len ) + text_len + 1;
+
+return (uint32_t)offset;
+}
+
+
+/**********************************************************
+*	on_boolean
+*
+*	Adds a true or false node.
+*
+**********************************************************/
+static int on_boolean
+    (
+    void *  builder,
+    int     value
+    )
+{
+return ( NULL != build_node( (compact_builder*)builder, ( value ) ? COMPACT_TYPE_TRUE : COMPACT_TYPE_FALSE ) );
+}
+
+
+/**********************************************************
+*	on_container_end
+*
+*	Closes the innermost open array or object.
+*
+**********************************************************/
+static int on_container_end
+    (
+    void * builder
+    )
+{
+( (compact_builder*)builder )->open_cnt--;
+
+return 1;
+}
+
+
+/**********************************************************
+*	on_int64
+*
+*	Adds an integer node.
+*
+**********************************************************/
+static int on_int64
+    (
+    void *  builder,
+    int64_t value
+    )
+{
+compact_node * node;
+
+node = build_node( (compact_builder*)builder, COMPACT_TYPE_INT64 );
+if( NULL == node )
+    {
+    return 0;
+    }
+
+memcpy( node->value, &value, sizeof( value ) );
+
+return 1;
+}
+
+
+/**********************************************************
+*	on_key
+*
+*	Holds on to an object key for the node that follows it.
+*
+**********************************************************/
+static int on_key
+    (
+    void *          builder,
+    char const *    key,
+    size_t          key_len
+    )
+{
+compact_builder * b;
+
+b      = (compact_builder*)builder;
+b->key = build_text( b, key, key_len );
+
+return ( 0 != b->key );
+}
+
+
+/**********************************************************
+*	on_null
+*
+*	Adds a null node.
+*
+**********************************************************/
+static int on_null
+    (
+    void * builder
+    )
+{
+return ( NULL != build_node( (compact_builder*)builder, COMPACT_TYPE_NULL ) );
+}
+
+
+/**********************************************************
+*	on_number
+*
+*	Adds a double node.
+*
+**********************************************************/
+static int on_number
+    (
+    void *  builder,
+    double  value
+    )
+{
+compact_node * node;
+
+node = build_node( (compact_builder*)builder, COMPACT_TYPE_DOUBLE );
+if( NULL == node )
+    {
+    return 0;
+    }
+
+memcpy( node->value, &value, sizeof( value ) );
+
+return 1;
+}
+
+
+/**********************************************************
+*	on_start_array
+*
+*	Adds an array node and opens it.
+*
+**********************************************************/
+static int on_start_array
+    (
+    void * builder
+    )
+{
+return open_container_push( (compact_builder*)builder, COMPACT_TYPE_ARRAY );
+}
+
+
+/**********************************************************
+*	on_start_object
+*
+*	Adds an object node and opens it.
+*
+**********************************************************/
+static int on_start_object
+    (
+    void * builder
+    )
+{
+return open_container_push( (compact_builder*)builder, COMPACT_TYPE_OBJECT );
+}
+
+
+/**********************************************************
+*	on_string
+*
+*	Adds a string node.
+*
+**********************************************************/
+static int on_string
+    (
+    void *          builder,
+    char const *    value,
+    size_t          value_len
+    )
+{
+compact_builder *   b;
+compact_node *      node;
+uint32_t            offset;
+
+b = (compact_builder*)builder;
+
+// Add the text first, so that a key still waiting for the node isn't lost.
+offset = build_text( b, value, value_len );
+node   = ( 0 == offset ) ? NULL : build_node( b, COMPACT_TYPE_STRING );
+if( NULL == node )
+    {
+    return 0;
+    }
+
+node->value[0] = offset;
+
+return 1;
+}
+
+
+/**********************************************************
+*	open_container_push
+*
+*	Adds an array or object node and makes it the innermost
+*   open container.
+*
+**********************************************************/
+static int open_container_push
+    (
+    compact_builder *   builder,
+    compact_node_type   type
+    )
+{
+void * open;
+
+open = builder->open;
+if( !buffer_reserve( &builder->compact->hooks, &open, &builder->open_size, ( builder->open_cnt + 1 ) * sizeof( *builder->open ) ) )
+    {
+    return 0;
+    }
+
+// The stack may have moved, and build_node() links the new container in
+// through its parent's entry.
+builder->open = (open_container*)open;
+if( NULL == build_node( builder, type ) )
+    {
+    return 0;
+    }
+
+builder->open[builder->open_cnt].node       = (uint32_t)( builder->compact->node_cnt - 1 );
+builder->open[builder->open_cnt].last_child = 0;
+builder->open_cnt++;
+
+return 1;
+}
+
+
+/**********************************************************
+*	text_at
+*
+*	Returns the text of the key or string at the provided
+*   offset in the string pool, and its length.
+*
+**********************************************************/
+static char const * text_at
+    (
+    cJSON_Compact const *   compact,
+    uint32_t                offset,
+    size_t *                text_len_out
+    )
+{
+char const *    stored;
+uint32_t        stored_len;
+
+stored = &compact->strings[offset];
+memcpy( &stored_len, stored, sizeof( stored_len ) );
+
+if( NULL != text_len_out )
+    {
+    *text_len_out = stored_len;
+    }
+
+return &stored[sizeof( stored_len )];
+}
@@ -0,0 +1,1067 @@
+/*
+ * Contains the tape document, a read-only alternative to a tree of nodes. A
+ * document holds one 64-bit word per token in a single array, written front to
+ * back as the parser reports events, with the text of strings and keys and the
+ * values of numbers kept in buffers beside it. Each word's top byte tags the
+ * token and the rest is its payload:
+ *
+ *   '[' '{'    Index of the container's end word
+ *   ']' '}'    Number of values in the container
+ *   ':' '"'    Offset of a key or string in the string buffer
+ *   'd' 'l'    Index of a double or 64-bit integer in the number buffer
+ *   't' 'f' 'n'
+ *
+ * An object holds a key word before each of its values. Values are named by
+ * their index in the tape. The root value is at index 0, which is never another
+ * value's child or sibling, so the accessors return 0 for "no such value".
+ */
+
+#include <string.h>
+
+#include "cJSON2.h"
+#include "cJSON2_private.h"
+
+#define TAPE_TAG_SHIFT          ( 56 )
+#define TAPE_PAYLOAD_MASK       ( ( (uint64_t)1 << TAPE_TAG_SHIFT ) - 1 )
+#define TAPE_MIN_SIZE           ( 64 )
+
+#define tape_word( tag, payload ) \
+    ( ( (uint64_t)( tag ) << TAPE_TAG_SHIFT ) | (uint64_t)( payload ) )
+
+#define tape_word_tag( word ) \
+    ( (char)( ( word ) >> TAPE_TAG_SHIFT ) )
+
+#define tape_word_payload( word ) \
+    ( (size_t)( ( word ) & TAPE_PAYLOAD_MASK ) )
+
+/****************************************
+Private Types
+****************************************/
+typedef enum
+    {
+    TAPE_TAG_ARRAY      = '[',
+    TAPE_TAG_ARRAY_END  = ']',
+    TAPE_TAG_OBJECT     = '{',
+    TAPE_TAG_OBJECT_END = '}',
+    TAPE_TAG_KEY        = ':',
+    TAPE_TAG_STRING     = '\"',
+    TAPE_TAG_DOUBLE     = 'd',
+    TAPE_TAG_INT64      = 'l',
+    TAPE_TAG_TRUE       = 't',
+    TAPE_TAG_FALSE      = 'f',
+    TAPE_TAG_NULL       = 'n',
+    } tape_tag;
+
+struct cJSON_Document
+    {
+    cJSON_Hooks     hooks;
+    uint64_t *      tape;
+    size_t          tape_len;
+    size_t          tape_size;
+    uint64_t *      numbers;        /* Raw bits of each double or integer   */
+    size_t          numbers_len;
+    size_t          numbers_size;
+    char *          strings;        /* Length, text and terminator of each  */
+    size_t          strings_len;
+    size_t          strings_size;
+    };
+
+typedef struct
+    {
+    size_t start;                   /* Tape index of the container's word   */
+    size_t value_cnt;
+    } open_container;
+
+typedef struct
+    {
+    cJSON_Document *    document;
+    open_container *    open;       /* Containers not closed yet, innermost last */
+    size_t              open_cnt;
+    size_t              open_size;
+    } document_builder;
+
+
+/****************************************
+Private Function Declarations
+****************************************/
+static int build_container_end
+    (
+    document_builder *  builder,
+    tape_tag            tag
+    );
+
+static int build_container_start
+    (
+    document_builder *  builder,
+    tape_tag            tag
+    );
+
+static int build_number
+    (
+    document_builder *  builder,
+    tape_tag            tag,
+    uint64_t            bits
+    );
+
+static int build_text
+    (
+    document_builder *  builder,
+    tape_tag            tag,
+    char const *        text,
+    size_t              text_len
+    );
+
+static int build_word
+    (
+    document_builder *  builder,
+    tape_tag            tag,
+    size_t              payload
+    );
+
+static int on_boolean
+    (
+    void *  builder,
+    int     value
+    );
+
+static int on_end_array
+    (
+    void * builder
+    );
+
+static int on_end_object
+    (
+    void * builder
+    );
+
+static int on_int64
+    (
+    void *  builder,
+    int64_t value
+    );
+
+static int on_key
+    (
+    void *          builder,
+    char const *    key,
+    size_t          key_len
+    );
+
+static int on_null
+    (
+    void * builder
+    );
+
+static int on_number
+    (
+    void *  builder,
+    double  value
+    );
+
+static int on_start_array
+    (
+    void * builder
+    );
+
+static int on_start_object
+    (
+    void * builder
+    );
+
+static int on_string
+    (
+    void *          builder,
+    char const *    value,
+    size_t          value_len
+    );
+
+static char const * text_at
+    (
+    cJSON_Document const *  document,
+    size_t                  index,
+    size_t *                text_len_out
+    );
+
+static size_t value_end
+    (
+    cJSON_Document const *  document,
+    size_t                  value
+    );
+
+
+/****************************************
+Private Variables
+****************************************/
+static cJSON_SaxHandler const document_events =
+    {
+    on_start_object,
+    on_end_object,
+    on_start_array,
+    on_end_array,
+    on_key,
+    on_string,
+    on_number,
+    on_int64,
+    on_boolean,
+    on_null,
+    };
+
+
+/****************************************
+Public Functions
+****************************************/
+
+/**********************************************************
+*	cJSON_DocumentDelete
+*
+*	Frees a document and everything in it.
+*
+**********************************************************/
+void cJSON_DocumentDelete
+    (
+    cJSON_Document * document
+    )
+{
+if( NULL == document )
+    {
+    return;
+    }
+
+if( NULL != document->tape )
+    {
+    document->hooks.free_fn( document->tape );
+    }
+
+if( NULL != document->numbers )
+    {
+    document->hooks.free_fn( document->numbers );
+    }
+
+if( NULL != document->strings )
+    {
+    document->hooks.free_fn( document->strings );
+    }
+
+document->hooks.free_fn( document );
+}
+
+
+/**********************************************************
+*	cJSON_DocumentGetArrayItem
+*
+*	Returns the value at the provided index of an array, or
+*   0 if there is none. Nested containers are stepped over
+*   without being read.
+*
+**********************************************************/
+size_t cJSON_DocumentGetArrayItem
+    (
+    cJSON_Document const *  document,
+    size_t                  array,
+    size_t                  index
+    )
+{
+size_t item;
+
+if( ( NULL == document ) || ( TAPE_TAG_ARRAY != tape_word_tag( document->tape[array] ) ) )
+    {
+    return 0;
+    }
+
+for( item = cJSON_DocumentGetChild( document, array ); ( 0 != item ) && ( 0 != index ); index-- )
+    {
+    item = cJSON_DocumentGetNext( document, item );
+    }
+
+return item;
+}
+
+
+/**********************************************************
+*	cJSON_DocumentGetChild
+*
+*	Returns the first value in an array or object, or 0 if
+*   it is empty or not a container.
+*
+**********************************************************/
+size_t cJSON_DocumentGetChild
+    (
+    cJSON_Document const *  document,
+    size_t                  value
+    )
+{
+char tag;
+
+if( NULL == document )
+    {
+    return 0;
+    }
+
+tag = tape_word_tag( document->tape[value] );
+
+if( ( TAPE_TAG_ARRAY == tag ) && ( TAPE_TAG_ARRAY_END != tape_word_tag( document->tape[value + 1] ) ) )
+    {
+    return value + 1;
+    }
+else if( ( TAPE_TAG_OBJECT == tag ) && ( TAPE_TAG_OBJECT_END != tape_word_tag( document->tape[value + 1] ) ) )
+    {
+    // Step over the first member's key.
+    return value + 2;
+    }
+
+return 0;
+}
+
+
+/**********************************************************
+*	cJSON_DocumentGetInt64
+*
+*	Returns a number's exact value if it was written as an
+*   integer that fits in 64 bits, otherwise returns 0. See
+*   cJSON_DocumentIsInt64().
+*
+**********************************************************/
+int64_t cJSON_DocumentGetInt64
+    (
+    cJSON_Document const *  document,
+    size_t                  value
+    )
+{
+if( !cJSON_DocumentIsInt64( document, value ) )
+    {
+    return 0;
+    }
+
+return (int64_t)document->numbers[tape_word_payload( document->tape[value] )];
+}
+
+
+/**********************************************************
+*	cJSON_DocumentGetKey
+*
+*	Returns the key of an object member's value and its
+*   length, or NULL if the value is not in an object. The
+*   key is null-terminated, but may also hold escaped null
+*   characters.
+*
+**********************************************************/
+char const * cJSON_DocumentGetKey
+    (
+    cJSON_Document const *  document,
+    size_t                  value,
+    size_t *                key_len_out
+    )
+{
+if( ( NULL == document ) || ( 0 == value ) || ( TAPE_TAG_KEY != tape_word_tag( document->tape[value - 1] ) ) )
+    {
+    return NULL;
+    }
+
+return text_at( document, value - 1, key_len_out );
+}
+
+
+/**********************************************************
+*	cJSON_DocumentGetNext
+*
+*	Returns the value following the provided one in its
+*   array or object, or 0 if it is the last one.
+*
+**********************************************************/
+size_t cJSON_DocumentGetNext
+    (
+    cJSON_Document const *  document,
+    size_t                  value
+    )
+{
+size_t  next;
+char    tag;
+
+if( ( NULL == document ) || ( 0 == value ) )
+    {
+    // The root has no siblings.
+    return 0;
+    }
+
+next = value_end( document, value );
+tag  = tape_word_tag( document->tape[next] );
+
+if( TAPE_TAG_KEY == tag )
+    {
+    return next + 1;
+    }
+else if( ( TAPE_TAG_ARRAY_END == tag ) || ( TAPE_TAG_OBJECT_END == tag ) )
+    {
+    return 0;
+    }
+
+return next;
+}
+
+
+/**********************************************************
+*	cJSON_DocumentGetNumber
+*
+*	Returns a number's value, or 0 if the value is not a
+*   number.
+*
+**********************************************************/
+double cJSON_DocumentGetNumber
+    (
+    cJSON_Document const *  document,
+    size_t                  value
+    )
+{
+double  number;
+char    tag;
+
+if( NULL == document )
+    {
+    return 0;
+    }
+
+tag = tape_word_tag( document->tape[value] );
+
+if( TAPE_TAG_INT64 == tag )
+    {
+    return (double)(int64_t)document->numbers[tape_word_payload( document->tape[value] )];
+    }
+else if( TAPE_TAG_DOUBLE == tag )
+    {
+    memcpy( &number, &document->numbers[tape_word_payload( document->tape[value] )], sizeof( number ) );
+    return number;
+    }
+
+return 0;
+}
+
+
+/**********************************************************
+*	cJSON_DocumentGetObjectItem
+*
+*	Returns the value of the first member of an object with
+*   the provided key, or 0 if there is none.
+*
+**********************************************************/
+size_t cJSON_DocumentGetObjectItem
+    (
+    cJSON_Document const *  document,
+    size_t                  object,
+    char const *            key
+    )
+{
+char const *    item_key;
+size_t          item_key_len;
+size_t          key_len;
+size_t          item;
+
+if( ( NULL == document ) || ( NULL == key ) || ( TAPE_TAG_OBJECT != tape_word_tag( document->tape[object] ) ) )
+    {
+    return 0;
+    }
+
+key_len = strlen( key );
+
+for( item = cJSON_DocumentGetChild( document, object ); 0 != item; item = cJSON_DocumentGetNext( document, item ) )
+    {
+    item_key = text_at( document, item - 1, &item_key_len );
+    if( ( key_len == item_key_len ) && ( 0 == memcmp( key, item_key, key_len ) ) )
+        {
+        return item;
+        }
+    }
+
+return 0;
+}
+
+
+/**********************************************************
+*	cJSON_DocumentGetSize
+*
+*	Returns the number of values in an array or object, or
+*   0 if the value is not a container.
+*
+**********************************************************/
+size_t cJSON_DocumentGetSize
+    (
+    cJSON_Document const *  document,
+    size_t                  value
+    )
+{
+char tag;
+
+if( NULL == document )
+    {
+    return 0;
+    }
+
+tag = tape_word_tag( document->tape[value] );
+if( ( TAPE_TAG_ARRAY != tag ) && ( TAPE_TAG_OBJECT != tag ) )
+    {
+    return 0;
+    }
+
+return tape_word_payload( document->tape[tape_word_payload( document->tape[value] )] );
+}
+
+
+/**********************************************************
+*	cJSON_DocumentGetString
+*
+*	Returns a string's decoded text and its length, or NULL
+*   if the value is not a string. The text is null-
+*   terminated, but may also hold escaped null characters.
+*
+**********************************************************/
+char const * cJSON_DocumentGetString
+    (
+    cJSON_Document const *  document,
+    size_t                  value,
+    size_t *                string_len_out
+    )
+{
+if( ( NULL == document ) || ( TAPE_TAG_STRING != tape_word_tag( document->tape[value] ) ) )
+    {
+    return NULL;
+    }
+
+return text_at( document, value, string_len_out );
+}
+
+
+/**********************************************************
+*	cJSON_DocumentGetType
+*
+*	Returns the type of a value, or cJSON_Null if there is
+*   no document.
+*
+**********************************************************/
+cJSON_ValueType cJSON_DocumentGetType
+    (
+    cJSON_Document const *  document,
+    size_t                  value
+    )
+{
+if( NULL == document )
+    {
+    return cJSON_Null;
+    }
+
+switch( tape_word_tag( document->tape[value] ) )
+    {
+    case TAPE_TAG_ARRAY:
+        return cJSON_Array;
+
+    case TAPE_TAG_OBJECT:
+        return cJSON_Object;
+
+    case TAPE_TAG_STRING:
+        return cJSON_String;
+
+    case TAPE_TAG_DOUBLE:
+    case TAPE_TAG_INT64:
+        return cJSON_Number;
+
+    case TAPE_TAG_TRUE:
+        return cJSON_True;
+
+    case TAPE_TAG_FALSE:
+        return cJSON_False;
+
+    default:
+        return cJSON_Null;
+    }
+}
+
+
+/**********************************************************
+*	cJSON_DocumentIsInt64
+*
+*	Returns 1 if a value is a number written as an integer
+*   that fits in 64 bits, whose exact value is returned by
+*   cJSON_DocumentGetInt64(). Otherwise returns 0.
+*
+**********************************************************/
+int cJSON_DocumentIsInt64
+    (
+    cJSON_Document const *  document,
+    size_t                  value
+    )
+{
+return ( NULL != document ) && ( TAPE_TAG_INT64 == tape_word_tag( document->tape[value] ) );
+}
+
+
+/**********************************************************
+*	cJSON_DocumentParse
+*
+*	Parse the first json_len characters of a JSON string
+*   into a document with default hooks.
+*
+**********************************************************/
+cJSON_Document * cJSON_DocumentParse
+    (
+    char const *    json_str,
+    size_t          json_len
+    )
+{
+cJSON_Hooks default_hooks;
+
+default_hooks.malloc_fn  = malloc;
+default_hooks.realloc_fn = realloc;
+default_hooks.free_fn    = free;
+
+return cJSON_DocumentParseWithHooks( json_str, json_len, &default_hooks );
+}
+
+
+/**********************************************************
+*	cJSON_DocumentParseWithHooks
+*
+*	Parse the first json_len characters of a JSON string
+*   into a document allocated with the provided hooks. On
+*   error, this returns NULL. Otherwise, the caller must
+*   free the returned document with cJSON_DocumentDelete().
+*
+**********************************************************/
+cJSON_Document * cJSON_DocumentParseWithHooks
+    (
+    char const *        json_str,
+    size_t              json_len,
+    cJSON_Hooks const * hooks
+    )
+{
+document_builder    builder;
+cJSON_Document *    document;
+int                 is_valid;
+
+if( ( NULL == json_str ) || ( NULL == hooks ) )
+    {
+    return NULL;
+    }
+
+document = (cJSON_Document*)hooks->malloc_fn( sizeof( *document ) );
+if( NULL == document )
+    {
+    return NULL;
+    }
+
+memset( document, 0, sizeof( *document ) );
+document->hooks = *hooks;
+
+// Most tokens take a few characters of input, so size the tape from the
+// input up front to avoid growing it more than a couple of times.
+memset( &builder, 0, sizeof( builder ) );
+builder.document = document;
+
+is_valid = buffer_reserve( hooks, (void**)&document->tape, &document->tape_size, ( json_len / 4 + TAPE_MIN_SIZE ) * sizeof( *document->tape ) );
+is_valid = ( is_valid ) && ( sax_parse( json_str, json_len, &document_events, &builder, hooks ) );
+
+if( NULL != builder.open )
+    {
+    hooks->free_fn( builder.open );
+    }
+
+if( !is_valid )
+    {
+    cJSON_DocumentDelete( document );
+    return NULL;
+    }
+
+return document;
+}
+
+
+/****************************************
+Private Functions
+****************************************/
+
+/**********************************************************
+*	build_container_end
+*
+*	Closes the innermost open container, recording its
+*   value count in its end word and the end word's index in
+*   its start word.
+*
+**********************************************************/
+static int build_container_end
+    (
+    document_builder *  builder,
+    tape_tag            tag
+    )
+{
+open_container * container;
+
+container = &builder->open[--builder->open_cnt];
+
+builder->document->tape[container->start] |= builder->document->tape_len;
+
+return build_word( builder, tag, container->value_cnt );
+}
+
+
+/**********************************************************
+*	build_container_start
+*
+*	Adds an array or object's start word to the tape and
+*   opens it. Its payload is filled in once it's closed.
+*
+**********************************************************/
+static int build_container_start
+    (
+    document_builder *  builder,
+    tape_tag            tag
+    )
+{
+void *  open;
+size_t  start;
+
+open  = builder->open;
+start = builder->document->tape_len;
+
+if( !buffer_reserve( &builder->document->hooks, &open, &builder->open_size, ( builder->open_cnt + 1 ) * sizeof( *builder->open ) ) )
+    {
+    return 0;
+    }
+
+// The stack may have moved, and build_word() counts the new container in
+// its parent's entry.
+builder->open = (open_container*)open;
+if( !build_word( builder, tag, 0 ) )
+    {
+    return 0;
+    }
+
+builder->open[builder->open_cnt].start     = start;
+builder->open[builder->open_cnt].value_cnt = 0;
+builder->open_cnt++;
+
+return 1;
+}
+
+
+/**********************************************************
+*	build_number
+*
+*	Adds a number to the number buffer and its word to the
+*   tape.
+*
+**********************************************************/
+static int build_number
+    (
+    document_builder *  builder,
+    tape_tag            tag,
+    uint64_t            bits
+    )
+{
+cJSON_Document *    document;
+void *              numbers;
+
+document = builder->document;
+numbers  = document->numbers;
+
+if( !buffer_reserve( &document->hooks, &numbers, &document->numbers_size, ( document->numbers_len + 1 ) * sizeof( *document->numbers ) ) )
+    {
+    return 0;
+    }
+
+document->numbers = (uint64_t*)numbers;
+document->numbers[document->numbers_len] = bits;
+
+return build_word( builder, tag, document->numbers_len++ );
+}
+
+
+/**********************************************************
+*	build_text
+*
+*	Adds a key or string to the string buffer, as its length
+*   followed by its text and a null terminator, and its word
+*   to the tape.
+*
+**********************************************************/
+static int build_text
+    (
+    document_builder *  builder,
+    tape_tag            tag,
+    char const *        text,
+    size_t              text_len
+    )
+{
+cJSON_Document *    document;
+void *              strings;
+uint32_t            stored_len;
+size_t              offset;
+
+document = builder->document;
+strings  = document->strings;
+offset   = document->strings_len;
+
+stored_len = (uint32_t)text_len;
+if( ( stored_len != text_len )
+ || ( !buffer_reserve( &document->hooks, &strings, &document->strings_size, offset + sizeof( stored_len ) + text_len + 1 ) ) )
+    {
+    return 0;
+    }
+
+document->strings = (char*)strings;
+memcpy( &document->strings[offset], &stored_len, sizeof( stored_len ) );
+memcpy( &document->strings[offset + sizeof( stored_len )], text, text_len );
+document->strings[offset + sizeof( stored_len ) + text_len] = '\0';
+document->strings_len = offset + sizeof( stored_len ) + text_len + 1;
+
+return build_word( builder, tag, offset );
+}
+
+
+/**********************************************************
+*	build_word
+*
+*	Adds a word to the end of the tape. Words that start a
+*   value are counted toward the innermost open container.
+*
+**********************************************************/
+static int build_word
+    (
+    document_builder *  builder,
+    tape_tag            tag,
+    size_t              payload
+    )
+{
+cJSON_Document *    document;
+void *              tape;
+
+document = builder->document;
+tape     = document->tape;
+
+if( !buffer_reserve( &document->hooks, &tape, &document->tape_size, ( document->tape_len + 1 ) * sizeof( *document->tape ) ) )
+    {
+    return 0;
+    }
+
+if( ( 0 != builder->open_cnt ) && ( TAPE_TAG_KEY != tag ) && ( TAPE_TAG_ARRAY_END != tag ) && ( TAPE_TAG_OBJECT_END != tag ) )
+    {
+    builder->open[builder->open_cnt - 1].value_cnt++;
+    }
+
+document->tape = (uint64_t*)tape;
+document->tape[document->tape_len++] = tape_word( tag, payload );
+
+return 1;
+}
+
+
+/**********************************************************
+*	on_boolean
+*
+*	Adds a true or false word to the tape.
+*
+**********************************************************/
+static int on_boolean
+    (
+    void *  builder,
+    int     value
+    )
+{
+return build_word( (document_builder*)builder, ( value ) ? TAPE_TAG_TRUE : TAPE_TAG_FALSE, 0 );
+}
+
+
+/**********************************************************
+*	on_end_array
+*
+*	Closes an array.
+*
+**********************************************************/
+static int on_end_array
+    (
+    void * builder
+    )
+{
+return build_container_end( (document_builder*)builder, TAPE_TAG_ARRAY_END );
+}
+
+
+/**********************************************************
+*	on_end_object
+*
+*	Closes an object.
+*
+**********************************************************/
+static int on_end_object
+    (
+    void * builder
+    )
+{
+return build_container_end( (document_builder*)builder, TAPE_TAG_OBJECT_END );
+}
+
+
+/**********************************************************
+*	on_int64
+*
+*	Adds an integer to the tape.
+*
+**********************************************************/
+static int on_int64
+    (
+    void *  builder,
+    int64_t value
+    )
+{
+return build_number( (document_builder*)builder, TAPE_TAG_INT64, (uint64_t)value );
+}
+
+
+/**********************************************************
+*	on_key
+*
+*	Adds an object key to the tape.
+*
+**********************************************************/
+static int on_key
+    (
+    void *          builder,
+    char const *    key,
+    size_t          key_len
+    )
+{
+return build_text( (document_builder*)builder, TAPE_TAG_KEY, key, key_len );
+}
+
+
+/**********************************************************
+*	on_null
+*
+*	Adds a null word to the tape.
+*
+**********************************************************/
+static int on_null
+    (
+    void * builder
+    )
+{
+return build_word( (document_builder*)builder, TAPE_TAG_NULL, 0 );
+}
+
+
+/**********************************************************
+*	on_number
+*
+*	Adds a double to the tape.
+*
+**********************************************************/
+static int on_number
+    (
+    void *  builder,
+    double  value
+    )
+{
+uint64_t bits;
+
+memcpy( &bits, &value, sizeof( bits ) );
+
+return build_number( (document_builder*)builder, TAPE_TAG_DOUBLE, bits );
+}
+
+
+/**********************************************************
+*	on_start_array
+*
+*	Opens an array.
+*
+**********************************************************/
+static int on_start_array
+    (
+    void * builder
+    )
+{
+return build_container_start( (document_builder*)builder, TAPE_TAG_ARRAY );
+}
+
+
+/**********************************************************
+*	on_start_object
+*
+*	Opens an object.
+*
+**********************************************************/
+static int on_start_object
+    (
+    void * builder
+    )
+{
+return build_container_start( (document_builder*)builder, TAPE_TAG_OBJECT );
+}
+
+
+/**********************************************************
+*	on_string
+*
+*	Adds a string to the tape.
+*
+**********************************************************/
+static int on_string
+    (
+    void *          builder,
+    char const *    value,
+    size_t          value_len
+    )
+{
+return build_text( (document_builder*)builder, TAPE_TAG_STRING, value, value_len );
+}
+
+
+/**********************************************************
+*	text_at
+*
+*	Returns the text of the key or string word at the
+*   provided index, and its length.
+*
+**********************************************************/
+static char const * text_at
+    (
+    cJSON_Document const *  document,
+    size_t                  index,
+    size_t *                text_len_out
+    )
+{
+char const *    stored;
+uint32_t        stored_len;
+
+stored = &document->strings[tape_word_payload( document->tape[index] )];
+memcpy( &stored_len, stored, sizeof( stored_len ) );
+
+if( NULL != text_len_out )
+    {
+    *text_len_out = stored_len;
+    }
+
+return &stored[sizeof( stored_len )];
+}
+
+
+/**********************************************************
+*	value_end
+*
+*	Returns the index just past a value, stepping over the
+*   whole of a container.
+*
+**********************************************************/
+static size_t value_end
+    (
+    cJSON_Document const *  document,
+    size_t                  value
+    )
+{
+char tag;
+
+tag = tape_word_tag( document->tape[value] );
+
+if( ( TAPE_TAG_ARRAY == tag ) || ( TAPE_TAG_OBJECT == tag ) )
+    {
+    return tape_word_payload( document->tape[value] ) + 1;
+    }
+
+return value + 1;
+}
@@ -0,0 +1,103 @@
+/*
+ * Contains the file parser, which maps a file into memory and parses it where
+ * it lies instead of reading it into a buffer first.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "cJSON2.h"
+
+
+/****************************************
+Public Functions
+****************************************/
+
+/**********************************************************
+*	cJSON_ParseFile
+*
+*	Parse a JSON file with default hooks and the provided
+*   cJSON_ParseFlag options.
+*
+**********************************************************/
+cJSON * cJSON_ParseFile
+    (
+    char const *    path,
+    unsigned int    flags
+    )
+{
+cJSON_Hooks default_hooks;
+
+default_hooks.malloc_fn  = malloc;
+default_hooks.realloc_fn = realloc;
+default_hooks.free_fn    = free;
+
+return cJSON_ParseFileWithHooks( path, flags, &default_hooks );
+}
+
+
+/**********************************************************
+*	cJSON_ParseFileWithHooks
+*
+*	Parse a regular JSON file with the provided hooks and
+*   cJSON_ParseFlag options. The file is mapped read-only
+*   and parsed without copying it, and the mapping is gone
+*   again by the time this returns. On error, this returns
+*   NULL. Otherwise, the caller must free the returned
+*   pointer with cJSON_DeleteWithHooks().
+*
+**********************************************************/
+cJSON * cJSON_ParseFileWithHooks
+    (
+    char const *        path,
+    unsigned int        flags,
+    cJSON_Hooks const * hooks
+    )
+{
+struct stat file_stat;
+size_t      file_len;
+void *      file_map;
+cJSON *     root;
+int         fd;
+
+if( NULL == path )
+    {
+    return NULL;
+    }
+
+fd = open( path, O_RDONLY | O_CLOEXEC );
+if( fd < 0 )
+    {
+    return NULL;
+    }
+
+// Only regular files have a size to map, and an empty one isn't valid JSON.
+if( ( 0 != fstat( fd, &file_stat ) ) || ( !S_ISREG( file_stat.st_mode ) ) || ( file_stat.st_size <= 0 ) )
+    {
+    close( fd );
+    return NULL;
+    }
+
+file_len = (size_t)file_stat.st_size;
+file_map = mmap( NULL, file_len, PROT_READ, MAP_PRIVATE, fd, 0 );
+
+// The mapping holds its own reference to the file.
+close( fd );
+
+if( MAP_FAILED == file_map )
+    {
+    return NULL;
+    }
+
+// The parser reads front to back, so let the kernel read ahead aggressively
+// and drop pages behind us.
+(void)madvise( file_map, file_len, MADV_SEQUENTIAL );
+
+root = cJSON_ParseWithFlags( (char const *)file_map, file_len, flags, hooks );
+
+munmap( file_map, file_len );
+
+return root;
+}
@@ -0,0 +1,333 @@
+/*
+ * Contains the first stage of the structural index parse mode. It classifies
+ * 64 bytes of input at a time into bit masks and records the offset of every
+ * structural character, quote and scalar value in the whole document, so that
+ * the second stage can step from token to token without examining the bytes
+ * between them.
+ */
+
+#include <string.h>
+
+#include "cJSON2_private.h"
+
+#define INDEX_BLOCK_SIZE        ( 64 )
+
+/*
+ * Blocks are classified a vector lane at a time. Each lane_* macro operates on
+ * the lane of characters loaded into chars.
+ */
+#if defined( __AVX2__ )
+    #include <immintrin.h>
+    #define INDEX_LANE_SIZE     ( 32 )
+    #define lane_load( _p )     _mm256_loadu_si256( (__m256i const *)(_p) )
+    #define lane_eq( _c )       _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( _c ) )
+    #define lane_or( _a, _b )   _mm256_or_si256( _a, _b )
+    #define lane_control()      _mm256_cmpeq_epi8( _mm256_max_epu8( chars, _mm256_set1_epi8( 0x1F ) ), _mm256_set1_epi8( 0x1F ) )
+    #define lane_mask( _cmp )   ( (uint64_t)(uint32_t)_mm256_movemask_epi8( _cmp ) )
+    typedef __m256i lane;
+#elif defined( __SSE2__ )
+    #include <emmintrin.h>
+    #define INDEX_LANE_SIZE     ( 16 )
+    #define lane_load( _p )     _mm_loadu_si128( (__m128i const *)(_p) )
+    #define lane_eq( _c )       _mm_cmpeq_epi8( chars, _mm_set1_epi8( _c ) )
+    #define lane_or( _a, _b )   _mm_or_si128( _a, _b )
+    #define lane_control()      _mm_cmpeq_epi8( _mm_max_epu8( chars, _mm_set1_epi8( 0x1F ) ), _mm_set1_epi8( 0x1F ) )
+    #define lane_mask( _cmp )   ( (uint64_t)(uint32_t)_mm_movemask_epi8( _cmp ) )
+    typedef __m128i lane;
+#endif
+
+/****************************************
+Private Types
+****************************************/
+typedef struct
+    {
+    uint64_t    backslash;
+    uint64_t    quote;
+    uint64_t    structural;     /* { } [ ] : ,                          */
+    uint64_t    whitespace;
+    uint64_t    control;        /* Below 0x20, including whitespace     */
+    } block_masks;
+
+
+/****************************************
+Private Function Declarations
+****************************************/
+static void block_classify
+    (
+    char const *    block,
+    block_masks *   masks_out
+    );
+
+static uint64_t escaped_chars
+    (
+    uint64_t    backslash,
+    uint64_t *  prev_escaped
+    );
+
+static int lowest_set_bit
+    (
+    uint64_t mask
+    );
+
+static uint64_t prefix_xor
+    (
+    uint64_t mask
+    );
+
+
+/**********************************************************
+*	structural_index_build
+*
+*	Records the offset of every structural character, every
+*   unescaped quote and the first character of every other
+*   value in the first json_len characters of the JSON
+*   string. index_out must have room for json_len + 1
+*   entries. Returns the number of entries, or -1 if a
+*   string contains a control character.
+*
+**********************************************************/
+long structural_index_build
+    (
+    char const *    json_str,
+    size_t          json_len,
+    uint32_t *      index_out
+    )
+{
+block_masks     masks;
+char            tail[INDEX_BLOCK_SIZE];
+char const *    block;
+size_t          block_posn;
+size_t          index_cnt;
+uint64_t        prev_escaped;
+uint64_t        prev_in_string;
+uint64_t        prev_separator;
+uint64_t        quote;
+uint64_t        in_string;
+uint64_t        separator;
+uint64_t        scalar_start;
+uint64_t        tokens;
+
+index_cnt      = 0;
+prev_escaped   = 0;
+prev_in_string = 0;
+prev_separator = 1;
+
+for( block_posn = 0; block_posn < json_len; block_posn += INDEX_BLOCK_SIZE )
+    {
+    if( json_len - block_posn >= INDEX_BLOCK_SIZE )
+        {
+        block = &json_str[block_posn];
+        }
+    else
+        {
+        // Pad the last partial block with whitespace so that it classifies
+        // like the end of the document.
+        memset( tail, ' ', sizeof( tail ) );
+        memcpy( tail, &json_str[block_posn], json_len - block_posn );
+        block = tail;
+        }
+
+    block_classify( block, &masks );
+
+    // Strings run from an unescaped quote up to, but not including, the next.
+    quote          = masks.quote & ~escaped_chars( masks.backslash, &prev_escaped );
+    in_string      = prefix_xor( quote ) ^ prev_in_string;
+    prev_in_string = (uint64_t)( (int64_t)in_string >> 63 );
+
+    if( 0 != ( masks.control & in_string & ~quote ) )
+        {
+        return -1;
+        }
+
+    // Any other value starts with the first character after a separator. A
+    // closing quote counts as one so that a value glued onto the end of a
+    // string is still seen, and rejected, by the second stage.
+    separator      = masks.structural | masks.whitespace | quote;
+    scalar_start   = ~separator & ( ( separator << 1 ) | prev_separator );
+    prev_separator = separator >> 63;
+
+    tokens = ( ( masks.structural | scalar_start ) & ~in_string ) | quote;
+
+    while( 0 != tokens )
+        {
+        index_out[index_cnt++] = (uint32_t)( block_posn + lowest_set_bit( tokens ) );
+        tokens &= tokens - 1;
+        }
+    }
+
+return (long)index_cnt;
+}
+
+
+/**********************************************************
+*	block_classify
+*
+*	Builds masks with bit i set if byte i of the 64-byte
+*   block belongs to each class of character.
+*
+**********************************************************/
+static void block_classify
+    (
+    char const *    block,
+    block_masks *   masks_out
+    )
+{
+#if defined( INDEX_LANE_SIZE )
+int     i;
+lane    chars;
+
+memset( masks_out, 0, sizeof( *masks_out ) );
+
+for( i = 0; i < INDEX_BLOCK_SIZE; i += INDEX_LANE_SIZE )
+    {
+    chars = lane_load( &block[i] );
+
+    masks_out->backslash  |= lane_mask( lane_eq( '\\' ) ) << i;
+    masks_out->quote      |= lane_mask( lane_eq( '\"' ) ) << i;
+    masks_out->structural |= lane_mask( lane_or( lane_or( lane_or( lane_eq( '{' ), lane_eq( '}' ) ), lane_or( lane_eq( '[' ), lane_eq( ']' ) ) ),
+                                                 lane_or( lane_eq( ':' ), lane_eq( ',' ) ) ) ) << i;
+    masks_out->whitespace |= lane_mask( lane_or( lane_or( lane_eq( ' ' ), lane_eq( '\n' ) ), lane_or( lane_eq( '\r' ), lane_eq( '\t' ) ) ) ) << i;
+    masks_out->control    |= lane_mask( lane_control() ) << i;
+    }
+#else
+int         i;
+uint64_t    bit;
+
+memset( masks_out, 0, sizeof( *masks_out ) );
+
+for( i = 0; i < INDEX_BLOCK_SIZE; i++ )
+    {
+    bit = (uint64_t)1 << i;
+
+    switch( block[i] )
+        {
+        case '\\':
+            masks_out->backslash |= bit;
+            break;
+
+        case '\"':
+            masks_out->quote |= bit;
+            break;
+
+        case '{':
+        case '}':
+        case '[':
+        case ']':
+        case ':':
+        case ',':
+            masks_out->structural |= bit;
+            break;
+
+        case ' ':
+        case '\n':
+        case '\r':
+        case '\t':
+            masks_out->whitespace |= bit;
+            break;
+
+        default:
+            break;
+        }
+
+    if( (unsigned char)block[i] < 0x20 )
+        {
+        masks_out->control |= bit;
+        }
+    }
+#endif
+}
+
+
+/**********************************************************
+*	escaped_chars
+*
+*	Returns a mask of the characters in a block that are
+*   escaped by a backslash. prev_escaped carries whether the
+*   first character of the block is escaped by a backslash
+*   at the end of the previous one.
+*
+**********************************************************/
+static uint64_t escaped_chars
+    (
+    uint64_t    backslash,
+    uint64_t *  prev_escaped
+    )
+{
+uint64_t    escaped;
+int         bit;
+
+escaped = *prev_escaped;
+
+// An escaped backslash doesn't escape the character after it.
+backslash    &= ~*prev_escaped;
+*prev_escaped = 0;
+
+// Backslashes are rare, so step through them one at a time.
+while( 0 != backslash )
+    {
+    bit = lowest_set_bit( backslash );
+
+    if( 63 == bit )
+        {
+        *prev_escaped = 1;
+        backslash     = 0;
+        }
+    else
+        {
+        escaped   |= (uint64_t)1 << ( bit + 1 );
+        backslash &= ~( (uint64_t)3 << bit );
+        }
+    }
+
+return escaped;
+}
+
+
+/**********************************************************
+*	lowest_set_bit
+*
+*	Returns the index of the lowest set bit in a non-zero
+*   mask.
+*
+**********************************************************/
+static int lowest_set_bit
+    (
+    uint64_t mask
+    )
+{
+#if defined( __GNUC__ )
+return __builtin_ctzll( mask );
+#else
+int idx;
+
+for( idx = 0; 0 == ( mask & 1 ); idx++ )
+    {
+    mask >>= 1;
+    }
+
+return idx;
+#endif
+}
+
+
+/**********************************************************
+*	prefix_xor
+*
+*	Returns a mask with bit i set to the exclusive or of
+*   bits 0 through i of the provided mask.
+*
+**********************************************************/
+static uint64_t prefix_xor
+    (
+    uint64_t mask
+    )
+{
+mask ^= mask << 1;
+mask ^= mask << 2;
+mask ^= mask << 4;
+mask ^= mask << 8;
+mask ^= mask << 16;
+mask ^= mask << 32;
+
+return mask;
+}
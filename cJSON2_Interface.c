@@ -5,6 +5,21 @@
 #include <string.h>
 
 #include "cJSON2.h"
+#include "cJSON2_private.h"
+
+/****************************************
+Private Function Declarations
+****************************************/
+static void item_unlink
+    (
+    cJSON * container,
+    cJSON * item
+    );
+
+
+/****************************************
+Public Functions
+****************************************/
 
 /**********************************************************
 *	cJSON_Delete
@@ -26,11 +41,48 @@ cJSON_DeleteWithHooks( json, &default_hooks );
 }
 
 
+/**********************************************************
+*	cJSON_DeleteItemFromArray
+*
+*	Removes the item at the provided index from an array and
+*   frees it with default hooks. Does nothing if there is no
+*   such item.
+*
+**********************************************************/
+void cJSON_DeleteItemFromArray
+    (
+    cJSON * json_array,
+    int     index
+    )
+{
+cJSON_Delete( cJSON_DetachItemFromArray( json_array, index ) );
+}
+
+
+/**********************************************************
+*	cJSON_DeleteItemFromObject
+*
+*	Removes the first item with the provided key from an
+*   object and frees it with default hooks. Does nothing if
+*   there is no such item.
+*
+**********************************************************/
+void cJSON_DeleteItemFromObject
+    (
+    cJSON *         json_object,
+    char const *    key
+    )
+{
+cJSON_Delete( cJSON_DetachItemFromObject( json_object, key ) );
+}
+
+
 /**********************************************************
 *	cJSON_DeleteWithHooks
 *
 *	Clean up resources owned by a cJSON object using the
-*   provided hooks.
+*   provided hooks. Trees parsed into an arena are owned by
+*   the arena, so this leaves them alone.
 *
 **********************************************************/
 void cJSON_DeleteWithHooks
@@ -42,13 +94,21 @@ void cJSON_DeleteWithHooks
 cJSON * crnt_node;
 cJSON * next_node;
 
+if( ( NULL != json ) && ( json->flags & cJSON_InArena ) )
+    {
+    return;
+    }
+
 crnt_node = json;
 
 while( NULL != crnt_node )
     {
-    // First delete all of a node's children before deleting the node
+    // First delete all of a node's children before deleting the node. An
+    // index goes before the children, so that the space its chunks held
+    // merges with theirs as they are freed instead of splitting it up.
     if( NULL != crnt_node->child )
         {
+        container_index_free( crnt_node, hooks );
         next_node = crnt_node->child;
         }
     else
@@ -71,9 +131,33 @@ while( NULL != crnt_node )
                 }
             }
 
-        // Safe to completely free the whole node now.
-        hooks->free_fn( crnt_node->string );
-        hooks->free_fn( crnt_node->valuestring );
+        // Safe to completely free the whole node now. Strings parsed in situ
+        // live in the caller's buffer, short strings live in the node itself,
+        // interned keys are shared with other nodes, and the text of a lazy
+        // container lives in the record it was copied into. The valuestring
+        // of an indexed container is its index.
+        if( crnt_node->flags & cJSON_KeyInterned )
+            {
+            interned_key_release( crnt_node->string, hooks );
+            }
+        else if( !( crnt_node->flags & ( cJSON_StringsReferenced | cJSON_KeyInline ) ) )
+            {
+            hooks->free_fn( crnt_node->string );
+            }
+
+        if( crnt_node->flags & cJSON_IsLazy )
+            {
+            hooks->free_fn( lazy_container_from_node( crnt_node ) );
+            }
+        else if( crnt_node->flags & cJSON_IsIndexed )
+            {
+            container_index_free( crnt_node, hooks );
+            }
+        else if( !( crnt_node->flags & ( cJSON_StringsReferenced | cJSON_ValueInline ) ) )
+            {
+            hooks->free_fn( crnt_node->valuestring );
+            }
+
         hooks->free_fn( crnt_node );
         }
 
@@ -82,6 +166,74 @@ while( NULL != crnt_node )
 }
 
 
+/**********************************************************
+*	cJSON_DetachItemFromArray
+*
+*	Removes the item at the provided index from an array and
+*   returns it, or NULL if there is no such item. The caller
+*   must free the returned item the same way as the tree it
+*   came from.
+*
+**********************************************************/
+cJSON * cJSON_DetachItemFromArray
+    (
+    cJSON * json_array,
+    int     index
+    )
+{
+cJSON * item;
+
+item = cJSON_GetArrayItem( json_array, index );
+if( NULL == item )
+    {
+    return NULL;
+    }
+
+item_unlink( json_array, item );
+
+if( json_array->flags & cJSON_IsIndexed )
+    {
+    array_index_remove( json_array, (size_t)index );
+    }
+
+return item;
+}
+
+
+/**********************************************************
+*	cJSON_DetachItemFromObject
+*
+*	Removes the first item with the provided key from an
+*   object and returns it, or NULL if there is no such item.
+*   The caller must free the returned item the same way as
+*   the tree it came from.
+*
+**********************************************************/
+cJSON * cJSON_DetachItemFromObject
+    (
+    cJSON *         json_object,
+    char const *    key
+    )
+{
+cJSON * item;
+
+item = cJSON_GetObjectItem( json_object, key );
+if( NULL == item )
+    {
+    return NULL;
+    }
+
+item_unlink( json_object, item );
+
+if( json_object->flags & cJSON_IsIndexed )
+    {
+    object_index_remove( json_object, item );
+    }
+
+return item;
+}
+
+
 /**********************************************************
 *	cJSON_GetArrayItem
 *
@@ -114,6 +266,18 @@ else if ( cJSON_Array != json_array->type )
     {
     return NULL;
     }
+else if( ( json_array->flags & cJSON_IsLazy ) && ( !lazy_container_materialize( (cJSON*)json_array ) ) )
+    {
+    return NULL;
+    }
+else if( index >= json_array->valueint )
+    {
+    return NULL;
+    }
+else if( json_array->flags & cJSON_IsIndexed )
+    {
+    return array_index_item( array_index_from_node( json_array ), (size_t)index );
+    }
 
 node = json_array->child;
 while( ( NULL != node ) && ( crnt_idx < index ) )
@@ -144,11 +308,6 @@ int cJSON_GetArraySize
     cJSON const *   json_array
     )
 {
-int     size;
-cJSON * crnt_node;
-
-size = 0;
-
 if( NULL == json_array )
     {
     return -1;
@@ -157,16 +316,12 @@ else if( cJSON_Array != json_array->type )
     {
     return -1;
     }
-
-crnt_node = json_array->child;
-
-while( NULL != crnt_node )
+else if( ( json_array->flags & cJSON_IsLazy ) && ( !lazy_container_materialize( (cJSON*)json_array ) ) )
     {
-    size++;
-    crnt_node = crnt_node->next;
+    return -1;
     }
 
-return size;
+return json_array->valueint;
 }
 
 
@@ -201,11 +356,21 @@ else if( NULL == key )
     {
     return NULL;
     }
+else if( ( json_object->flags & cJSON_IsLazy ) && ( !lazy_container_materialize( (cJSON*)json_object ) ) )
+    {
+    return NULL;
+    }
+else if( json_object->flags & cJSON_IsIndexed )
+    {
+    return object_index_find( json_object, key, key_hash( key, strlen( key ) ) );
+    }
 
 crnt_item = json_object->child;
 while( ( NULL != crnt_item ) && ( NULL == found_item ) )
     {
-    if( 0 == strcmp( key, crnt_item->string ) )
+    // Interned keys are often looked up with the same pointer they were
+    // found with, so try that before comparing characters.
+    if( ( key == crnt_item->string ) || ( 0 == strcmp( key, crnt_item->string ) ) )
         {
         found_item = crnt_item;
         }
@@ -233,4 +398,43 @@ int cJSON_ObjectHasItem
     )
 {
 return ( NULL != cJSON_GetObjectItem( json_object, key ) );
-}
\ No newline at end of file
+}
+
+
+/****************************************
+Private Functions
+****************************************/
+
+/**********************************************************
+*	item_unlink
+*
+*	Takes an item out of its container's list of children
+*   and count.
+*
+**********************************************************/
+static void item_unlink
+    (
+    cJSON * container,
+    cJSON * item
+    )
+{
+if( NULL != item->prev )
+    {
+    item->prev->next = item->next;
+    }
+else
+    {
+    container->child = item->next;
+    }
+
+if( NULL != item->next )
+    {
+    item->next->prev = item->prev;
+    }
+
+container->valueint--;
+
+item->prev   = NULL;
+item->next   = NULL;
+item->parent = NULL;
+}
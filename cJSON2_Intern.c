@@ -0,0 +1,221 @@
+/*
+ * Contains the key table used to intern object keys while parsing, so that
+ * every occurrence of a key in a document shares a single copy of it.
+ */
+
+#include <string.h>
+
+#include "cJSON2.h"
+#include "cJSON2_private.h"
+
+#define KEY_TABLE_MIN_SIZE      ( 64 )
+
+/****************************************
+Private Function Declarations
+****************************************/
+static int key_table_grow
+    (
+    key_table *         table,
+    cJSON_Hooks const * hooks
+    );
+
+
+/**********************************************************
+*	interned_key_release
+*
+*	Drops a node's reference to an interned key, freeing the
+*   key once no node refers to it.
+*
+**********************************************************/
+void interned_key_release
+    (
+    char *              key,
+    cJSON_Hooks const * hooks
+    )
+{
+interned_key * record;
+
+record = interned_key_from_string( key );
+
+record->ref_cnt--;
+if( 0 == record->ref_cnt )
+    {
+    hooks->free_fn( record );
+    }
+}
+
+
+/**********************************************************
+*	key_hash
+*
+*	Hashes a key with FNV-1a.
+*
+**********************************************************/
+uint32_t key_hash
+    (
+    char const *    key,
+    size_t          key_len
+    )
+{
+uint32_t    hash;
+size_t      i;
+
+hash = 2166136261u;
+for( i = 0; i < key_len; i++ )
+    {
+    hash ^= (unsigned char)key[i];
+    hash *= 16777619u;
+    }
+
+return hash;
+}
+
+
+/**********************************************************
+*	key_table_clear
+*
+*	Forgets every key in the table but keeps its memory.
+*
+**********************************************************/
+void key_table_clear
+    (
+    key_table * table
+    )
+{
+if( 0 != table->cnt )
+    {
+    memset( table->entries, 0, table->size * sizeof( *table->entries ) );
+    table->cnt = 0;
+    }
+}
+
+
+/**********************************************************
+*	key_table_free
+*
+*	Releases the table's memory. The interned keys are owned
+*   by the nodes that refer to them and are left alone.
+*
+**********************************************************/
+void key_table_free
+    (
+    key_table *         table,
+    cJSON_Hooks const * hooks
+    )
+{
+if( NULL != table->entries )
+    {
+    hooks->free_fn( table->entries );
+    }
+
+table->entries = NULL;
+table->size    = 0;
+table->cnt     = 0;
+}
+
+
+/**********************************************************
+*	key_table_intern
+*
+*	Returns the table's copy of a key, adding one carved out
+*   of the arena, or allocated with the hooks if the arena
+*   is NULL, the first time the key is seen. Each key that
+*   is not in an arena counts the nodes that refer to it.
+*   Returns NULL if memory runs out.
+*
+**********************************************************/
+char * key_table_intern
+    (
+    key_table *         table,
+    cJSON_Hooks const * hooks,
+    cJSON_Arena *       arena,
+    char const *        key,
+    size_t              key_len
+    )
+{
+interned_key *  record;
+size_t          slot;
+size_t          record_size;
+
+// Keep the table at most half full so that probe sequences stay short.
+if( ( 2 * ( table->cnt + 1 ) > table->size ) && ( !key_table_grow( table, hooks ) ) )
+    {
+    return NULL;
+    }
+
+for( slot = key_hash( key, key_len ) & ( table->size - 1 ); NULL != table->entries[slot]; slot = ( slot + 1 ) & ( table->size - 1 ) )
+    {
+    record = table->entries[slot];
+    if( ( key_len == record->len ) && ( 0 == memcmp( key, record->text, key_len ) ) )
+        {
+        record->ref_cnt++;
+        return record->text;
+        }
+    }
+
+record_size = offsetof( interned_key, text ) + key_len + 1;
+record      = (interned_key*)( ( NULL != arena ) ? arena_alloc( arena, record_size ) : hooks->malloc_fn( record_size ) );
+if( NULL == record )
+    {
+    return NULL;
+    }
+
+record->ref_cnt = 1;
+record->len     = key_len;
+memcpy( record->text, key, key_len );
+record->text[key_len] = '\0';
+
+table->entries[slot] = record;
+table->cnt++;
+
+return record->text;
+}
+
+
+/**********************************************************
+*	key_table_grow
+*
+*	Doubles the number of slots in the table and rehashes
+*   its keys. Returns 0 if memory runs out.
+*
+**********************************************************/
+static int key_table_grow
+    (
+    key_table *         table,
+    cJSON_Hooks const * hooks
+    )
+{
+interned_key ** new_entries;
+size_t          new_size;
+size_t          slot;
+size_t          i;
+
+new_size    = ( 0 == table->size ) ? KEY_TABLE_MIN_SIZE : 2 * table->size;
+new_entries = (interned_key**)hooks->malloc_fn( new_size * sizeof( *new_entries ) );
+if( NULL == new_entries )
+    {
+    return 0;
+    }
+
+memset( new_entries, 0, new_size * sizeof( *new_entries ) );
+
+for( i = 0; i < table->size; i++ )
+    {
+    if( NULL != table->entries[i] )
+        {
+        for( slot = key_hash( table->entries[i]->text, table->entries[i]->len ) & ( new_size - 1 ); NULL != new_entries[slot]; slot = ( slot + 1 ) & ( new_size - 1 ) )
+            ;
+        new_entries[slot] = table->entries[i];
+        }
+    }
+
+if( NULL != table->entries )
+    {
+    hooks->free_fn( table->entries );
+    }
+
+table->entries = new_entries;
+table->size    = new_size;
+
+return 1;
+}
@@ -0,0 +1,499 @@
+/*
+ * Contains the indexes that large containers keep of their children, so that
+ * finding one doesn't have to walk every child before it. Objects keep a hash
+ * index holding the first member with each key, which is the one a walk would
+ * find. Arrays keep a list of their items in order, which the parser grows
+ * as it adds items so that large arrays are never walked to build it. Both are
+ * kept up to date as children are detached.
+ */
+
+#include <string.h>
+
+#include "cJSON2.h"
+#include "cJSON2_private.h"
+
+/****************************************
+Private Function Declarations
+****************************************/
+static int array_index_create
+    (
+    cJSON *             array,
+    cJSON_Hooks const * hooks,
+    cJSON_Arena *       arena
+    );
+
+static cJSON ** array_index_slot
+    (
+    cJSON *             array,
+    size_t              index,
+    cJSON_Hooks const * hooks,
+    cJSON_Arena *       arena
+    );
+
+static int object_index_create
+    (
+    cJSON *             object,
+    cJSON_Hooks const * hooks,
+    cJSON_Arena *       arena
+    );
+
+static size_t object_index_home
+    (
+    object_index const *    index,
+    char const *            key
+    );
+
+static void object_index_insert
+    (
+    object_index *  index,
+    cJSON *         item
+    );
+
+
+/**********************************************************
+*	array_index_append
+*
+*	Adds the item just linked as the last child of an array,
+*   and counted in its valueint, to the array's index. The
+*   index is created from all of the array's items if it
+*   has none yet. Returns 0 if memory runs out.
+*
+**********************************************************/
+int array_index_append
+    (
+    cJSON *             array,
+    cJSON *             item,
+    cJSON_Hooks const * hooks,
+    cJSON_Arena *       arena
+    )
+{
+cJSON ** slot;
+
+if( !( array->flags & cJSON_IsIndexed ) )
+    {
+    return array_index_create( array, hooks, arena );
+    }
+
+slot = array_index_slot( array, (size_t)array->valueint - 1, hooks, arena );
+if( NULL == slot )
+    {
+    return 0;
+    }
+
+*slot = item;
+
+return 1;
+}
+
+
+/**********************************************************
+*	array_index_remove
+*
+*	Drops the item that was at the provided position of an
+*   indexed array, after it was unlinked.
+*
+**********************************************************/
+void array_index_remove
+    (
+    cJSON * array,
+    size_t  index
+    )
+{
+array_index *   items;
+size_t          i;
+
+items = array_index_from_node( array );
+for( i = index; i < (size_t)array->valueint; i++ )
+    {
+    array_index_item( items, i ) = array_index_item( items, i + 1 );
+    }
+}
+
+
+/**********************************************************
+*	container_index_build
+*
+*	Indexes the children of an array with at least
+*   CJSON_ARRAY_INDEX_THRESHOLD items, or of an object with
+*   at least CJSON_OBJECT_INDEX_THRESHOLD members, as
+*   counted by its valueint. The index is carved out of the
+*   arena, or allocated with the hooks if the arena is NULL.
+*   Smaller containers, and those already indexed, are left
+*   alone. Returns 0 if memory runs out.
+*
+**********************************************************/
+int container_index_build
+    (
+    cJSON *             container,
+    cJSON_Hooks const * hooks,
+    cJSON_Arena *       arena
+    )
+{
+if( container->flags & cJSON_IsIndexed )
+    {
+    return 1;
+    }
+else if( cJSON_Array == container->type )
+    {
+    return ( container->valueint < CJSON_ARRAY_INDEX_THRESHOLD ) || ( array_index_create( container, hooks, arena ) );
+    }
+
+return ( container->valueint < CJSON_OBJECT_INDEX_THRESHOLD ) || ( object_index_create( container, hooks, arena ) );
+}
+
+
+/**********************************************************
+*	container_index_free
+*
+*	Discards a container's index, if it has one.
+*
+**********************************************************/
+void container_index_free
+    (
+    cJSON *             container,
+    cJSON_Hooks const * hooks
+    )
+{
+array_index *   items;
+size_t          i;
+
+if( !( container->flags & cJSON_IsIndexed ) )
+    {
+    return;
+    }
+
+if( !( container->flags & cJSON_InArena ) )
+    {
+    if( cJSON_Array == container->type )
+        {
+        items = array_index_from_node( container );
+        for( i = 0; ( i < items->size ) && ( NULL != items->chunks[i] ); i++ )
+            {
+            hooks->free_fn( items->chunks[i] );
+            }
+        }
+
+    hooks->free_fn( container->valuestring );
+    }
+
+container->valuestring = NULL;
+container->flags      &= ~cJSON_IsIndexed;
+}
+
+
+/**********************************************************
+*	object_index_find
+*
+*	Returns the first member of an indexed object with the
+*   provided key, whose key_hash() is hash, or NULL if there
+*   is none.
+*
+**********************************************************/
+cJSON * object_index_find
+    (
+    cJSON const *   object,
+    char const *    key,
+    uint32_t        hash
+    )
+{
+object_index const *    index;
+cJSON *                 item;
+size_t                  slot;
+
+index = object_index_from_node( object );
+
+for( slot = hash & ( index->size - 1 ); NULL != index->entries[slot]; slot = ( slot + 1 ) & ( index->size - 1 ) )
+    {
+    // Interned keys are often looked up with the same pointer they were
+    // found with, so try that before comparing characters.
+    item = index->entries[slot];
+    if( ( key == item->string ) || ( 0 == strcmp( key, item->string ) ) )
+        {
+        return item;
+        }
+    }
+
+return NULL;
+}
+
+
+/**********************************************************
+*	object_index_remove
+*
+*	Drops a member that was just unlinked from an indexed
+*   object. If another member has the same key, the first
+*   one left takes its place.
+*
+**********************************************************/
+void object_index_remove
+    (
+    cJSON * object,
+    cJSON * item
+    )
+{
+object_index *  index;
+cJSON *         other;
+size_t          slot;
+size_t          next_slot;
+size_t          home;
+size_t          mask;
+
+index = object_index_from_node( object );
+mask  = index->size - 1;
+
+for( slot = object_index_home( index, item->string ); item != index->entries[slot]; slot = ( slot + 1 ) & mask )
+    {
+    if( NULL == index->entries[slot] )
+        {
+        // A later member with a key already indexed.
+        return;
+        }
+    }
+
+// Close the gap by moving back each entry after it in the probe run that
+// would otherwise no longer be reachable from its home slot.
+for( ;; )
+    {
+    index->entries[slot] = NULL;
+
+    for( next_slot = ( slot + 1 ) & mask; NULL != index->entries[next_slot]; next_slot = ( next_slot + 1 ) & mask )
+        {
+        home = object_index_home( index, index->entries[next_slot]->string );
+        if( ( ( next_slot - home ) & mask ) >= ( ( next_slot - slot ) & mask ) )
+            {
+            break;
+            }
+        }
+
+    if( NULL == index->entries[next_slot] )
+        {
+        break;
+        }
+
+    index->entries[slot] = index->entries[next_slot];
+    slot                 = next_slot;
+    }
+
+if( index->has_duplicates )
+    {
+    for( other = object->child; NULL != other; other = other->next )
+        {
+        if( 0 == strcmp( item->string, other->string ) )
+            {
+            object_index_insert( index, other );
+            break;
+            }
+        }
+    }
+}
+
+
+/**********************************************************
+*	array_index_create
+*
+*	Gives an array an index of its items. Returns 0 if
+*   memory runs out.
+*
+**********************************************************/
+static int array_index_create
+    (
+    cJSON *             array,
+    cJSON_Hooks const * hooks,
+    cJSON_Arena *       arena
+    )
+{
+array_index *   items;
+cJSON **        slot;
+cJSON *         item;
+size_t          index_size;
+size_t          size;
+size_t          i;
+
+// Leave room for the array to grow to twice its size.
+size       = 2 * ( (size_t)array->valueint / ARRAY_INDEX_CHUNK_SIZE + 1 );
+index_size = offsetof( array_index, chunks ) + size * sizeof( items->chunks[0] );
+items      = (array_index*)( ( NULL != arena ) ? arena_alloc( arena, index_size ) : hooks->malloc_fn( index_size ) );
+if( NULL == items )
+    {
+    return 0;
+    }
+
+memset( items, 0, index_size );
+items->size = size;
+
+array->valuestring = (char*)(void*)items;
+array->flags      |= cJSON_IsIndexed;
+
+for( item = array->child, i = 0; NULL != item; item = item->next, i++ )
+    {
+    slot = array_index_slot( array, i, hooks, arena );
+    if( NULL == slot )
+        {
+        container_index_free( array, hooks );
+        return 0;
+        }
+
+    *slot = item;
+    }
+
+return 1;
+}
+
+
+/**********************************************************
+*	array_index_slot
+*
+*	Returns where an indexed array keeps the item at the
+*   provided position, adding a chunk, and growing the list
+*   of chunks, if it isn't there yet. Returns NULL if memory
+*   runs out.
+*
+**********************************************************/
+static cJSON ** array_index_slot
+    (
+    cJSON *             array,
+    size_t              index,
+    cJSON_Hooks const * hooks,
+    cJSON_Arena *       arena
+    )
+{
+array_index *   items;
+array_index *   new_items;
+size_t          chunk;
+size_t          old_size;
+size_t          new_size;
+
+items = array_index_from_node( array );
+chunk = index / ARRAY_INDEX_CHUNK_SIZE;
+
+if( chunk >= items->size )
+    {
+    old_size = offsetof( array_index, chunks ) + items->size * sizeof( items->chunks[0] );
+    new_size = offsetof( array_index, chunks ) + 2 * items->size * sizeof( items->chunks[0] );
+
+    // Arenas can't resize, so the old list is left to the arena.
+    if( NULL != arena )
+        {
+        new_items = (array_index*)arena_alloc( arena, new_size );
+        if( NULL != new_items )
+            {
+            memcpy( new_items, items, old_size );
+            }
+        }
+    else
+        {
+        new_items = (array_index*)hooks->realloc_fn( items, new_size );
+        }
+
+    if( NULL == new_items )
+        {
+        return NULL;
+        }
+
+    memset( (char*)new_items + old_size, 0, new_size - old_size );
+    new_items->size   *= 2;
+    array->valuestring = (char*)(void*)new_items;
+    items              = new_items;
+    }
+
+if( NULL == items->chunks[chunk] )
+    {
+    items->chunks[chunk] = (cJSON**)( ( NULL != arena ) ? arena_alloc( arena, ARRAY_INDEX_CHUNK_SIZE * sizeof( cJSON* ) )
+                                                        : hooks->malloc_fn( ARRAY_INDEX_CHUNK_SIZE * sizeof( cJSON* ) ) );
+    if( NULL == items->chunks[chunk] )
+        {
+        return NULL;
+        }
+    }
+
+return &items->chunks[chunk][index % ARRAY_INDEX_CHUNK_SIZE];
+}
+
+
+/**********************************************************
+*	object_index_create
+*
+*	Gives an object a hash index of its keys. Returns 0 if
+*   memory runs out.
+*
+**********************************************************/
+static int object_index_create
+    (
+    cJSON *             object,
+    cJSON_Hooks const * hooks,
+    cJSON_Arena *       arena
+    )
+{
+object_index *  index;
+cJSON *         item;
+size_t          index_size;
+size_t          size;
+
+// Keep the index at most half full so that probe sequences stay short.
+for( size = 1; size < 2 * (size_t)object->valueint; size *= 2 )
+    ;
+
+index_size = offsetof( object_index, entries ) + size * sizeof( index->entries[0] );
+index      = (object_index*)( ( NULL != arena ) ? arena_alloc( arena, index_size ) : hooks->malloc_fn( index_size ) );
+if( NULL == index )
+    {
+    return 0;
+    }
+
+memset( index, 0, index_size );
+index->size = size;
+
+for( item = object->child; NULL != item; item = item->next )
+    {
+    object_index_insert( index, item );
+    }
+
+object->valuestring = (char*)(void*)index;
+object->flags      |= cJSON_IsIndexed;
+
+return 1;
+}
+
+
+/**********************************************************
+*	object_index_home
+*
+*	Returns the slot where the search for a key starts.
+*
+**********************************************************/
+static size_t object_index_home
+    (
+    object_index const *    index,
+    char const *            key
+    )
+{
+return key_hash( key, strlen( key ) ) & ( index->size - 1 );
+}
+
+
+/**********************************************************
+*	object_index_insert
+*
+*	Adds a member to the index unless a member with the same
+*   key is already there.
+*
+**********************************************************/
+static void object_index_insert
+    (
+    object_index *  index,
+    cJSON *         item
+    )
+{
+size_t slot;
+
+for( slot = object_index_home( index, item->string ); NULL != index->entries[slot]; slot = ( slot + 1 ) & ( index->size - 1 ) )
+    {
+    if( 0 == strcmp( item->string, index->entries[slot]->string ) )
+        {
+        index->has_duplicates = 1;
+        return;
+        }
+    }
+
+index->entries[slot] = item;
+}
@@ -0,0 +1,472 @@
+/*
+ * Contains the parser for newline-delimited JSON (NDJSON), which splits its
+ * input into batches of whole records and parses the batches on a pool of
+ * worker threads.
+ */
+
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "cJSON2.h"
+#include "cJSON2_private.h"
+
+#define NDJSON_BATCHES_PER_THREAD   ( 8 )
+#define NDJSON_BATCHES_AHEAD        ( 4 )
+#define NDJSON_MIN_BATCH_SIZE       ( 64 * 1024 )
+
+/****************************************
+Private Types
+****************************************/
+typedef struct
+    {
+    cJSON *     json;
+    size_t      offset;
+    } ndjson_record;
+
+typedef struct
+    {
+    char const *    start;
+    char const *    end;
+    ndjson_record * records;        /* Parsed records awaiting delivery     */
+    size_t          record_cnt;
+    size_t          record_size;
+    int             had_error;
+    int             is_done;
+    } ndjson_batch;
+
+typedef struct
+    {
+    char const *        ndjson_str;
+    int                 in_order;
+    cJSON_RecordHandler handler;
+    void *              user_data;
+    cJSON_Hooks         hooks;
+    ndjson_batch *      batches;
+    size_t              batch_cnt;
+    size_t              next_batch;     /* Next batch for a worker to take  */
+    size_t              batch_limit;    /* Workers may not take this batch  */
+    size_t              batches_ahead;  /* How far past delivery to parse   */
+    int                 is_stopped;     /* Handler asked to stop            */
+    pthread_mutex_t     lock;
+    pthread_cond_t      batch_done;
+    pthread_cond_t      batch_delivered;
+    } ndjson_job;
+
+
+/****************************************
+Private Function Declarations
+****************************************/
+static void ndjson_batch_deliver
+    (
+    ndjson_job *    job,
+    ndjson_batch *  batch
+    );
+
+static void ndjson_batch_parse
+    (
+    ndjson_job *    job,
+    ndjson_batch *  batch
+    );
+
+static int ndjson_batches_split
+    (
+    ndjson_job *    job,
+    size_t          ndjson_len,
+    size_t          thread_cnt
+    );
+
+static int ndjson_record_is_blank
+    (
+    char const *    record,
+    char const *    record_end
+    );
+
+static void * ndjson_worker
+    (
+    void * job_ptr
+    );
+
+
+/****************************************
+Public Functions
+****************************************/
+
+/**********************************************************
+*	cJSON_ParseNDJSON
+*
+*	Parses the first ndjson_len characters of a string of
+*   newline-delimited JSON records on thread_cnt threads, or
+*   one per CPU if thread_cnt is 0. Each record is passed to
+*   the handler, which is never called from more than one
+*   thread at a time. If in_order is set, records are
+*   delivered in the order they appear; otherwise they are
+*   delivered as soon as they are parsed. Blank lines are
+*   skipped. Returns 1 if every record was valid and the
+*   handler never asked to stop, otherwise returns 0.
+*
+**********************************************************/
+int cJSON_ParseNDJSON
+    (
+    char const *        ndjson_str,
+    size_t              ndjson_len,
+    unsigned int        thread_cnt,
+    int                 in_order,
+    cJSON_RecordHandler handler,
+    void *              user_data
+    )
+{
+ndjson_job  job;
+pthread_t * threads;
+size_t      threads_started;
+size_t      i;
+int         had_error;
+
+if( ( NULL == ndjson_str ) || ( NULL == handler ) )
+    {
+    return 0;
+    }
+
+if( 0 == thread_cnt )
+    {
+    thread_cnt = ( sysconf( _SC_NPROCESSORS_ONLN ) > 0 ) ? (unsigned int)sysconf( _SC_NPROCESSORS_ONLN ) : 1;
+    }
+
+memset( &job, 0, sizeof( job ) );
+job.ndjson_str       = ndjson_str;
+job.in_order         = in_order;
+job.handler          = handler;
+job.user_data        = user_data;
+job.hooks.malloc_fn  = malloc;
+job.hooks.realloc_fn = realloc;
+job.hooks.free_fn    = free;
+
+if( !ndjson_batches_split( &job, ndjson_len, thread_cnt ) )
+    {
+    return 0;
+    }
+
+// When records are delivered in order, keep the workers from getting too far
+// ahead of delivery so that the parsed records waiting for it stay bounded.
+job.batches_ahead = ( in_order ) ? NDJSON_BATCHES_AHEAD * thread_cnt : job.batch_cnt;
+job.batch_limit   = job.batches_ahead;
+
+pthread_mutex_init( &job.lock, NULL );
+pthread_cond_init( &job.batch_done, NULL );
+pthread_cond_init( &job.batch_delivered, NULL );
+
+// Never start more threads than there are batches to parse. If no thread
+// could be started, the calling thread does all of the parsing itself.
+threads         = (pthread_t*)malloc( thread_cnt * sizeof( *threads ) );
+threads_started = 0;
+
+while( ( NULL != threads ) && ( threads_started < thread_cnt ) && ( threads_started < job.batch_cnt ) && ( thread_cnt > 1 ) )
+    {
+    if( 0 != pthread_create( &threads[threads_started], NULL, ndjson_worker, &job ) )
+        {
+        break;
+        }
+    threads_started++;
+    }
+
+if( 0 == threads_started )
+    {
+    // A single thread parses the records in order, so it can hand them over
+    // as it goes.
+    job.in_order    = 0;
+    job.batch_limit = job.batch_cnt;
+    ndjson_worker( &job );
+    }
+else if( in_order )
+    {
+    // Hand over each batch's records as soon as the batch is finished,
+    // while the workers move on to later batches.
+    for( i = 0; i < job.batch_cnt; i++ )
+        {
+        pthread_mutex_lock( &job.lock );
+        while( !job.batches[i].is_done )
+            {
+            pthread_cond_wait( &job.batch_done, &job.lock );
+            }
+        pthread_mutex_unlock( &job.lock );
+
+        ndjson_batch_deliver( &job, &job.batches[i] );
+
+        pthread_mutex_lock( &job.lock );
+        job.batch_limit = i + 1 + job.batches_ahead;
+        pthread_cond_broadcast( &job.batch_delivered );
+        pthread_mutex_unlock( &job.lock );
+        }
+    }
+
+for( i = 0; i < threads_started; i++ )
+    {
+    pthread_join( threads[i], NULL );
+    }
+
+had_error = 0;
+for( i = 0; i < job.batch_cnt; i++ )
+    {
+    had_error |= job.batches[i].had_error;
+    }
+
+pthread_cond_destroy( &job.batch_delivered );
+pthread_cond_destroy( &job.batch_done );
+pthread_mutex_destroy( &job.lock );
+free( threads );
+free( job.batches );
+
+return ( !had_error ) && ( !job.is_stopped );
+}
+
+
+/****************************************
+Private Functions
+****************************************/
+
+/**********************************************************
+*	ndjson_batch_deliver
+*
+*	Passes a finished batch's records to the handler in
+*   order, or frees them once the handler has asked to stop.
+*
+**********************************************************/
+static void ndjson_batch_deliver
+    (
+    ndjson_job *    job,
+    ndjson_batch *  batch
+    )
+{
+size_t i;
+
+for( i = 0; i < batch->record_cnt; i++ )
+    {
+    if( job->is_stopped )
+        {
+        cJSON_Delete( batch->records[i].json );
+        }
+    else if( !job->handler( job->user_data, batch->records[i].offset, batch->records[i].json ) )
+        {
+        pthread_mutex_lock( &job->lock );
+        job->is_stopped = 1;
+        pthread_mutex_unlock( &job->lock );
+        }
+    }
+
+free( batch->records );
+batch->records    = NULL;
+batch->record_cnt = 0;
+}
+
+
+/**********************************************************
+*	ndjson_batch_parse
+*
+*	Parses each record in a batch. Records are either kept
+*   for in-order delivery or handed straight to the handler.
+*
+**********************************************************/
+static void ndjson_batch_parse
+    (
+    ndjson_job *    job,
+    ndjson_batch *  batch
+    )
+{
+char const *    record;
+char const *    record_end;
+cJSON *         json;
+ndjson_record * new_records;
+size_t          new_size;
+int             is_stopped;
+
+for( record = batch->start; record < batch->end; record = record_end + 1 )
+    {
+    record_end = (char const *)memchr( record, '\n', batch->end - record );
+    if( NULL == record_end )
+        {
+        record_end = batch->end;
+        }
+
+    if( ndjson_record_is_blank( record, record_end ) )
+        {
+        continue;
+        }
+
+    json = cJSON_ParseWithLength( record, record_end - record, &job->hooks );
+    if( NULL == json )
+        {
+        batch->had_error = 1;
+        }
+
+    if( !job->in_order )
+        {
+        pthread_mutex_lock( &job->lock );
+        if( job->is_stopped )
+            {
+            cJSON_Delete( json );
+            }
+        else if( !job->handler( job->user_data, record - job->ndjson_str, json ) )
+            {
+            job->is_stopped = 1;
+            }
+        is_stopped = job->is_stopped;
+        pthread_mutex_unlock( &job->lock );
+
+        if( is_stopped )
+            {
+            break;
+            }
+        continue;
+        }
+
+    if( batch->record_cnt == batch->record_size )
+        {
+        new_size    = ( 0 == batch->record_size ) ? 64 : 2 * batch->record_size;
+        new_records = (ndjson_record*)realloc( batch->records, new_size * sizeof( *new_records ) );
+        if( NULL == new_records )
+            {
+            cJSON_Delete( json );
+            batch->had_error = 1;
+            break;
+            }
+
+        batch->records     = new_records;
+        batch->record_size = new_size;
+        }
+
+    batch->records[batch->record_cnt].json   = json;
+    batch->records[batch->record_cnt].offset = record - job->ndjson_str;
+    batch->record_cnt++;
+    }
+}
+
+
+/**********************************************************
+*	ndjson_batches_split
+*
+*	Splits the input into batches that each end just after a
+*   newline, several per thread so that the threads stay
+*   busy when records vary in size. Returns 0 if memory runs
+*   out.
+*
+**********************************************************/
+static int ndjson_batches_split
+    (
+    ndjson_job *    job,
+    size_t          ndjson_len,
+    size_t          thread_cnt
+    )
+{
+char const *    ndjson_end;
+char const *    batch_start;
+char const *    batch_end;
+size_t          batch_size;
+size_t          max_batch_cnt;
+
+batch_size = ndjson_len / ( thread_cnt * NDJSON_BATCHES_PER_THREAD );
+if( batch_size < NDJSON_MIN_BATCH_SIZE )
+    {
+    batch_size = NDJSON_MIN_BATCH_SIZE;
+    }
+
+max_batch_cnt = ndjson_len / batch_size + 1;
+job->batches  = (ndjson_batch*)calloc( max_batch_cnt, sizeof( *job->batches ) );
+if( NULL == job->batches )
+    {
+    return 0;
+    }
+
+ndjson_end = job->ndjson_str + ndjson_len;
+
+for( batch_start = job->ndjson_str; batch_start < ndjson_end; batch_start = batch_end )
+    {
+    if( (size_t)( ndjson_end - batch_start ) <= batch_size )
+        {
+        batch_end = ndjson_end;
+        }
+    else
+        {
+        // Extend the batch to the end of the record it would otherwise split.
+        batch_end = (char const *)memchr( batch_start + batch_size, '\n', ndjson_end - ( batch_start + batch_size ) );
+        batch_end = ( NULL == batch_end ) ? ndjson_end : batch_end + 1;
+        }
+
+    job->batches[job->batch_cnt].start = batch_start;
+    job->batches[job->batch_cnt].end   = batch_end;
+    job->batch_cnt++;
+    }
+
+return 1;
+}
+
+
+/**********************************************************
+*	ndjson_record_is_blank
+*
+*	Returns 1 if a record contains only whitespace.
+*
+**********************************************************/
+static int ndjson_record_is_blank
+    (
+    char const *    record,
+    char const *    record_end
+    )
+{
+while( ( record < record_end ) && ( is_json_whitespace( *record ) ) )
+    {
+    record++;
+    }
+
+return ( record == record_end );
+}
+
+
+/**********************************************************
+*	ndjson_worker
+*
+*	Takes batches from the job and parses them until there
+*   are none left, waiting whenever it gets too far ahead of
+*   in-order delivery.
+*
+**********************************************************/
+static void * ndjson_worker
+    (
+    void * job_ptr
+    )
+{
+ndjson_job *    job;
+ndjson_batch *  batch;
+int             is_stopped;
+
+job = (ndjson_job*)job_ptr;
+
+for( ;; )
+    {
+    pthread_mutex_lock( &job->lock );
+    while( ( job->next_batch < job->batch_cnt ) && ( job->next_batch >= job->batch_limit ) )
+        {
+        pthread_cond_wait( &job->batch_delivered, &job->lock );
+        }
+
+    batch      = ( job->next_batch < job->batch_cnt ) ? &job->batches[job->next_batch++] : NULL;
+    is_stopped = job->is_stopped;
+    pthread_mutex_unlock( &job->lock );
+
+    if( NULL == batch )
+        {
+        break;
+        }
+
+    if( !is_stopped )
+        {
+        ndjson_batch_parse( job, batch );
+        }
+
+    pthread_mutex_lock( &job->lock );
+    batch->is_done = 1;
+    pthread_cond_broadcast( &job->batch_done );
+    pthread_mutex_unlock( &job->lock );
+    }
+
+return NULL;
+}
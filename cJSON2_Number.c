@@ -0,0 +1,584 @@
+/*
+ * Contains the JSON number parser and printer. The parser enforces the JSON
+ * number grammar and converts numbers without strtod() whenever the result
+ * can be computed exactly, which covers the vast majority of numbers found in
+ * practice. Integers that fit in 64 bits are kept exactly.
+ */
+
+#include <float.h>
+#include <locale.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "cJSON2_private.h"
+
+#define MAX_EXACT_MANTISSA      ( (uint64_t)1 << 53 )
+#define MAX_INT64_MAGNITUDE     ( (uint64_t)1 << 63 )
+#define MAX_EXPONENT_MAGNITUDE  ( 100000 )
+#define MAX_FAST_EXPONENT       ( 22 )
+#define MAX_MANTISSA_DIGITS     ( 19 )
+#define NUMBER_BUFFER_SIZE      ( 64 )
+
+#define is_digit( _c ) ( ( (_c) >= '0' ) && ( (_c) <= '9' ) )
+
+/*
+ * Eight digits can be validated and converted at once by treating them as a
+ * single 64-bit word, which requires knowing the byte order.
+ */
+#if defined( __BYTE_ORDER__ ) && ( __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__ )
+    #define NUMBER_SWAR
+#endif
+
+/*
+ * The fast path relies on every double operation being rounded exactly once,
+ * which is not the case when intermediates are kept in extended precision.
+ */
+#if defined( FLT_EVAL_METHOD ) && ( 0 == FLT_EVAL_METHOD )
+    #define NUMBER_FAST_PATH
+#endif
+
+/****************************************
+Private Types
+****************************************/
+typedef struct
+    {
+    char const *    start;              /* First character of the number        */
+    uint64_t        mantissa;           /* Up to MAX_MANTISSA_DIGITS digits     */
+    int             mantissa_digits;
+    int             exponent;           /* Power of ten to scale mantissa by    */
+    int             is_negative;
+    int             is_integer;         /* No fraction or exponent              */
+    int             is_truncated;       /* Non-zero digits did not fit          */
+    } number_parts;
+
+
+/****************************************
+Private Function Declarations
+****************************************/
+static char const * digits_accumulate
+    (
+    char const *    str,
+    char const *    str_end,
+    number_parts *  parts,
+    int             is_fraction
+    );
+
+#if defined( NUMBER_SWAR )
+static int eight_digits_are_valid
+    (
+    uint64_t chunk
+    );
+
+static uint32_t eight_digits_value
+    (
+    uint64_t chunk
+    );
+#endif
+
+static int number_slow_path
+    (
+    number_parts const *    parts,
+    char const *            number_end,
+    cJSON_Hooks const *     hooks,
+    cJSON_Arena *           arena,
+    double *                value_out
+    );
+
+static int uint64_print
+    (
+    uint64_t    value,
+    char *      buffer
+    );
+
+
+/****************************************
+Private Variables
+****************************************/
+static char const digit_pairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+#if defined( NUMBER_FAST_PATH )
+static const double powers_of_ten[] =
+    {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,
+    1e8,  1e9,  1e10, 1e11, 1e12, 1e13, 1e14, 1e15,
+    1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+#endif
+
+
+/**********************************************************
+*	number_parse
+*
+*	Parses the JSON number at the start of the provided
+*   string, reading no further than str_end. Returns a
+*   pointer to the first character after the number and
+*   stores its value in value_out. Integers that fit in 64
+*   bits are stored exactly without any floating point
+*   conversion. Returns NULL if the characters do not form a
+*   JSON number or if the number overflows or underflows a
+*   double. Numbers too long to convert on the stack are
+*   copied into the arena, or with the hooks if the arena is
+*   NULL, and NULL is returned if that memory runs out.
+*
+**********************************************************/
+char const * number_parse
+    (
+    char const *        str,
+    char const *        str_end,
+    cJSON_Hooks const * hooks,
+    cJSON_Arena *       arena,
+    number_value *      value_out
+    )
+{
+number_parts    parts;
+char const *    crnt;
+int             exponent;
+int             is_exponent_negative;
+double          value;
+
+memset( &parts, 0, sizeof( parts ) );
+parts.start      = str;
+parts.is_integer = 1;
+crnt             = str;
+
+// -?
+if( ( crnt < str_end ) && ( '-' == *crnt ) )
+    {
+    parts.is_negative = 1;
+    crnt++;
+    }
+
+// 0 | [1-9][0-9]*
+if( ( crnt >= str_end ) || ( !is_digit( *crnt ) ) )
+    {
+    return NULL;
+    }
+else if( '0' == *crnt )
+    {
+    // Leading zeros are not allowed, so whatever follows is not part of the number.
+    crnt++;
+    }
+else
+    {
+    crnt = digits_accumulate( crnt, str_end, &parts, 0 );
+    }
+
+// ( \.[0-9]+ )?
+if( ( crnt < str_end ) && ( '.' == *crnt ) )
+    {
+    parts.is_integer = 0;
+    crnt++;
+    if( ( crnt >= str_end ) || ( !is_digit( *crnt ) ) )
+        {
+        return NULL;
+        }
+
+    crnt = digits_accumulate( crnt, str_end, &parts, 1 );
+    }
+
+// ( [eE][+-]?[0-9]+ )?
+if( ( crnt < str_end ) && ( ( 'e' == *crnt ) || ( 'E' == *crnt ) ) )
+    {
+    parts.is_integer = 0;
+    crnt++;
+    is_exponent_negative = 0;
+    if( ( crnt < str_end ) && ( ( '+' == *crnt ) || ( '-' == *crnt ) ) )
+        {
+        is_exponent_negative = ( '-' == *crnt );
+        crnt++;
+        }
+
+    if( ( crnt >= str_end ) || ( !is_digit( *crnt ) ) )
+        {
+        return NULL;
+        }
+
+    for( exponent = 0; ( crnt < str_end ) && ( is_digit( *crnt ) ); crnt++ )
+        {
+        // Anything this large over- or underflows regardless of the mantissa.
+        if( exponent < MAX_EXPONENT_MAGNITUDE )
+            {
+            exponent = ( 10 * exponent ) + ( *crnt - '0' );
+            }
+        }
+
+    parts.exponent += ( is_exponent_negative ) ? -exponent : exponent;
+    }
+
+if( ( parts.is_integer ) && ( !parts.is_truncated ) && ( 0 == parts.exponent )
+ && ( parts.mantissa <= MAX_INT64_MAGNITUDE - ( parts.is_negative ? 0 : 1 ) )
+ && ( !( ( parts.is_negative ) && ( 0 == parts.mantissa ) ) ) )
+    {
+    // Integer fast path: the value is kept exactly and never goes through
+    // floating point parsing. "-0" is left to the double path, which keeps its
+    // sign.
+    value_out->is_int64    = 1;
+    value_out->valueint64  = ( parts.is_negative ) ? -(int64_t)( parts.mantissa - 1 ) - 1 : (int64_t)parts.mantissa;
+    value_out->valuedouble = (double)value_out->valueint64;
+    return crnt;
+    }
+
+if( 0 == parts.mantissa )
+    {
+    value = 0.0;
+    }
+#if defined( NUMBER_FAST_PATH )
+else if( ( !parts.is_truncated ) && ( parts.mantissa <= MAX_EXACT_MANTISSA ) && ( 0 == parts.exponent ) )
+    {
+    // Integers that fit in the mantissa of a double convert exactly.
+    value = (double)parts.mantissa;
+    }
+else if( ( !parts.is_truncated ) && ( parts.mantissa <= MAX_EXACT_MANTISSA )
+      && ( parts.exponent >= -MAX_FAST_EXPONENT ) && ( parts.exponent <= MAX_FAST_EXPONENT ) )
+    {
+    // Both the mantissa and the power of ten are exact doubles, so a single
+    // correctly rounded multiply or divide gives the correctly rounded result.
+    if( parts.exponent < 0 )
+        {
+        value = (double)parts.mantissa / powers_of_ten[-parts.exponent];
+        }
+    else
+        {
+        value = (double)parts.mantissa * powers_of_ten[parts.exponent];
+        }
+    }
+#endif
+else if( !number_slow_path( &parts, crnt, hooks, arena, &value ) )
+    {
+    return NULL;
+    }
+
+if( isinf( value ) )
+    {
+    // Overflow
+    return NULL;
+    }
+else if( ( 0.0 == value ) && ( 0 != parts.mantissa ) )
+    {
+    // Underflow
+    return NULL;
+    }
+
+value_out->is_int64    = 0;
+value_out->valueint64  = 0;
+value_out->valuedouble = ( parts.is_negative ) ? -value : value;
+
+return crnt;
+}
+
+
+/**********************************************************
+*	number_print
+*
+*	Prints a number into the provided buffer, which must be
+*   able to hold at least NUMBER_PRINT_SIZE characters.
+*   Exact integers are printed with a dedicated integer
+*   formatter. Doubles are printed with the fewest digits
+*   that read back as the same value. Returns the number of
+*   characters written, not including the null-terminator,
+*   or -1 on error.
+*
+**********************************************************/
+int number_print
+    (
+    number_value const *    value,
+    char *                  buffer,
+    size_t                  buffer_len
+    )
+{
+int     length;
+int     i;
+char    decimal_point;
+
+if( buffer_len < NUMBER_PRINT_SIZE )
+    {
+    return -1;
+    }
+
+if( value->is_int64 )
+    {
+    if( value->valueint64 < 0 )
+        {
+        buffer[0] = '-';
+        return 1 + uint64_print( (uint64_t)0 - (uint64_t)value->valueint64, &buffer[1] );
+        }
+
+    return uint64_print( (uint64_t)value->valueint64, buffer );
+    }
+
+// The parser accepts these extensions, so print them the same way.
+if( isnan( value->valuedouble ) )
+    {
+    memcpy( buffer, "NaN", 4 );
+    return 3;
+    }
+else if( isinf( value->valuedouble ) )
+    {
+    length = ( value->valuedouble < 0 ) ? 9 : 8;
+    memcpy( buffer, ( value->valuedouble < 0 ) ? "-Infinity" : "Infinity", length + 1 );
+    return length;
+    }
+
+// Try 15 significant digits first since it avoids printing noise such as
+// 0.10000000000000001, and fall back on 17 which always round trips.
+length = snprintf( buffer, buffer_len, "%.15g", value->valuedouble );
+if( ( length > 0 ) && ( strtod( buffer, NULL ) != value->valuedouble ) )
+    {
+    length = snprintf( buffer, buffer_len, "%.17g", value->valuedouble );
+    }
+
+if( ( length < 0 ) || ( (size_t)length >= buffer_len ) )
+    {
+    return -1;
+    }
+
+// snprintf() uses the locale's decimal point, but JSON always uses '.'.
+decimal_point = localeconv()->decimal_point[0];
+for( i = 0; ( '.' != decimal_point ) && ( i < length ); i++ )
+    {
+    if( decimal_point == buffer[i] )
+        {
+        buffer[i] = '.';
+        }
+    }
+
+return length;
+}
+
+
+/**********************************************************
+*	digits_accumulate
+*
+*	Accumulates a run of digits into the provided number's
+*   mantissa, adjusting its exponent for digits that are
+*   dropped from the integer part or kept from the fraction.
+*   Returns a pointer to the first non-digit.
+*
+**********************************************************/
+static char const * digits_accumulate
+    (
+    char const *    str,
+    char const *    str_end,
+    number_parts *  parts,
+    int             is_fraction
+    )
+{
+int digit;
+
+#if defined( NUMBER_SWAR )
+uint64_t chunk;
+#endif
+
+while( ( str < str_end ) && ( is_digit( *str ) ) )
+    {
+#if defined( NUMBER_SWAR )
+    // Take eight digits at a time while they still fit in the mantissa. Leading
+    // zeros are left to the loop below, which doesn't count them.
+    if( ( str_end - str >= 8 ) && ( 0 != parts->mantissa ) && ( parts->mantissa_digits + 8 <= MAX_MANTISSA_DIGITS ) )
+        {
+        memcpy( &chunk, str, sizeof( chunk ) );
+        if( eight_digits_are_valid( chunk ) )
+            {
+            parts->mantissa         = ( parts->mantissa * 100000000 ) + eight_digits_value( chunk );
+            parts->mantissa_digits += 8;
+            parts->exponent        -= ( is_fraction ) ? 8 : 0;
+            str += 8;
+            continue;
+            }
+        }
+#endif
+
+    digit = *str - '0';
+
+    if( parts->mantissa_digits < MAX_MANTISSA_DIGITS )
+        {
+        parts->mantissa = ( parts->mantissa * 10 ) + digit;
+        parts->exponent -= ( is_fraction ) ? 1 : 0;
+
+        // Leading zeros do not take up room in the mantissa.
+        if( 0 != parts->mantissa )
+            {
+            parts->mantissa_digits++;
+            }
+        }
+    else
+        {
+        // Out of room, so the digit can only scale an integer part.
+        parts->exponent     += ( is_fraction ) ? 0 : 1;
+        parts->is_truncated |= ( 0 != digit );
+        }
+
+    str++;
+    }
+
+return str;
+}
+
+
+#if defined( NUMBER_SWAR )
+
+/**********************************************************
+*	eight_digits_are_valid
+*
+*	Returns 1 if all eight bytes of the provided little
+*   endian word are ASCII digits.
+*
+**********************************************************/
+static int eight_digits_are_valid
+    (
+    uint64_t chunk
+    )
+{
+// Every byte must be 0x3X, and adding 6 must not carry into the high nibble.
+return ( 0 == ( ( ( chunk & 0xF0F0F0F0F0F0F0F0ULL ) - 0x3030303030303030ULL )
+              | ( ( ( chunk + 0x0606060606060606ULL ) & 0xF0F0F0F0F0F0F0F0ULL ) - 0x3030303030303030ULL ) ) );
+}
+
+
+/**********************************************************
+*	eight_digits_value
+*
+*	Converts eight ASCII digits held in a little endian word
+*   into their value, combining pairs of digits, then pairs
+*   of pairs, and so on.
+*
+**********************************************************/
+static uint32_t eight_digits_value
+    (
+    uint64_t chunk
+    )
+{
+chunk = ( chunk & 0x0F0F0F0F0F0F0F0FULL ) * 2561 >> 8;
+chunk = ( chunk & 0x00FF00FF00FF00FFULL ) * 6553601 >> 16;
+
+return (uint32_t)( ( chunk & 0x0000FFFF0000FFFFULL ) * 42949672960001ULL >> 32 );
+}
+
+#endif
+
+
+/**********************************************************
+*	number_slow_path
+*
+*	Converts a number that cannot be converted exactly by
+*   the fast path using strtod(). The number is copied so
+*   that its decimal point can be replaced with the current
+*   locale's, keeping the result locale-independent. Numbers
+*   too long for the stack buffer are copied into the arena,
+*   or with the hooks if the arena is NULL. Stores the
+*   magnitude of the number in value_out. Returns 0 if
+*   memory runs out.
+*
+**********************************************************/
+static int number_slow_path
+    (
+    number_parts const *    parts,
+    char const *            number_end,
+    cJSON_Hooks const *     hooks,
+    cJSON_Arena *           arena,
+    double *                value_out
+    )
+{
+char    number_buffer[NUMBER_BUFFER_SIZE];
+char *  number_str;
+char    decimal_point;
+size_t  length;
+size_t  i;
+
+decimal_point = localeconv()->decimal_point[0];
+length        = number_end - parts->start;
+
+if( length < sizeof( number_buffer ) )
+    {
+    number_str = number_buffer;
+    }
+else if( NULL != arena )
+    {
+    number_str = (char*)arena_alloc( arena, length + 1 );
+    }
+else
+    {
+    number_str = (char*)hooks->malloc_fn( length + 1 );
+    }
+
+if( NULL == number_str )
+    {
+    return 0;
+    }
+
+for( i = 0; i < length; i++ )
+    {
+    number_str[i] = ( '.' == parts->start[i] ) ? decimal_point : parts->start[i];
+    }
+
+number_str[length] = '\0';
+
+*value_out = fabs( strtod( number_str, NULL ) );
+
+if( ( number_buffer != number_str ) && ( NULL == arena ) )
+    {
+    hooks->free_fn( number_str );
+    }
+
+return 1;
+}
+
+
+/**********************************************************
+*	uint64_print
+*
+*	Prints an unsigned 64-bit integer into the provided
+*   buffer two digits at a time and null-terminates it.
+*   Returns the number of digits written.
+*
+**********************************************************/
+static int uint64_print
+    (
+    uint64_t    value,
+    char *      buffer
+    )
+{
+char    digits[20];
+int     posn;
+int     pair;
+int     length;
+
+// Fill the scratch buffer from the end so digits come out in order.
+posn = sizeof( digits );
+while( value >= 100 )
+    {
+    pair  = (int)( value % 100 ) * 2;
+    value = value / 100;
+    digits[--posn] = digit_pairs[pair + 1];
+    digits[--posn] = digit_pairs[pair];
+    }
+
+if( value >= 10 )
+    {
+    pair = (int)value * 2;
+    digits[--posn] = digit_pairs[pair + 1];
+    digits[--posn] = digit_pairs[pair];
+    }
+else
+    {
+    digits[--posn] = (char)( '0' + value );
+    }
+
+length = sizeof( digits ) - posn;
+memcpy( buffer, &digits[posn], length );
+buffer[length] = '\0';
+
+return length;
+}
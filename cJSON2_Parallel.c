@@ -0,0 +1,478 @@
+/*
+ * Contains the parallel parser for single large documents. A prescan steps
+ * over the items of the root array or object, skipping nested containers and
+ * strings with the vector scanners, and splits them at top-level commas into
+ * segments. The segments are parsed on a pool of worker threads and their items
+ * are then linked together under a single root.
+ */
+
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "cJSON2.h"
+#include "cJSON2_private.h"
+
+#define PARALLEL_SEGMENTS_PER_THREAD    ( 4 )
+#define PARALLEL_MIN_SEGMENT_SIZE       ( 1024 * 1024 )
+
+/****************************************
+Private Types
+****************************************/
+typedef struct
+    {
+    char const *    start;          /* First item, just past '[', '{' or ',' */
+    char const *    end;            /* The ',' or closing bracket after it   */
+    cJSON *         items;          /* Container holding the parsed items    */
+    } parallel_segment;
+
+typedef struct
+    {
+    char                open_char;
+    char                close_char;
+    cJSON_Hooks         hooks;
+    parallel_segment *  segments;
+    size_t              segment_cnt;
+    size_t              next_segment;   /* Next segment for a worker to take */
+    pthread_mutex_t     lock;
+    } parallel_job;
+
+
+/****************************************
+Private Function Declarations
+****************************************/
+static char const * item_end
+    (
+    char const *    item,
+    char const *    json_end,
+    int             is_object
+    );
+
+static int parallel_segments_split
+    (
+    parallel_job *  job,
+    char const *    root,
+    char const *    json_end,
+    size_t          segment_size
+    );
+
+static cJSON * parallel_segments_stitch
+    (
+    parallel_job * job
+    );
+
+static void * parallel_worker
+    (
+    void * job_ptr
+    );
+
+static char const * string_end
+    (
+    char const *    string,
+    char const *    json_end
+    );
+
+
+/****************************************
+Public Functions
+****************************************/
+
+/**********************************************************
+*	cJSON_ParseParallel
+*
+*	Parses the first json_len characters of a JSON string on
+*   thread_cnt threads, or one per CPU if thread_cnt is 0.
+*   The items of a root array or object are split into
+*   segments that are parsed concurrently and then joined
+*   under a single root, so the result is the same as that
+*   of cJSON_ParseWithLength() with default hooks. Documents
+*   too small to be worth splitting, or whose root is not a
+*   container, are parsed on the calling thread. On error,
+*   this returns NULL. Otherwise, the caller must free the
+*   returned pointer with cJSON_Delete().
+*
+**********************************************************/
+cJSON * cJSON_ParseParallel
+    (
+    char const *    json_str,
+    size_t          json_len,
+    unsigned int    thread_cnt
+    )
+{
+parallel_job    job;
+pthread_t *     threads;
+char const *    root;
+char const *    json_end;
+size_t          segment_size;
+size_t          threads_started;
+size_t          i;
+cJSON *         json;
+
+if( NULL == json_str )
+    {
+    return NULL;
+    }
+
+if( 0 == thread_cnt )
+    {
+    thread_cnt = ( sysconf( _SC_NPROCESSORS_ONLN ) > 0 ) ? (unsigned int)sysconf( _SC_NPROCESSORS_ONLN ) : 1;
+    }
+
+memset( &job, 0, sizeof( job ) );
+job.hooks.malloc_fn  = malloc;
+job.hooks.realloc_fn = realloc;
+job.hooks.free_fn    = free;
+
+json_end = json_str + json_len;
+root     = scan_whitespace( json_str, json_end );
+
+segment_size = json_len / ( thread_cnt * PARALLEL_SEGMENTS_PER_THREAD );
+if( segment_size < PARALLEL_MIN_SEGMENT_SIZE )
+    {
+    segment_size = PARALLEL_MIN_SEGMENT_SIZE;
+    }
+
+// Anything the prescan can't split, including every invalid document, is
+// left to the regular parser, which also reports the error.
+if( ( thread_cnt < 2 ) || ( json_len < 2 * segment_size ) || ( root == json_end ) || ( ( '[' != *root ) && ( '{' != *root ) )
+ || ( !parallel_segments_split( &job, root, json_end, segment_size ) ) )
+    {
+    free( job.segments );
+    return cJSON_ParseWithLength( json_str, json_len, &job.hooks );
+    }
+
+pthread_mutex_init( &job.lock, NULL );
+
+// Never start more threads than there are segments to parse. If no thread
+// could be started, the calling thread does all of the parsing itself.
+threads         = (pthread_t*)malloc( thread_cnt * sizeof( *threads ) );
+threads_started = 0;
+
+while( ( NULL != threads ) && ( threads_started < thread_cnt ) && ( threads_started < job.segment_cnt ) )
+    {
+    if( 0 != pthread_create( &threads[threads_started], NULL, parallel_worker, &job ) )
+        {
+        break;
+        }
+    threads_started++;
+    }
+
+if( 0 == threads_started )
+    {
+    parallel_worker( &job );
+    }
+
+for( i = 0; i < threads_started; i++ )
+    {
+    pthread_join( threads[i], NULL );
+    }
+
+json = parallel_segments_stitch( &job );
+
+pthread_mutex_destroy( &job.lock );
+free( threads );
+free( job.segments );
+
+return json;
+}
+
+
+/****************************************
+Private Functions
+****************************************/
+
+/**********************************************************
+*	item_end
+*
+*	Returns a pointer to the first non-whitespace character
+*   after the array item or object member starting at the
+*   provided position, or NULL if the item can't be stepped
+*   over. Only strings and brackets are looked at closely;
+*   the segment parse checks the rest of the item's grammar.
+*
+**********************************************************/
+static char const * item_end
+    (
+    char const *    item,
+    char const *    json_end,
+    int             is_object
+    )
+{
+char const * item_start;
+
+item = scan_whitespace( item, json_end );
+
+if( is_object )
+    {
+    // Step over the key and the ':' after it.
+    if( ( item == json_end ) || ( '\"' != *item ) )
+        {
+        return NULL;
+        }
+
+    item = string_end( &item[1], json_end );
+    if( NULL == item )
+        {
+        return NULL;
+        }
+
+    item = scan_whitespace( item, json_end );
+    if( ( item == json_end ) || ( ':' != *item ) )
+        {
+        return NULL;
+        }
+
+    item = scan_whitespace( &item[1], json_end );
+    }
+
+if( item == json_end )
+    {
+    return NULL;
+    }
+else if( ( '[' == *item ) || ( '{' == *item ) )
+    {
+    item = scan_container_end( item, json_end );
+    }
+else if( '\"' == *item )
+    {
+    item = string_end( &item[1], json_end );
+    }
+else
+    {
+    // Numbers and literals run up to the next separator. A missing item, as
+    // in a trailing comma, would make an empty segment that parses cleanly.
+    for( item_start = item; ( item < json_end ) && ( ',' != *item ) && ( ']' != *item ) && ( '}' != *item ) && ( !is_json_whitespace( *item ) ); item++ )
+        ;
+
+    if( item == item_start )
+        {
+        return NULL;
+        }
+    }
+
+return ( NULL == item ) ? NULL : scan_whitespace( item, json_end );
+}
+
+
+/**********************************************************
+*	parallel_segments_split
+*
+*	Steps over the items of the root container, starting a
+*   new segment at the first top-level ',' past every
+*   segment_size characters. Returns 0 if the root can't be
+*   split into at least two segments or memory runs out.
+*
+**********************************************************/
+static int parallel_segments_split
+    (
+    parallel_job *  job,
+    char const *    root,
+    char const *    json_end,
+    size_t          segment_size
+    )
+{
+char const *    crnt_char;
+char const *    segment_start;
+size_t          max_segment_cnt;
+
+job->open_char  = *root;
+job->close_char = ( '[' == *root ) ? ']' : '}';
+
+max_segment_cnt = ( json_end - root ) / segment_size + 1;
+job->segments   = (parallel_segment*)calloc( max_segment_cnt, sizeof( *job->segments ) );
+if( NULL == job->segments )
+    {
+    return 0;
+    }
+
+segment_start = &root[1];
+
+for( crnt_char = &root[1]; ; crnt_char++ )
+    {
+    crnt_char = item_end( crnt_char, json_end, '{' == job->open_char );
+    if( ( NULL == crnt_char ) || ( crnt_char == json_end ) )
+        {
+        return 0;
+        }
+    else if( job->close_char == *crnt_char )
+        {
+        break;
+        }
+    else if( ',' != *crnt_char )
+        {
+        return 0;
+        }
+
+    if( ( (size_t)( crnt_char - segment_start ) >= segment_size ) && ( job->segment_cnt + 1 < max_segment_cnt ) )
+        {
+        job->segments[job->segment_cnt].start = segment_start;
+        job->segments[job->segment_cnt].end   = crnt_char;
+        job->segment_cnt++;
+        segment_start = &crnt_char[1];
+        }
+    }
+
+job->segments[job->segment_cnt].start = segment_start;
+job->segments[job->segment_cnt].end   = crnt_char;
+job->segment_cnt++;
+
+// Only whitespace may follow the root.
+return ( job->segment_cnt > 1 ) && ( json_end == scan_whitespace( &crnt_char[1], json_end ) );
+}
+
+
+/**********************************************************
+*	parallel_segments_stitch
+*
+*	Moves the items of every segment under the first
+*   segment's container, in order, and returns it. Returns
+*   NULL, and frees every segment, if any failed to parse.
+*
+**********************************************************/
+static cJSON * parallel_segments_stitch
+    (
+    parallel_job * job
+    )
+{
+cJSON * root;
+cJSON * last;
+cJSON * item;
+size_t  i;
+int     is_failed;
+
+for( i = 0; i < job->segment_cnt; i++ )
+    {
+    if( NULL == job->segments[i].items )
+        {
+        break;
+        }
+    }
+
+if( i < job->segment_cnt )
+    {
+    for( i = 0; i < job->segment_cnt; i++ )
+        {
+        cJSON_Delete( job->segments[i].items );
+        }
+
+    return NULL;
+    }
+
+// An array's index grows as items are moved under it, while an object's
+// index is built again once they all are.
+root      = job->segments[0].items;
+is_failed = 0;
+if( cJSON_Object == root->type )
+    {
+    container_index_free( root, &job->hooks );
+    }
+
+for( last = root->child; NULL != last->next; last = last->next )
+    ;
+
+for( i = 1; i < job->segment_cnt; i++ )
+    {
+    // Each segment holds at least one item.
+    item       = job->segments[i].items->child;
+    item->prev = last;
+    last->next = item;
+
+    for( ; NULL != item; item = item->next )
+        {
+        item->parent = root;
+        last         = item;
+        root->valueint++;
+
+        if( ( cJSON_Array == root->type ) && ( root->valueint >= CJSON_ARRAY_INDEX_THRESHOLD ) && ( !is_failed ) )
+            {
+            is_failed = !array_index_append( root, item, &job->hooks, NULL );
+            }
+        }
+
+    container_index_free( job->segments[i].items, &job->hooks );
+    job->hooks.free_fn( job->segments[i].items );
+    }
+
+if( ( is_failed ) || ( !container_index_build( root, &job->hooks, NULL ) ) )
+    {
+    cJSON_Delete( root );
+    return NULL;
+    }
+
+return root;
+}
+
+
+/**********************************************************
+*	parallel_worker
+*
+*	Takes segments from the job and parses them until there
+*   are none left. Each segment's items are copied between
+*   brackets to make a document of their own.
+*
+**********************************************************/
+static void * parallel_worker
+    (
+    void * job_ptr
+    )
+{
+parallel_job *      job;
+parallel_segment *  segment;
+char *              buffer;
+size_t              segment_len;
+
+job = (parallel_job*)job_ptr;
+
+for( ;; )
+    {
+    pthread_mutex_lock( &job->lock );
+    segment = ( job->next_segment < job->segment_cnt ) ? &job->segments[job->next_segment++] : NULL;
+    pthread_mutex_unlock( &job->lock );
+
+    if( NULL == segment )
+        {
+        break;
+        }
+
+    segment_len = segment->end - segment->start;
+    buffer      = (char*)job->hooks.malloc_fn( segment_len + 2 );
+    if( NULL == buffer )
+        {
+        continue;
+        }
+
+    buffer[0] = job->open_char;
+    memcpy( &buffer[1], segment->start, segment_len );
+    buffer[segment_len + 1] = job->close_char;
+
+    segment->items = cJSON_ParseWithLength( buffer, segment_len + 2, &job->hooks );
+
+    job->hooks.free_fn( buffer );
+    }
+
+return NULL;
+}
+
+
+/**********************************************************
+*	string_end
+*
+*	Returns a pointer just past the closing quote of the
+*   string whose contents start at the provided position,
+*   or NULL if it isn't closed.
+*
+**********************************************************/
+static char const * string_end
+    (
+    char const *    string,
+    char const *    json_end
+    )
+{
+string = scan_string( string, json_end );
+while( ( string + 1 < json_end ) && ( '\\' == *string ) )
+    {
+    string = scan_string( &string[2], json_end );
+    }
+
+return ( ( string < json_end ) && ( '\"' == *string ) ) ? &string[1] : NULL;
+}
@@ -1,12 +1,15 @@
 #include <ctype.h>
-#include <errno.h>
 #include <math.h>
-#include <stdio.h>
 #include <string.h>
 
 #include "cJSON2.h"
 #include "cJSON2_private.h"
 
+#define SAX_NESTING_LIMIT       ( 1024 )
+#define INTERN_KEY_MAX_LEN      ( 256 )
+
+#define is_number_char( _c ) ( ( isdigit( (unsigned char)(_c) ) ) || ( '+' == (_c) ) || ( '-' == (_c) ) || ( '.' == (_c) ) || ( 'e' == (_c) ) || ( 'E' == (_c) ) )
+
 /****************************************
 Private Types
 ****************************************/
@@ -16,36 +19,177 @@ typedef enum
     PARSE_STATE_NEXT_ARRAY_VALUE,
     PARSE_STATE_NEXT_OBJECT_VALUE,
     PARSE_STATE_OBJECT_KEY,
+    PARSE_STATE_END,
     PARSE_STATE_ERROR,
     PARSE_STATE_COMPLETE,
     } parse_state;
 
+typedef enum
+    {
+    VALUE_KIND_INVALID,
+    VALUE_KIND_STRING,
+    VALUE_KIND_ARRAY,
+    VALUE_KIND_OBJECT,
+    VALUE_KIND_NUMBER,
+    VALUE_KIND_NULL,                /* Literals, in literal_tokens[] order  */
+    VALUE_KIND_TRUE,
+    VALUE_KIND_FALSE,
+    VALUE_KIND_NAN,
+    VALUE_KIND_INFINITY,
+    VALUE_KIND_NEGATIVE_INFINITY,
+    } value_kind;
+
+typedef struct
+    {
+    char const *    text;
+    size_t          len;
+    cJSON_ValueType type;
+    double          valuedouble;    /* For the non-finite numbers           */
+    } literal_token;
+
 typedef struct
     {
     char const *    json_str;
     char const *    crnt_posn;      /* Current position within JSON string  */
+    char const *    json_end;       /* One past the last character to parse */
     cJSON_Hooks     hooks;
+    cJSON_Arena *   arena;          /* If set, all memory comes from here   */
+    int             is_in_situ;     /* Strings are terminated in json_str   */
+    int             is_lazy;        /* Nested containers are left unparsed  */
+    int             is_final;       /* No more input will follow json_end   */
+    int             is_suspended;   /* Waiting for more input to continue   */
+    uint32_t *      index;          /* Token offsets, if built ahead of time */
+    size_t          index_cnt;
+    size_t          index_posn;     /* First entry not yet moved past       */
+    key_table *     keys;           /* If set, object keys are interned here */
     cJSON *         root;
     cJSON *         crnt_node;
     parse_state     state;
+
+    /* Set when events are reported instead of building a tree. The tree's
+       parent links are then replaced by a stack of one bit per level of
+       nesting which is set for objects. */
+    cJSON_SaxHandler const *    sax;
+    void *                      sax_user_data;
+    size_t                      sax_depth;
+    unsigned char               sax_nesting[SAX_NESTING_LIMIT / 8];
+    char *                      sax_buffer;         /* Decoded escaped text  */
+    size_t                      sax_buffer_size;
     } parse_context;
 
+struct cJSON_Parser
+    {
+    parse_context   context;
+    cJSON_Hooks     hooks;
+    cJSON_Arena *   arena;          /* Retained memory for whole documents  */
+    key_table       keys;           /* Keys of the last whole document      */
+    char *          buffer;         /* Unconsumed input held between feeds  */
+    size_t          buffer_len;
+    size_t          buffer_size;
+    size_t          retry_len;      /* Buffered length at which to resume   */
+    };
+
 /****************************************
 Private Function Declarations
 ****************************************/
-static void crnt_node_add_child
+static void build_container_end
+    (
+    parse_context * context,
+    int             had_items
+    );
+
+static void build_container_start
+    (
+    parse_context * context,
+    cJSON_ValueType type
+    );
+
+static void build_first_item
+    (
+    parse_context * context
+    );
+
+static int build_key
+    (
+    parse_context * context,
+    char const *    key_end
+    );
+
+static void build_literal
+    (
+    parse_context * context,
+    cJSON_ValueType type
+    );
+
+static void build_next_item
     (
     parse_context * context
     );
 
-static void crnt_node_add_sibling
+static void build_number
+    (
+    parse_context *         context,
+    number_value const *    value
+    );
+
+static int build_string
+    (
+    parse_context * context,
+    char const *    string_end
+    );
+
+static void build_sax_result
+    (
+    parse_context * context,
+    int             callback_result
+    );
+
+static int build_sax_text
+    (
+    parse_context * context,
+    char const *    text_end,
+    int             is_reported,
+    char const **   text_out,
+    size_t *        text_len_out
+    );
+
+static char crnt_char
+    (
+    parse_context const * context
+    );
+
+static int crnt_container_is
+    (
+    parse_context const *   context,
+    cJSON_ValueType         type
+    );
+
+static int crnt_posn_matches
+    (
+    parse_context const *   context,
+    char const *            literal,
+    size_t                  literal_len
+    );
+
+static int index_seek
     (
     parse_context * context
     );
 
+static void input_exhausted
+    (
+    parse_context * context,
+    char const *    restart_posn
+    );
+
+static int is_top_level
+    (
+    parse_context const * context
+    );
+
 static cJSON * new_node
     (
-    cJSON_Hooks const * hooks
+    parse_context * context
     );
 
 static void next_array_value
@@ -68,6 +212,12 @@ static void parse
     parse_context * context
     );
 
+static void * parse_alloc
+    (
+    parse_context * context,
+    size_t          size
+    );
+
 static void parse_array
     (
     parse_context * context
@@ -78,6 +228,29 @@ static void parse_context_init
     parse_context *context
     );
 
+static cJSON * parse_document
+    (
+    parse_context * context,
+    char const *    json_str,
+    size_t          json_len
+    );
+
+static void parse_end
+    (
+    parse_context * context
+    );
+
+static void parse_lazy_container
+    (
+    parse_context * context
+    );
+
+static void parse_literal
+    (
+    parse_context *         context,
+    literal_token const *   token
+    );
+
 static void parse_number
     (
     parse_context * context
@@ -103,18 +276,84 @@ static void parse_value
     parse_context * context
     );
 
-static int string_extract_from_crnt_posn
+static int parser_buffer_append
+    (
+    cJSON_Parser *  parser,
+    char const *    data,
+    size_t          data_len
+    );
+
+static void parser_reset
+    (
+    cJSON_Parser * parser
+    );
+
+static void parser_run
+    (
+    cJSON_Parser *  parser,
+    char const *    json_str,
+    size_t          json_len,
+    int             is_final
+    );
+
+static int string_copy
     (
     parse_context * context,
+    char const *    string_end,
+    unsigned int    inline_flag,
     char **         extracted_string_out
     );
 
-static const char * skip_whitespace
+static int string_find_end
+    (
+    parse_context * context,
+    char const **   string_end_out
+    );
+
+static void skip_whitespace
     (
-    const char * string_in
+    parse_context * context
     );
 
 
+/****************************************
+Private Variables
+****************************************/
+static literal_token const literal_tokens[] =
+    {
+    { "null",       4,  cJSON_Null,     0.0         },
+    { "true",       4,  cJSON_True,     0.0         },
+    { "false",      5,  cJSON_False,    0.0         },
+    { "NaN",        3,  cJSON_Number,   NAN         },
+    { "Infinity",   8,  cJSON_Number,   INFINITY    },
+    { "-Infinity",  9,  cJSON_Number,   -INFINITY   },
+    };
+
+// The kind of value that starts with each character.
+static unsigned char const value_kinds[256] =
+    {
+    ['\"'] = VALUE_KIND_STRING,
+    ['[']  = VALUE_KIND_ARRAY,
+    ['{']  = VALUE_KIND_OBJECT,
+    ['-']  = VALUE_KIND_NUMBER,
+    ['0']  = VALUE_KIND_NUMBER,
+    ['1']  = VALUE_KIND_NUMBER,
+    ['2']  = VALUE_KIND_NUMBER,
+    ['3']  = VALUE_KIND_NUMBER,
+    ['4']  = VALUE_KIND_NUMBER,
+    ['5']  = VALUE_KIND_NUMBER,
+    ['6']  = VALUE_KIND_NUMBER,
+    ['7']  = VALUE_KIND_NUMBER,
+    ['8']  = VALUE_KIND_NUMBER,
+    ['9']  = VALUE_KIND_NUMBER,
+    ['n']  = VALUE_KIND_NULL,
+    ['t']  = VALUE_KIND_TRUE,
+    ['f']  = VALUE_KIND_FALSE,
+    ['N']  = VALUE_KIND_NAN,
+    ['I']  = VALUE_KIND_INFINITY,
+    };
+
+
 /****************************************
 Public Functions
 ****************************************/
@@ -132,374 +371,1731 @@ cJSON * cJSON_Parse
 {
 cJSON_Hooks default_hooks;
 
-default_hooks.malloc_fn = malloc;
-default_hooks.free_fn   = free;
+default_hooks.malloc_fn  = malloc;
+default_hooks.realloc_fn = realloc;
+default_hooks.free_fn    = free;
 
 return cJSON_ParseWithHooks( json_str, &default_hooks );
 }
 
 
 /**********************************************************
-*	cJSON_ParseWithHooks
+*	cJSON_ParseArena
 *
-*	Parse JSON string with provided hooks. On error, this
-*   returns NULL. Otherwise, the caller must free the resources
-*   owned by the returned pointer by passing it to cJSON_Delete()
-*   when they are done with it.
+*	Parse JSON string, carving every node and string out of
+*   the provided arena. On error, this returns NULL. The
+*   returned tree is owned by the arena and is released by
+*   cJSON_ArenaReset() or cJSON_ArenaDelete(); passing it to
+*   cJSON_Delete() is harmless but does nothing.
 *
 **********************************************************/
-cJSON * cJSON_ParseWithHooks
+cJSON * cJSON_ParseArena
     (
     char const *        json_str,
-    cJSON_Hooks const * hooks
+    cJSON_Arena *       arena
     )
 {
 parse_context context;
 
 parse_context_init( &context );
 
-context.json_str  = json_str;
-context.crnt_posn = &json_str[0];
-context.state     = PARSE_STATE_VALUE;
-
-context.hooks.malloc_fn = hooks->malloc_fn;
-context.hooks.free_fn   = hooks->free_fn;
+context.arena = arena;
 
-context.root      = new_node( &context.hooks );
-context.crnt_node = context.root;
-
-if( NULL != context.root )
+if( NULL == json_str )
     {
-    parse( &context );
+    return NULL;
     }
 
-return context.root;
+return parse_document( &context, json_str, strlen( json_str ) );
 }
 
 
 /**********************************************************
-*	crnt_node_add_child
+*	cJSON_ParseInSitu
 *
-*	Adds a child to node the context's current node and sets
-*	the context's current node to the newly created node.
+*	Parse the first json_len characters of a mutable JSON
+*   string with the provided hooks, without copying strings
+*   or keys. Instead they are null-terminated in place and
+*   string and valuestring point into json_str, so the
+*   caller's buffer is modified and must outlive the returned
+*   tree. On error, this returns NULL. Otherwise, the caller
+*   must free the returned pointer with cJSON_Delete(), which
+*   will leave the referenced strings alone.
 *
 **********************************************************/
-static void crnt_node_add_child
+cJSON * cJSON_ParseInSitu
     (
-    parse_context * context
+    char *              json_str,
+    size_t              json_len,
+    cJSON_Hooks const * hooks
     )
 {
-cJSON * child;
+parse_context context;
 
-child = new_node( &context->hooks );
-if( NULL == child )
-    {
-    context->state = PARSE_STATE_ERROR;
-    }
-else
+parse_context_init( &context );
+
+context.hooks.malloc_fn  = hooks->malloc_fn;
+context.hooks.realloc_fn = hooks->realloc_fn;
+context.hooks.free_fn    = hooks->free_fn;
+context.is_in_situ       = 1;
+
+if( NULL == json_str )
     {
-    child->parent             = context->crnt_node;
-    context->crnt_node->child = child;
-    context->crnt_node        = child;
+    return NULL;
     }
+
+return parse_document( &context, json_str, json_len );
 }
 
 
 /**********************************************************
-*	crnt_node_add_sibling
+*	cJSON_ParseSax
 *
-*	Adds a sibling node to the context's current node and
-*	sets the context's current node to the newly created
-*	node.
+*	Parses the first json_len characters of a JSON string
+*   without building a tree, reporting each value to the
+*   provided handler as it is found instead. Returns 1 if
+*   the whole document was valid and every callback asked to
+*   continue, otherwise returns 0.
 *
 **********************************************************/
-static void crnt_node_add_sibling
+int cJSON_ParseSax
     (
-    parse_context * context
+    char const *                json_str,
+    size_t                      json_len,
+    cJSON_SaxHandler const *    handler,
+    void *                      user_data
     )
 {
-cJSON * sibling;
+cJSON_Hooks default_hooks;
 
-sibling = new_node( &context->hooks );
-if( NULL == sibling )
-    {
-    context->state = PARSE_STATE_ERROR;
-    }
-else
-    {
-    sibling->prev            = context->crnt_node;
-    sibling->parent          = context->crnt_node->parent;
-    context->crnt_node->next = sibling;
-    context->crnt_node       = sibling;
-    }
+default_hooks.malloc_fn  = malloc;
+default_hooks.realloc_fn = realloc;
+default_hooks.free_fn    = free;
+
+return sax_parse( json_str, json_len, handler, user_data, &default_hooks );
 }
 
 
 /**********************************************************
-*	new_node
+*	cJSON_ParseWithHooks
 *
-*	Creates, initializes, and returns a new node. It is the
-*   caller's responsibility to free the returned pointer.
+*	Parse JSON string with provided hooks. On error, this
+*   returns NULL. Otherwise, the caller must free the resources
+*   owned by the returned pointer by passing it to cJSON_Delete()
+*   when they are done with it.
 *
 **********************************************************/
-static cJSON * new_node
+cJSON * cJSON_ParseWithHooks
     (
+    char const *        json_str,
     cJSON_Hooks const * hooks
     )
 {
-cJSON * node;
-
-node = (cJSON*)hooks->malloc_fn( sizeof( *node ) );
-
-if( NULL != node )
+if( NULL == json_str )
     {
-    memset( node, 0, sizeof( *node ) );
+    return NULL;
     }
 
-return node;
+return cJSON_ParseWithLength( json_str, strlen( json_str ), hooks );
 }
 
 
 /**********************************************************
-*	next_array_value
+*	cJSON_ParseWithFlags
 *
-*	Prepares the context to parse the next array value if
-*	if there is one
+*	Parse the first json_len characters of a JSON string
+*   using the provided hooks and cJSON_ParseFlag options. On
+*   error, this returns NULL. Otherwise, the caller must free
+*   the returned pointer with cJSON_DeleteWithHooks().
 *
 **********************************************************/
-static void next_array_value
+cJSON * cJSON_ParseWithFlags
     (
-    parse_context * context
+    char const *        json_str,
+    size_t              json_len,
+    unsigned int        flags,
+    cJSON_Hooks const * hooks
     )
 {
-context->crnt_posn = skip_whitespace( context->crnt_posn );
+parse_context   context;
+key_table       keys;
+cJSON *         root;
+long            index_cnt;
+
+parse_context_init( &context );
+memset( &keys, 0, sizeof( keys ) );
+
+context.hooks.malloc_fn  = hooks->malloc_fn;
+context.hooks.realloc_fn = hooks->realloc_fn;
+context.hooks.free_fn    = hooks->free_fn;
+context.is_lazy          = ( 0 != ( flags & cJSON_ParseLazy ) );
+context.keys             = ( flags & cJSON_ParseInternKeys ) ? &keys : NULL;
 
-if( !parent_node_is_array( context->crnt_node ) )
+if( NULL == json_str )
     {
-    // We should never get here
-    context->state = PARSE_STATE_ERROR;
+    return NULL;
     }
-else if( ']' == context->crnt_posn[0] )
-    {
-    // We've come to the end of an array. Move past the ']'.
-    context->crnt_posn++;
 
-    // Step up a level back to the containing array.
-    context->crnt_node = context->crnt_node->parent;
-    next_parse_state( context );
-    }
-else if( ',' ==  context->crnt_posn[0] )
+// Offsets are stored in 32 bits, so larger documents are parsed without an index.
+if( ( flags & cJSON_ParseStructuralIndex ) && ( json_len < UINT32_MAX ) )
     {
-    // We found another value in the array, move past the ',' and prepare to parse the
-    // next value in the array.
-    context->crnt_posn++;
+    context.index = (uint32_t*)hooks->malloc_fn( ( json_len + 1 ) * sizeof( *context.index ) );
+    if( NULL == context.index )
+        {
+        return NULL;
+        }
 
-    crnt_node_add_sibling( context );
-    if( PARSE_STATE_ERROR != context->state )
+    index_cnt = structural_index_build( json_str, json_len, context.index );
+    if( index_cnt < 0 )
         {
-        context->state = PARSE_STATE_VALUE;
+        hooks->free_fn( context.index );
+        return NULL;
         }
+
+    context.index_cnt = (size_t)index_cnt;
     }
-else
+
+root = parse_document( &context, json_str, json_len );
+
+if( NULL != context.index )
     {
-    // Invalid input
-    context->state = PARSE_STATE_ERROR;
+    hooks->free_fn( context.index );
     }
+
+key_table_free( &keys, hooks );
+
+return root;
 }
 
 
 /**********************************************************
-*	next_object_value
+*	cJSON_ParseWithLength
 *
-*	Prepares the context to parse the next object value if
-*	if there is one
+*	Parse the first json_len characters of a JSON string with
+*   the provided hooks. The string does not need to be
+*   null-terminated, so this can parse directly out of
+*   network buffers and mapped files. On error, this returns
+*   NULL. Otherwise, the caller must free the resources owned
+*   by the returned pointer by passing it to cJSON_Delete()
+*   when they are done with it.
 *
 **********************************************************/
-static void next_object_value
+cJSON * cJSON_ParseWithLength
     (
-    parse_context * context
+    char const *        json_str,
+    size_t              json_len,
+    cJSON_Hooks const * hooks
+    )
+{
+return cJSON_ParseWithFlags( json_str, json_len, 0, hooks );
+}
+
+
+/**********************************************************
+*	cJSON_ParserCreate
+*
+*	Create an incremental parser with default hooks.
+*
+**********************************************************/
+cJSON_Parser * cJSON_ParserCreate
+    (
+    void
+    )
+{
+cJSON_Hooks default_hooks;
+
+default_hooks.malloc_fn  = malloc;
+default_hooks.realloc_fn = realloc;
+default_hooks.free_fn    = free;
+
+return cJSON_ParserCreateWithHooks( &default_hooks );
+}
+
+
+/**********************************************************
+*	cJSON_ParserCreateWithHooks
+*
+*	Create an incremental parser that allocates with the
+*   provided hooks. Returns NULL on error. The caller must
+*   release the parser with cJSON_ParserDelete().
+*
+**********************************************************/
+cJSON_Parser * cJSON_ParserCreateWithHooks
+    (
+    cJSON_Hooks const * hooks
     )
 {
-context->crnt_posn = skip_whitespace( context->crnt_posn );
+cJSON_Parser * parser;
 
-if( !parent_node_is_object( context->crnt_node ) )
+parser = (cJSON_Parser*)hooks->malloc_fn( sizeof( *parser ) );
+
+if( NULL != parser )
     {
-    // We should never get here.
-    context->state = PARSE_STATE_ERROR;
+    memset( parser, 0, sizeof( *parser ) );
+    parser->hooks = *hooks;
+    parse_context_init( &parser->context );
+    parser_reset( parser );
     }
-else if( '}' == context->crnt_posn[0] )
-    {
-    // We've reached the end of an object. Move past the closing '}'.
-    context->crnt_posn++;
 
-    // Step up one level to the containing object.
-    context->crnt_node = context->crnt_node->parent;
-    next_parse_state( context );
-    }
-else if( ',' == context->crnt_posn[0] )
+return parser;
+}
+
+
+/**********************************************************
+*	cJSON_ParserDelete
+*
+*	Releases an incremental parser along with any document
+*   it was in the middle of parsing.
+*
+**********************************************************/
+void cJSON_ParserDelete
+    (
+    cJSON_Parser * parser
+    )
+{
+if( NULL == parser )
     {
-    // We've found another key/value pair in the object, move past the ','
-    // and prepare to parse the next value in the object.
-    context->crnt_posn++;
+    return;
+    }
 
-    crnt_node_add_sibling( context );
-    if( PARSE_STATE_ERROR != context->state )
-        {
-        context->state = PARSE_STATE_OBJECT_KEY;
-        }
+cJSON_DeleteWithHooks( parser->context.root, &parser->hooks );
+cJSON_ArenaDelete( parser->arena );
+key_table_free( &parser->keys, &parser->hooks );
+parser->hooks.free_fn( parser->buffer );
+parser->hooks.free_fn( parser );
+}
+
+
+/**********************************************************
+*	cJSON_ParserFeed
+*
+*	Feeds the next chunk of a JSON document to the parser.
+*   As much of the chunk as possible is parsed right away;
+*   a token cut off by the end of the chunk is held on to
+*   and resumed on the next feed. Returns 1 on success, or 0
+*   if the document is invalid or memory runs out, in which
+*   case cJSON_ParserFinish() will return NULL.
+*
+**********************************************************/
+int cJSON_ParserFeed
+    (
+    cJSON_Parser *  parser,
+    char const *    chunk,
+    size_t          chunk_len
+    )
+{
+parse_context * context;
+size_t          consumed;
+
+context = &parser->context;
+
+if( PARSE_STATE_ERROR == context->state )
+    {
+    return 0;
+    }
+else if( 0 == chunk_len )
+    {
+    return 1;
+    }
+
+if( 0 == parser->buffer_len )
+    {
+    // Nothing was carried over, so parse straight out of the caller's chunk
+    // and only hold on to the partial token at its end, if any.
+    parser_run( parser, chunk, chunk_len, 0 );
+    if( PARSE_STATE_ERROR == context->state )
+        {
+        return 0;
+        }
+
+    consumed = context->crnt_posn - chunk;
+    if( !parser_buffer_append( parser, context->crnt_posn, chunk_len - consumed ) )
+        {
+        return 0;
+        }
+    }
+else
+    {
+    if( !parser_buffer_append( parser, chunk, chunk_len ) )
+        {
+        return 0;
+        }
+
+    // A long token spread over many small chunks would be rescanned from its
+    // start on every feed, so wait until the buffer has doubled.
+    if( parser->buffer_len < parser->retry_len )
+        {
+        return 1;
+        }
+
+    parser_run( parser, parser->buffer, parser->buffer_len, 0 );
+    if( PARSE_STATE_ERROR == context->state )
+        {
+        return 0;
+        }
+
+    consumed = context->crnt_posn - parser->buffer;
+    memmove( parser->buffer, context->crnt_posn, parser->buffer_len - consumed );
+    parser->buffer_len -= consumed;
+    }
+
+parser->retry_len = 2 * parser->buffer_len;
+
+return 1;
+}
+
+
+/**********************************************************
+*	cJSON_ParserFinish
+*
+*	Tells the parser that the whole document has been fed
+*   and returns it. On error, this returns NULL. Otherwise,
+*   the caller must free the returned pointer with
+*   cJSON_Delete(). Either way the parser is reset and can
+*   be fed another document.
+*
+**********************************************************/
+cJSON * cJSON_ParserFinish
+    (
+    cJSON_Parser * parser
+    )
+{
+cJSON * root;
+
+if( PARSE_STATE_ERROR != parser->context.state )
+    {
+    parser_run( parser, parser->buffer, parser->buffer_len, 1 );
+    }
+
+root = parser->context.root;
+if( PARSE_STATE_COMPLETE != parser->context.state )
+    {
+    cJSON_DeleteWithHooks( root, &parser->hooks );
+    root = NULL;
+    }
+
+parser->context.root = NULL;
+parser_reset( parser );
+
+return root;
+}
+
+
+/**********************************************************
+*	cJSON_ParserParse
+*
+*	Parses the first json_len characters of a whole JSON
+*   document into memory kept by the parser. The memory of
+*   the previous document is reused, so once the parser has
+*   seen a document of similar size this does not call the
+*   allocator. Object keys are interned, so each distinct
+*   key is stored once. On error, this returns NULL. The
+*   returned tree is owned by the parser and is released by the next
+*   call to cJSON_ParserParse(), cJSON_ParserReset() or
+*   cJSON_ParserDelete(); passing it to cJSON_Delete() is
+*   harmless but does nothing.
+*
+**********************************************************/
+cJSON * cJSON_ParserParse
+    (
+    cJSON_Parser *  parser,
+    char const *    json_str,
+    size_t          json_len
+    )
+{
+cJSON * root;
+
+cJSON_ParserReset( parser );
+
+if( NULL == parser->arena )
+    {
+    parser->arena = cJSON_ArenaCreateWithHooks( &parser->hooks );
+    }
+
+if( ( NULL == json_str ) || ( NULL == parser->arena ) )
+    {
+    return NULL;
+    }
+
+parser->context.arena = parser->arena;
+parser->context.keys  = &parser->keys;
+root = parse_document( &parser->context, json_str, json_len );
+
+parser->context.root = NULL;
+parser_reset( parser );
+
+return root;
+}
+
+
+/**********************************************************
+*	cJSON_ParserReset
+*
+*	Releases the document last returned by
+*   cJSON_ParserParse() and abandons any document being fed
+*   to the parser, keeping the parser's memory for reuse.
+*
+**********************************************************/
+void cJSON_ParserReset
+    (
+    cJSON_Parser * parser
+    )
+{
+cJSON_DeleteWithHooks( parser->context.root, &parser->hooks );
+parser->context.root = NULL;
+parser_reset( parser );
+
+cJSON_ArenaReset( parser->arena );
+key_table_clear( &parser->keys );
+}
+
+
+/**********************************************************
+*	cJSON_Validate
+*
+*	Checks that the first json_len characters of a string
+*   are a single valid JSON document without allocating any
+*   memory. Nesting is tracked in a fixed-size stack, so
+*   documents nested more than SAX_NESTING_LIMIT levels deep
+*   are rejected. Returns 1 if the document is valid,
+*   otherwise returns 0.
+*
+**********************************************************/
+int cJSON_Validate
+    (
+    char const *    json_str,
+    size_t          json_len
+    )
+{
+static cJSON_SaxHandler const no_events = { NULL };
+
+return cJSON_ParseSax( json_str, json_len, &no_events, NULL );
+}
+
+
+/**********************************************************
+*	lazy_container_materialize
+*
+*	Parses the items of a container that was skipped by a
+*   lazy parse into the node. Containers nested in it are
+*   left unparsed in turn. Returns 0 if the container's text
+*   is invalid or memory runs out, in which case the node is
+*   left as it was.
+*
+**********************************************************/
+int lazy_container_materialize
+    (
+    cJSON * node
+    )
+{
+parse_context       context;
+lazy_container *    container;
+cJSON *             items;
+cJSON *             item;
+
+container = lazy_container_from_node( node );
+
+parse_context_init( &context );
+context.hooks   = container->hooks;
+context.arena   = container->arena;
+context.is_lazy = 1;
+
+items = parse_document( &context, container->text, strlen( container->text ) );
+if( NULL == items )
+    {
+    return 0;
+    }
+
+// Move the items over to the node and discard the container that held them.
+node->child = items->child;
+for( item = node->child; NULL != item; item = item->next )
+    {
+    item->parent = node;
+    }
+
+// The count and any index of the items now belong to the node.
+node->flags      &= ~cJSON_IsLazy;
+node->flags      |= items->flags & cJSON_IsIndexed;
+node->valuestring = items->valuestring;
+node->valueint    = items->valueint;
+
+if( NULL == container->arena )
+    {
+    container->hooks.free_fn( items );
+    container->hooks.free_fn( container );
+    }
+
+return 1;
+}
+
+
+/**********************************************************
+*	sax_parse
+*
+*	Works like cJSON_ParseSax(), but allocates the text of
+*   escaped strings with the provided hooks.
+*
+**********************************************************/
+int sax_parse
+    (
+    char const *                json_str,
+    size_t                      json_len,
+    cJSON_SaxHandler const *    handler,
+    void *                      user_data,
+    cJSON_Hooks const *         hooks
+    )
+{
+parse_context context;
+
+if( ( NULL == json_str ) || ( NULL == handler ) || ( NULL == hooks ) )
+    {
+    return 0;
+    }
+
+parse_context_init( &context );
+context.hooks.malloc_fn  = hooks->malloc_fn;
+context.hooks.realloc_fn = hooks->realloc_fn;
+context.hooks.free_fn    = hooks->free_fn;
+context.sax              = handler;
+context.sax_user_data    = user_data;
+
+parse_document( &context, json_str, json_len );
+
+if( NULL != context.sax_buffer )
+    {
+    hooks->free_fn( context.sax_buffer );
+    }
+
+return ( PARSE_STATE_COMPLETE == context.state );
+}
+
+
+/**********************************************************
+*	build_container_end
+*
+*	Closes the array or object that the context's position
+*   just moved past. had_items is 0 if it was empty.
+*
+**********************************************************/
+static void build_container_end
+    (
+    parse_context * context,
+    int             had_items
+    )
+{
+int is_object;
+
+if( NULL == context->sax )
+    {
+    if( had_items )
+        {
+        // Step up a level from the container's last item to the container.
+        context->crnt_node = context->crnt_node->parent;
+
+        if( !container_index_build( context->crnt_node, &context->hooks, context->arena ) )
+            {
+            context->state = PARSE_STATE_ERROR;
+            }
+        }
+    return;
+    }
+
+is_object = crnt_container_is( context, cJSON_Object );
+context->sax_depth--;
+context->sax_nesting[context->sax_depth / 8] &= ~( 1 << ( context->sax_depth % 8 ) );
+
+if( is_object )
+    {
+    build_sax_result( context, ( NULL == context->sax->end_object ) || ( context->sax->end_object( context->sax_user_data ) ) );
+    }
+else
+    {
+    build_sax_result( context, ( NULL == context->sax->end_array ) || ( context->sax->end_array( context->sax_user_data ) ) );
+    }
+}
+
+
+/**********************************************************
+*	build_container_start
+*
+*	Opens the array or object at the context's position.
+*
+**********************************************************/
+static void build_container_start
+    (
+    parse_context * context,
+    cJSON_ValueType type
+    )
+{
+if( NULL == context->sax )
+    {
+    context->crnt_node->type = type;
+    return;
+    }
+
+if( SAX_NESTING_LIMIT == context->sax_depth )
+    {
+    // Too deeply nested to keep track of.
+    context->state = PARSE_STATE_ERROR;
+    return;
+    }
+
+if( cJSON_Object == type )
+    {
+    context->sax_nesting[context->sax_depth / 8] |= ( 1 << ( context->sax_depth % 8 ) );
+    context->sax_depth++;
+    build_sax_result( context, ( NULL == context->sax->start_object ) || ( context->sax->start_object( context->sax_user_data ) ) );
+    }
+else
+    {
+    context->sax_nesting[context->sax_depth / 8] &= ~( 1 << ( context->sax_depth % 8 ) );
+    context->sax_depth++;
+    build_sax_result( context, ( NULL == context->sax->start_array ) || ( context->sax->start_array( context->sax_user_data ) ) );
+    }
+}
+
+
+/**********************************************************
+*	build_first_item
+*
+*	Prepares for the first item of a non-empty container by
+*   adding a child to the context's current node and making
+*   it the current node.
+*
+**********************************************************/
+static void build_first_item
+    (
+    parse_context * context
+    )
+{
+cJSON * child;
+
+if( NULL != context->sax )
+    {
+    return;
+    }
+
+child = new_node( context );
+if( NULL == child )
+    {
+    context->state = PARSE_STATE_ERROR;
+    }
+else
+    {
+    child->parent             = context->crnt_node;
+    context->crnt_node->child = child;
+    context->crnt_node->valueint++;
+    context->crnt_node        = child;
+    }
+}
+
+
+/**********************************************************
+*	build_key
+*
+*	Stores the object key at the context's position, whose
+*   closing quote is at key_end, and moves past it. Returns
+*   0 on error.
+*
+**********************************************************/
+static int build_key
+    (
+    parse_context * context,
+    char const *    key_end
+    )
+{
+char            key_buffer[INTERN_KEY_MAX_LEN];
+char const *    key;
+size_t          key_len;
+long            decoded_len;
+
+if( NULL != context->sax )
+    {
+    if( build_sax_text( context, key_end, NULL != context->sax->key, &key, &key_len ) )
+        {
+        build_sax_result( context, ( NULL == context->sax->key ) || ( context->sax->key( context->sax_user_data, key, key_len ) ) );
+        }
+
+    return ( PARSE_STATE_ERROR != context->state );
+    }
+else if( ( NULL == context->keys ) || ( (size_t)( key_end - &context->crnt_posn[1] ) > sizeof( key_buffer ) ) )
+    {
+    // Keys too long to decode on the stack are rare enough to just copy.
+    return string_copy( context, key_end, cJSON_KeyInline, &context->crnt_node->string );
+    }
+
+// Keys are interned by their decoded text so that differently escaped
+// spellings of a key still share one copy.
+decoded_len = string_decode( &context->crnt_posn[1], key_end, key_buffer );
+if( decoded_len < 0 )
+    {
+    context->state = PARSE_STATE_ERROR;
+    return 0;
+    }
+
+context->crnt_node->string = key_table_intern( context->keys, &context->hooks, context->arena, key_buffer, (size_t)decoded_len );
+if( NULL == context->crnt_node->string )
+    {
+    context->state = PARSE_STATE_ERROR;
+    return 0;
+    }
+
+context->crnt_node->flags |= cJSON_KeyInterned;
+context->crnt_posn         = key_end + 1;
+
+return 1;
+}
+
+
+/**********************************************************
+*	build_literal
+*
+*	Stores a null, true or false value.
+*
+**********************************************************/
+static void build_literal
+    (
+    parse_context * context,
+    cJSON_ValueType type
+    )
+{
+if( NULL == context->sax )
+    {
+    context->crnt_node->type = type;
+    }
+else if( cJSON_Null == type )
+    {
+    build_sax_result( context, ( NULL == context->sax->null ) || ( context->sax->null( context->sax_user_data ) ) );
+    }
+else
+    {
+    build_sax_result( context, ( NULL == context->sax->boolean ) || ( context->sax->boolean( context->sax_user_data, cJSON_True == type ) ) );
+    }
+}
+
+
+/**********************************************************
+*	build_next_item
+*
+*	Prepares for the next item of a container by adding a
+*   sibling to the context's current node and making it the
+*   current node.
+*
+**********************************************************/
+static void build_next_item
+    (
+    parse_context * context
+    )
+{
+cJSON * sibling;
+cJSON * container;
+
+if( NULL != context->sax )
+    {
+    return;
+    }
+
+sibling = new_node( context );
+if( NULL == sibling )
+    {
+    context->state = PARSE_STATE_ERROR;
+    }
+else
+    {
+    container                = context->crnt_node->parent;
+    sibling->prev            = context->crnt_node;
+    sibling->parent          = container;
+    context->crnt_node->next = sibling;
+    context->crnt_node       = sibling;
+    container->valueint++;
+
+    // Large arrays grow their index item by item rather than walking all of
+    // their items once closed.
+    if( ( cJSON_Array == container->type ) && ( container->valueint >= CJSON_ARRAY_INDEX_THRESHOLD )
+     && ( !array_index_append( container, sibling, &context->hooks, context->arena ) ) )
+        {
+        context->state = PARSE_STATE_ERROR;
+        }
+    }
+}
+
+
+/**********************************************************
+*	build_number
+*
+*	Stores a number value.
+*
+**********************************************************/
+static void build_number
+    (
+    parse_context *         context,
+    number_value const *    value
+    )
+{
+cJSON * node;
+
+if( NULL != context->sax )
+    {
+    if( ( value->is_int64 ) && ( NULL != context->sax->int64 ) )
+        {
+        build_sax_result( context, context->sax->int64( context->sax_user_data, value->valueint64 ) );
+        }
+    else
+        {
+        build_sax_result( context, ( NULL == context->sax->number ) || ( context->sax->number( context->sax_user_data, value->valuedouble ) ) );
+        }
+    return;
+    }
+
+node = context->crnt_node;
+node->type        = cJSON_Number;
+node->valuedouble = value->valuedouble;
+
+if( value->is_int64 )
+    {
+    node->flags     |= cJSON_IsInt64;
+    node->valueint64 = value->valueint64;
+    node->valueint   = int64_to_int( value->valueint64 );
+    }
+else
+    {
+    node->valueint = double_to_int( value->valuedouble );
+    }
+}
+
+
+/**********************************************************
+*	build_sax_result
+*
+*	Stops the parse if an event callback asked to.
+*
+**********************************************************/
+static void build_sax_result
+    (
+    parse_context * context,
+    int             callback_result
+    )
+{
+if( !callback_result )
+    {
+    context->state = PARSE_STATE_ERROR;
+    }
+}
+
+
+/**********************************************************
+*	build_sax_text
+*
+*	Decodes the string or key at the context's position,
+*   whose closing quote is at text_end, for an event and
+*   moves past it. Text without escape sequences is reported
+*   where it lies in the input; other text is decoded into
+*   the context's scratch buffer. Text that won't be reported
+*   is only validated, which never allocates. Returns 0 on
+*   error.
+*
+**********************************************************/
+static int build_sax_text
+    (
+    parse_context * context,
+    char const *    text_end,
+    int             is_reported,
+    char const **   text_out,
+    size_t *        text_len_out
+    )
+{
+char const *    text;
+char *          new_buffer;
+size_t          text_len;
+long            decoded_len;
+
+text               = &context->crnt_posn[1];
+text_len           = text_end - text;
+context->crnt_posn = text_end + 1;
+
+if( ( !is_reported ) || ( NULL == memchr( text, '\\', text_len ) ) )
+    {
+    decoded_len = string_decode( text, text_end, NULL );
+    *text_out   = text;
+    }
+else
+    {
+    if( text_len > context->sax_buffer_size )
+        {
+        new_buffer = (char*)context->hooks.realloc_fn( context->sax_buffer, text_len );
+        if( NULL == new_buffer )
+            {
+            context->state = PARSE_STATE_ERROR;
+            return 0;
+            }
+
+        context->sax_buffer      = new_buffer;
+        context->sax_buffer_size = text_len;
+        }
+
+    decoded_len = string_decode( text, text_end, context->sax_buffer );
+    *text_out   = context->sax_buffer;
+    }
+
+if( decoded_len < 0 )
+    {
+    context->state = PARSE_STATE_ERROR;
+    return 0;
+    }
+
+*text_len_out = (size_t)decoded_len;
+
+return 1;
+}
+
+
+/**********************************************************
+*	build_string
+*
+*	Stores the string value at the context's position, whose
+*   closing quote is at string_end, and moves past it.
+*   Returns 0 on error.
+*
+**********************************************************/
+static int build_string
+    (
+    parse_context * context,
+    char const *    string_end
+    )
+{
+char const *    string;
+size_t          string_len;
+
+if( NULL == context->sax )
+    {
+    context->crnt_node->type = cJSON_String;
+    return string_copy( context, string_end, cJSON_ValueInline, &context->crnt_node->valuestring );
+    }
+
+if( build_sax_text( context, string_end, NULL != context->sax->string, &string, &string_len ) )
+    {
+    build_sax_result( context, ( NULL == context->sax->string ) || ( context->sax->string( context->sax_user_data, string, string_len ) ) );
+    }
+
+return ( PARSE_STATE_ERROR != context->state );
+}
+
+
+/**********************************************************
+*	crnt_char
+*
+*	Returns the character at the context's current position,
+*   or '\0' if the whole string has been consumed.
+*
+**********************************************************/
+static char crnt_char
+    (
+    parse_context const * context
+    )
+{
+return ( context->crnt_posn < context->json_end ) ? context->crnt_posn[0] : '\0';
+}
+
+
+/**********************************************************
+*	crnt_container_is
+*
+*	Returns 1 if the value at the context's position is an
+*   item of a container of the provided type.
+*
+**********************************************************/
+static int crnt_container_is
+    (
+    parse_context const *   context,
+    cJSON_ValueType         type
+    )
+{
+size_t  level;
+int     is_object;
+
+if( NULL == context->sax )
+    {
+    return ( cJSON_Array == type ) ? parent_node_is_array( context->crnt_node ) : parent_node_is_object( context->crnt_node );
+    }
+else if( 0 == context->sax_depth )
+    {
+    return 0;
+    }
+
+level     = context->sax_depth - 1;
+is_object = ( 0 != ( context->sax_nesting[level / 8] & ( 1 << ( level % 8 ) ) ) );
+
+return ( cJSON_Object == type ) ? is_object : !is_object;
+}
+
+
+/**********************************************************
+*	crnt_posn_matches
+*
+*	Returns 1 if the characters at the context's current
+*   position match the provided literal without running past
+*   the end of the string.
+*
+**********************************************************/
+static int crnt_posn_matches
+    (
+    parse_context const *   context,
+    char const *            literal,
+    size_t                  literal_len
+    )
+{
+uint32_t    input_word;
+uint32_t    literal_word;
+size_t      i;
+
+if( (size_t)( context->json_end - context->crnt_posn ) < literal_len )
+    {
+    return 0;
+    }
+
+// Compare four characters at a time. With a constant literal this compiles
+// down to a load and a compare against an immediate per word.
+for( i = 0; i + sizeof( input_word ) <= literal_len; i += sizeof( input_word ) )
+    {
+    memcpy( &input_word, &context->crnt_posn[i], sizeof( input_word ) );
+    memcpy( &literal_word, &literal[i], sizeof( literal_word ) );
+    if( input_word != literal_word )
+        {
+        return 0;
+        }
+    }
+
+for( ; i < literal_len; i++ )
+    {
+    if( context->crnt_posn[i] != literal[i] )
+        {
+        return 0;
+        }
+    }
+
+return 1;
+}
+
+
+/**********************************************************
+*	index_seek
+*
+*	Moves the context's index position up to the first token
+*   at or after the current position. Returns 1 if there is
+*   such a token.
+*
+**********************************************************/
+static int index_seek
+    (
+    parse_context * context
+    )
+{
+uint32_t offset;
+
+offset = (uint32_t)( context->crnt_posn - context->json_str );
+
+while( ( context->index_posn < context->index_cnt ) && ( context->index[context->index_posn] < offset ) )
+    {
+    context->index_posn++;
+    }
+
+return ( context->index_posn < context->index_cnt );
+}
+
+
+/**********************************************************
+*	input_exhausted
+*
+*	Handles a parse step running out of input. If more input
+*   may still arrive, the context is suspended so that the
+*   step is retried from restart_posn once it does.
+*   Otherwise the input is invalid.
+*
+**********************************************************/
+static void input_exhausted
+    (
+    parse_context * context,
+    char const *    restart_posn
+    )
+{
+if( context->is_final )
+    {
+    context->state = PARSE_STATE_ERROR;
+    }
+else
+    {
+    context->is_suspended = 1;
+    context->crnt_posn    = restart_posn;
+    }
+}
+
+
+/**********************************************************
+*	is_top_level
+*
+*	Returns 1 if the value at the context's position is not
+*   contained in an array or object.
+*
+**********************************************************/
+static int is_top_level
+    (
+    parse_context const * context
+    )
+{
+if( NULL == context->sax )
+    {
+    return ( NULL == context->crnt_node->parent );
+    }
+
+return ( 0 == context->sax_depth );
+}
+
+
+/**********************************************************
+*	new_node
+*
+*	Creates, initializes, and returns a new node. It is the
+*   caller's responsibility to free the returned pointer unless
+*   it was allocated from an arena.
+*
+**********************************************************/
+static cJSON * new_node
+    (
+    parse_context * context
+    )
+{
+cJSON * node;
+
+node = (cJSON*)parse_alloc( context, sizeof( *node ) );
+
+if( NULL != node )
+    {
+    memset( node, 0, sizeof( *node ) );
+
+    if( NULL != context->arena )
+        {
+        node->flags |= cJSON_InArena;
+        }
+
+    if( context->is_in_situ )
+        {
+        node->flags |= cJSON_StringsReferenced;
+        }
+    }
+
+return node;
+}
+
+
+/**********************************************************
+*	next_array_value
+*
+*	Prepares the context to parse the next array value if
+*	if there is one
+*
+**********************************************************/
+static void next_array_value
+    (
+    parse_context * context
+    )
+{
+skip_whitespace( context );
+
+if( !crnt_container_is( context, cJSON_Array ) )
+    {
+    // We should never get here
+    context->state = PARSE_STATE_ERROR;
+    }
+else if( context->crnt_posn == context->json_end )
+    {
+    input_exhausted( context, context->crnt_posn );
+    }
+else if( ']' == crnt_char( context ) )
+    {
+    // We've come to the end of an array. Move past the ']' and step up a
+    // level back to the containing array.
+    context->crnt_posn++;
+
+    build_container_end( context, 1 );
+    next_parse_state( context );
+    }
+else if( ',' ==  crnt_char( context ) )
+    {
+    // We found another value in the array, move past the ',' and prepare to parse the
+    // next value in the array.
+    context->crnt_posn++;
+
+    build_next_item( context );
+    if( PARSE_STATE_ERROR != context->state )
+        {
+        context->state = PARSE_STATE_VALUE;
+        }
+    }
+else
+    {
+    // Invalid input
+    context->state = PARSE_STATE_ERROR;
+    }
+}
+
+
+/**********************************************************
+*	next_object_value
+*
+*	Prepares the context to parse the next object value if
+*	if there is one
+*
+**********************************************************/
+static void next_object_value
+    (
+    parse_context * context
+    )
+{
+skip_whitespace( context );
+
+if( !crnt_container_is( context, cJSON_Object ) )
+    {
+    // We should never get here.
+    context->state = PARSE_STATE_ERROR;
+    }
+else if( context->crnt_posn == context->json_end )
+    {
+    input_exhausted( context, context->crnt_posn );
+    }
+else if( '}' == crnt_char( context ) )
+    {
+    // We've reached the end of an object. Move past the closing '}' and
+    // step up one level to the containing object.
+    context->crnt_posn++;
+
+    build_container_end( context, 1 );
+    next_parse_state( context );
+    }
+else if( ',' == crnt_char( context ) )
+    {
+    // We've found another key/value pair in the object, move past the ','
+    // and prepare to parse the next value in the object.
+    context->crnt_posn++;
+
+    build_next_item( context );
+    if( PARSE_STATE_ERROR != context->state )
+        {
+        context->state = PARSE_STATE_OBJECT_KEY;
+        }
+    }
+else
+    {
+    // Invalid input
+    context->state = PARSE_STATE_ERROR;
+    }
+}
+
+
+/**********************************************************
+*	next_parse_state
+*
+*	Returns the next parse state. Should be called after
+*   Successfully parsing a value.
+*
+**********************************************************/
+static void next_parse_state
+    (
+    parse_context * context
+    )
+{
+if( PARSE_STATE_ERROR == context->state )
+    {
+    // Shouldn't get here. If we do it's an error, so leave the
+    // state alone.
+    }
+else if( is_top_level( context ) )
+    {
+    // We just finished parsing the top-level value.
+    context->state = PARSE_STATE_END;
+    }
+else if( crnt_container_is( context, cJSON_Array ) )
+    {
+    // The value we finished parsing is contained within an array
+    context->state = PARSE_STATE_NEXT_ARRAY_VALUE;
+    }
+else if( crnt_container_is( context, cJSON_Object ) )
+    {
+    // The value we finished parsing is contained within an object
+    context->state = PARSE_STATE_NEXT_OBJECT_VALUE;
+    }
+else
+    {
+    context->state = PARSE_STATE_ERROR;
+    }
+}
+
+
+/**********************************************************
+*	parse
+*
+*	Top-level parse function
+*
+**********************************************************/
+static void parse
+    (
+    parse_context * context
+    )
+{
+#if defined( __GNUC__ )
+// Jump straight from each state to the next through a table instead of going
+// back around a switch, so that every state has its own indirect branch and
+// the predictor can learn which state usually follows it.
+static void * const state_labels[] =
+    {
+    [PARSE_STATE_VALUE]             = &&state_value,
+    [PARSE_STATE_NEXT_ARRAY_VALUE]  = &&state_next_array_value,
+    [PARSE_STATE_NEXT_OBJECT_VALUE] = &&state_next_object_value,
+    [PARSE_STATE_OBJECT_KEY]        = &&state_object_key,
+    [PARSE_STATE_END]               = &&state_end,
+    [PARSE_STATE_ERROR]             = &&state_done,
+    [PARSE_STATE_COMPLETE]          = &&state_done,
+    };
+
+#define parse_dispatch() goto *( ( context->is_suspended ) ? &&state_done : state_labels[context->state] )
+
+parse_dispatch();
+
+state_value:
+    parse_value( context );
+    parse_dispatch();
+
+state_next_array_value:
+    next_array_value( context );
+    parse_dispatch();
+
+state_next_object_value:
+    next_object_value( context );
+    parse_dispatch();
+
+state_object_key:
+    parse_object_key( context );
+    parse_dispatch();
+
+state_end:
+    parse_end( context );
+    parse_dispatch();
+
+state_done:
+#undef parse_dispatch
+#else
+while( ( PARSE_STATE_COMPLETE != context->state ) && ( PARSE_STATE_ERROR != context->state ) && ( !context->is_suspended ) )
+    {
+    switch ( context->state )
+        {
+        case PARSE_STATE_VALUE:
+            parse_value( context );
+            break;
+
+        case PARSE_STATE_OBJECT_KEY:
+            parse_object_key( context );
+            break;
+
+        case PARSE_STATE_NEXT_ARRAY_VALUE:
+            next_array_value( context );
+            break;
+
+        case PARSE_STATE_NEXT_OBJECT_VALUE:
+            next_object_value( context );
+            break;
+
+        case PARSE_STATE_END:
+            parse_end( context );
+            break;
+
+        default:
+            // Shouldn't get here.
+            context->state = PARSE_STATE_ERROR;
+            break;
+        }
+    }
+#endif
+
+if( PARSE_STATE_ERROR == context->state )
+    {
+    cJSON_DeleteWithHooks( context->root, &context->hooks );
+    context->root = NULL;
+    }
+}    
+
+
+/**********************************************************
+*	parse_alloc
+*
+*	Allocates memory for a node or string, either from the
+*   context's arena or from its hooks.
+*
+**********************************************************/
+static void * parse_alloc
+    (
+    parse_context * context,
+    size_t          size
+    )
+{
+if( NULL != context->arena )
+    {
+    return arena_alloc( context->arena, size );
+    }
+
+return context->hooks.malloc_fn( size );
+}
+
+
+/**********************************************************
+*	parse_array
+*
+*	Parses a JSON array
+*
+**********************************************************/
+static void parse_array
+    (
+    parse_context * context
+    )
+{
+char const * array_start;
+
+// Move past the opening '[' of the array.
+array_start = context->crnt_posn;
+context->crnt_posn++;
+
+// Move to the first value of the array
+skip_whitespace( context );
+
+if( context->crnt_posn == context->json_end )
+    {
+    input_exhausted( context, array_start );
+    return;
+    }
+
+build_container_start( context, cJSON_Array );
+
+if( PARSE_STATE_ERROR == context->state )
+    {
+    // Couldn't start the array
+    }
+else if( ']' == crnt_char( context ) )
+    {
+    // This is an empty array. Move past the closing
+    // bracket of this empty array.
+    context->crnt_posn++;
+    build_container_end( context, 0 );
+    next_parse_state( context );
+    }
+else
+    {
+    // This array contains values, prepare to parse the
+    // first value of the array
+    build_first_item( context );
+    if( PARSE_STATE_ERROR != context->state )
+        {
+        context->state = PARSE_STATE_VALUE;
+        }
+    }
+}
+
+
+/**********************************************************
+*	parse_context_init
+*
+*	Initialize parse context.
+*
+**********************************************************/
+static void parse_context_init
+    (
+    parse_context *context
+    )
+{
+context->json_str        = NULL;
+context->crnt_posn       = NULL;
+context->json_end        = NULL;
+context->arena           = NULL;
+context->is_in_situ      = 0;
+context->is_lazy         = 0;
+context->is_final        = 1;
+context->is_suspended    = 0;
+context->index           = NULL;
+context->index_cnt       = 0;
+context->index_posn      = 0;
+context->keys            = NULL;
+context->root            = NULL;
+context->crnt_node       = NULL;
+context->state           = PARSE_STATE_ERROR;
+context->sax             = NULL;
+context->sax_user_data   = NULL;
+context->sax_depth       = 0;
+context->sax_buffer      = NULL;
+context->sax_buffer_size = 0;
+memset( &context->hooks, 0, sizeof( context->hooks ) );
+}
+
+
+/**********************************************************
+*	parse_document
+*
+*	Creates the root node and parses the first json_len
+*   characters of the provided JSON string into it using the
+*   context's allocator.
+*
+**********************************************************/
+static cJSON * parse_document
+    (
+    parse_context * context,
+    char const *    json_str,
+    size_t          json_len
+    )
+{
+context->json_str  = json_str;
+context->crnt_posn = &json_str[0];
+context->json_end  = &json_str[json_len];
+context->state     = PARSE_STATE_VALUE;
+
+if( NULL != context->sax )
+    {
+    parse( context );
+    return NULL;
     }
-else
+
+context->root      = new_node( context );
+context->crnt_node = context->root;
+
+if( NULL != context->root )
     {
-    // Invalid input
-    context->state = PARSE_STATE_ERROR;
+    parse( context );
     }
+
+return context->root;
 }
 
 
 /**********************************************************
-*	next_parse_state
+*	parse_end
 *
-*	Returns the next parse state. Should be called after
-*   Successfully parsing a value.
+*	Makes sure nothing but whitespace follows the top-level
+*   value.
 *
 **********************************************************/
-static void next_parse_state
+static void parse_end
     (
     parse_context * context
     )
 {
-if( PARSE_STATE_ERROR == context->state )
+skip_whitespace( context );
+
+if( context->crnt_posn != context->json_end )
     {
-    // Shouldn't get here. If we do it's an error, so leave the
-    // state alone.
+    context->state = PARSE_STATE_ERROR;
     }
-else if( ( NULL == context->crnt_node->parent ) && ( '\0' == context->crnt_posn[0] ) )
+else if( context->is_final )
     {
-    // We just finished parsing the top-level value so we're done. Hurray!
+    // We're done. Hurray!
     context->state = PARSE_STATE_COMPLETE;
     }
-else if( parent_node_is_array( context->crnt_node ) )
-    {
-    // The value we finished parsing is contained within an array
-    context->state = PARSE_STATE_NEXT_ARRAY_VALUE;
-    }
-else if( parent_node_is_object( context->crnt_node ) )
-    {
-    // The value we finished parsing is contained within an object
-    context->state = PARSE_STATE_NEXT_OBJECT_VALUE;
-    }
 else
     {
-    context->state = PARSE_STATE_ERROR;
+    input_exhausted( context, context->crnt_posn );
     }
 }
 
 
 /**********************************************************
-*	parse
+*	parse_lazy_container
 *
-*	Top-level parse function
+*	Skips over the array or object at the context's position,
+*   keeping a copy of its text to be parsed on first access.
 *
 **********************************************************/
-static void parse
+static void parse_lazy_container
     (
     parse_context * context
     )
 {
-while( ( PARSE_STATE_COMPLETE != context->state ) && ( PARSE_STATE_ERROR != context->state ) )
-    {
-    switch ( context->state )
-        {
-        case PARSE_STATE_VALUE:
-            parse_value( context );
-            break;
-
-        case PARSE_STATE_OBJECT_KEY:
-            parse_object_key( context );
-            break;
-
-        case PARSE_STATE_NEXT_ARRAY_VALUE:
-            next_array_value( context );
-            break;
-
-        case PARSE_STATE_NEXT_OBJECT_VALUE:
-            next_object_value( context );
-            break;
+char const *        container_end;
+size_t              text_len;
+lazy_container *    container;
 
-        default:
-            // Shouldn't get here.
-            context->state = PARSE_STATE_ERROR;
-            break;
-        }
+container_end = scan_container_end( context->crnt_posn, context->json_end );
+if( NULL == container_end )
+    {
+    // Unbalanced brackets or an invalid string
+    context->state = PARSE_STATE_ERROR;
+    return;
     }
 
-if( PARSE_STATE_ERROR == context->state )
+text_len  = container_end - context->crnt_posn;
+container = (lazy_container*)parse_alloc( context, offsetof( lazy_container, text ) + text_len + 1 );
+if( NULL == container )
     {
-    cJSON_DeleteWithHooks( context->root, &context->hooks );
-    context->root = NULL;
+    context->state = PARSE_STATE_ERROR;
+    return;
     }
-}    
+
+container->hooks = context->hooks;
+container->arena = context->arena;
+memcpy( container->text, context->crnt_posn, text_len );
+container->text[text_len] = '\0';
+
+context->crnt_node->type        = ( '[' == crnt_char( context ) ) ? cJSON_Array : cJSON_Object;
+context->crnt_node->flags      |= cJSON_IsLazy;
+context->crnt_node->valuestring = container->text;
+
+context->crnt_posn = container_end;
+next_parse_state( context );
+}
 
 
 /**********************************************************
-*	parse_array
+*	parse_literal
 *
-*	Parses a JSON array
+*	Parses the null, true, false or non-finite number literal
+*   at the context's position.
 *
 **********************************************************/
-static void parse_array
+static void parse_literal
     (
-    parse_context * context
+    parse_context *         context,
+    literal_token const *   token
     )
 {
-context->crnt_node->type = cJSON_Array;
-
-// Move past the opening '[' of the array.
-context->crnt_posn++;
+number_value    special_value;
+size_t          remaining;
 
-// Move to the first value of the array
-context->crnt_posn = skip_whitespace( context->crnt_posn );
+remaining = context->json_end - context->crnt_posn;
 
-if( ']' == context->crnt_posn[0] )
+if( crnt_posn_matches( context, token->text, token->len ) )
     {
-    // This is an empty array. Move past the closing
-    // bracket of this empty array.
-    context->crnt_posn++;
+    context->crnt_posn += token->len;
+
+    if( cJSON_Number == token->type )
+        {
+        special_value.valuedouble = token->valuedouble;
+        special_value.valueint64  = 0;
+        special_value.is_int64    = 0;
+        build_number( context, &special_value );
+        }
+    else
+        {
+        build_literal( context, token->type );
+        }
+
     next_parse_state( context );
     }
+else if( ( !context->is_final ) && ( remaining < token->len ) && ( 0 == memcmp( context->crnt_posn, token->text, remaining ) ) )
+    {
+    // The rest of the literal may be in the next chunk.
+    input_exhausted( context, context->crnt_posn );
+    }
 else
     {
-    // This array contains values, prepare to parse the
-    // first value of the array
-    crnt_node_add_child( context );
-    if( PARSE_STATE_ERROR != context->state )
-        {
-        context->state = PARSE_STATE_VALUE;
-        }
+    // Invalid input
+    context->state = PARSE_STATE_ERROR;
     }
 }
 
 
-/**********************************************************
-*	parse_context_init
-*
-*	Initialize parse context.
-*
-**********************************************************/
-static void parse_context_init
-    (
-    parse_context *context
-    )
-{
-context->json_str     = NULL;
-context->crnt_posn    = NULL;
-context->root         = NULL;
-context->crnt_node    = NULL;
-context->state        = PARSE_STATE_ERROR;
-memset( &context->hooks, 0, sizeof( context->hooks ) );
-}
-
-
 /**********************************************************
 *	parse_number
 *
@@ -511,33 +2107,34 @@ static void parse_number
     parse_context * context
     )
 {
-double parsed_value;
-char * next_posn;
+number_value    parsed_value;
+char const *    next_posn;
 
-parsed_value = strtod( context->crnt_posn, &next_posn );
-
-if( ( HUGE_VAL == parsed_value ) || ( -HUGE_VAL == parsed_value ) )
-    {
-    // Overflow
-    context->state = PARSE_STATE_ERROR;
-    }
-else if( ( 0.0 == parsed_value ) && ( ERANGE == errno ) )
+if( !context->is_final )
     {
-    // Underflow
-    context->state = PARSE_STATE_ERROR;
+    // A number running up to the end of the input may have more digits to come.
+    for( next_posn = context->crnt_posn; ( next_posn < context->json_end ) && ( is_number_char( *next_posn ) ); next_posn++ )
+        ;
+
+    if( next_posn == context->json_end )
+        {
+        input_exhausted( context, context->crnt_posn );
+        return;
+        }
     }
-else if( ( 0.0 == parsed_value ) && ( next_posn == context->crnt_posn ) )
+
+next_posn = number_parse( context->crnt_posn, context->json_end, &context->hooks, context->arena, &parsed_value );
+
+if( NULL == next_posn )
     {
-    // No conversion was performed
+    // Not a valid JSON number, out of range for a double, or out of memory
     context->state = PARSE_STATE_ERROR;
     }
 else
     {
     // Successful parse
-    context->crnt_node->type        = cJSON_Number;
-    context->crnt_node->valuedouble = parsed_value;
-    context->crnt_node->valueint    = (int)parsed_value;
-    context->crnt_posn              = next_posn;
+    context->crnt_posn = next_posn;
+    build_number( context, &parsed_value );
     next_parse_state( context );
     }
 }
@@ -554,24 +2151,38 @@ static void parse_object
     parse_context * context
     )
 {
-context->crnt_node->type = cJSON_Object;
+char const * object_start;
 
-// Move past the opening '}'
+// Move past the opening '{'
+object_start = context->crnt_posn;
 context->crnt_posn++;
 
 // Move to the first value of the object
-context->crnt_posn = skip_whitespace( context->crnt_posn );
+skip_whitespace( context );
+
+if( context->crnt_posn == context->json_end )
+    {
+    input_exhausted( context, object_start );
+    return;
+    }
+
+build_container_start( context, cJSON_Object );
 
-if( '}' == context->crnt_posn[0] )
+if( PARSE_STATE_ERROR == context->state )
+    {
+    // Couldn't start the object
+    }
+else if( '}' == crnt_char( context ) )
     {
     // This is an empty object, move past its closing brace
     context->crnt_posn++;
+    build_container_end( context, 0 );
     next_parse_state( context );
     }
 else
     {
     // Prepare to parse this object's first value
-    crnt_node_add_child( context );
+    build_first_item( context );
     if( PARSE_STATE_ERROR != context->state )
         {
         context->state = PARSE_STATE_OBJECT_KEY;
@@ -591,24 +2202,41 @@ static void parse_object_key
     parse_context * context
     )
 {
-int is_valid_key;
+char const * key_start;
+char const * key_end;
+char const * colon_posn;
+
+skip_whitespace( context );
+key_start = context->crnt_posn;
+
+if( !string_find_end( context, &key_end ) )
+    {
+    return;
+    }
 
-is_valid_key = string_extract_from_crnt_posn( context, &context->crnt_node->string );
+// Now that we found the key, look for the ':' character before copying the
+// key so that nothing needs to be undone if we run out of input.
+context->crnt_posn = key_end + 1;
+skip_whitespace( context );
 
-if( is_valid_key )
+if( context->crnt_posn == context->json_end )
+    {
+    input_exhausted( context, key_start );
+    }
+else if( ':' != crnt_char( context ) )
+    {
+    context->state = PARSE_STATE_ERROR;
+    }
+else
     {
-    // Now that we got the key, look for the ':' character
-    context->crnt_posn = skip_whitespace( context->crnt_posn );
+    colon_posn         = context->crnt_posn;
+    context->crnt_posn = key_start;
 
-    if( ':' == context->crnt_posn[0] )
+    if( build_key( context, key_end ) )
         {
         // Move past the ':'
-        context->crnt_posn++;
-        context->state = PARSE_STATE_VALUE;
-        }
-    else
-        {
-        context->state = PARSE_STATE_ERROR;
+        context->crnt_posn = colon_posn + 1;
+        context->state     = PARSE_STATE_VALUE;
         }
     }
 }
@@ -617,10 +2245,8 @@ if( is_valid_key )
 /**********************************************************
 *	parse_string
 *
-*	Parse JSON string.
-*
-*   TODO: Does not allow control characters or unicode values
-*         and does not prevent against buffer overflows.
+*	Parse JSON string, decoding its escape sequences and
+*   validating its UTF-8.
 *
 **********************************************************/
 static void parse_string
@@ -628,13 +2254,10 @@ static void parse_string
     parse_context * context
     )
 {
-int is_valid_string;
-
-context->crnt_node->type = cJSON_String;
+char const * string_end;
 
-is_valid_string = string_extract_from_crnt_posn( context, &context->crnt_node->valuestring );
-
-if( is_valid_string )
+if( ( string_find_end( context, &string_end ) )
+ && ( build_string( context, string_end ) ) )
     {
     next_parse_state( context );
     }
@@ -652,134 +2275,339 @@ static void parse_value
     parse_context * context
     )
 {
-context->crnt_posn = skip_whitespace( context->crnt_posn );
+value_kind kind;
 
-if( NULL == context->crnt_posn )
-    {
-    context->state = PARSE_STATE_ERROR;
-    }
-else if( '\"' == context->crnt_posn[0] )
-    {
-    parse_string( context );
-    }
+skip_whitespace( context );
 
-else if( '[' == context->crnt_posn[0] )
+if( context->crnt_posn == context->json_end )
     {
-    parse_array( context );
+    input_exhausted( context, context->crnt_posn );
+    return;
     }
-else if( '{' == context->crnt_posn[0] )
+
+// Dispatch on the first character instead of trying each kind of value in turn.
+kind = (value_kind)value_kinds[(unsigned char)crnt_char( context )];
+
+switch( kind )
     {
-    parse_object( context );
+    case VALUE_KIND_STRING:
+        parse_string( context );
+        break;
+
+    case VALUE_KIND_ARRAY:
+    case VALUE_KIND_OBJECT:
+        if( ( context->is_lazy ) && ( !is_top_level( context ) ) )
+            {
+            parse_lazy_container( context );
+            }
+        else if( VALUE_KIND_ARRAY == kind )
+            {
+            parse_array( context );
+            }
+        else
+            {
+            parse_object( context );
+            }
+        break;
+
+    case VALUE_KIND_NUMBER:
+        if( ( context->crnt_posn + 1 < context->json_end ) && ( 'I' == context->crnt_posn[1] ) )
+            {
+            parse_literal( context, &literal_tokens[VALUE_KIND_NEGATIVE_INFINITY - VALUE_KIND_NULL] );
+            }
+        else
+            {
+            parse_number( context );
+            }
+        break;
+
+    case VALUE_KIND_NULL:
+    case VALUE_KIND_TRUE:
+    case VALUE_KIND_FALSE:
+    case VALUE_KIND_NAN:
+    case VALUE_KIND_INFINITY:
+        parse_literal( context, &literal_tokens[kind - VALUE_KIND_NULL] );
+        break;
+
+    default:
+        // Invalid input
+        context->state = PARSE_STATE_ERROR;
+        break;
     }
-else if( 0 == strncmp( context->crnt_posn, "null", 4 ) )
+}
+
+
+/**********************************************************
+*	parser_buffer_append
+*
+*	Appends input that could not be parsed yet to the
+*   parser's buffer, growing it as needed. Returns 1 on
+*   success, or 0 and sets the error state if memory runs
+*   out.
+*
+**********************************************************/
+static int parser_buffer_append
+    (
+    cJSON_Parser *  parser,
+    char const *    data,
+    size_t          data_len
+    )
+{
+size_t  new_size;
+char *  new_buffer;
+
+if( 0 == data_len )
     {
-    context->crnt_node->type = cJSON_Null;
-    context->crnt_posn += 4;
-    next_parse_state( context );
+    // The buffer may not exist yet.
+    return 1;
     }
-else if( 0 == strncmp( context->crnt_posn, "false", 5 ) )
+else if( parser->buffer_len + data_len > parser->buffer_size )
     {
-    context->crnt_node->type = cJSON_False;
-    context->crnt_posn += 5;
-    next_parse_state( context );
+    new_size = ( 0 == parser->buffer_size ) ? 64 : parser->buffer_size;
+    while( new_size < parser->buffer_len + data_len )
+        {
+        new_size *= 2;
+        }
+
+    new_buffer = (char*)parser->hooks.realloc_fn( parser->buffer, new_size );
+    if( NULL == new_buffer )
+        {
+        cJSON_DeleteWithHooks( parser->context.root, &parser->hooks );
+        parser->context.root  = NULL;
+        parser->context.state = PARSE_STATE_ERROR;
+        return 0;
+        }
+
+    parser->buffer      = new_buffer;
+    parser->buffer_size = new_size;
     }
-else if( 0 == strncmp( context->crnt_posn, "true", 4 ) )
+
+memcpy( &parser->buffer[parser->buffer_len], data, data_len );
+parser->buffer_len += data_len;
+
+return 1;
+}
+
+
+/**********************************************************
+*	parser_reset
+*
+*	Prepares a parser to be fed a new document. The parser's
+*   buffer is kept for reuse.
+*
+**********************************************************/
+static void parser_reset
+    (
+    cJSON_Parser * parser
+    )
+{
+parse_context_init( &parser->context );
+
+parser->context.hooks = parser->hooks;
+parser->context.state = PARSE_STATE_VALUE;
+parser->buffer_len    = 0;
+parser->retry_len     = 0;
+}
+
+
+/**********************************************************
+*	parser_run
+*
+*	Runs the parser's state machine over the provided input,
+*   creating the document's root first if needed.
+*
+**********************************************************/
+static void parser_run
+    (
+    cJSON_Parser *  parser,
+    char const *    json_str,
+    size_t          json_len,
+    int             is_final
+    )
+{
+parse_context * context;
+
+context = &parser->context;
+
+if( NULL == context->root )
     {
-    context->crnt_node->type = cJSON_True;
-    context->crnt_posn += 4;
-    next_parse_state( context );
+    context->root      = new_node( context );
+    context->crnt_node = context->root;
+
+    if( NULL == context->root )
+        {
+        context->state = PARSE_STATE_ERROR;
+        return;
+        }
     }
-else if( 0 == strncmp( "-Infinity", context->crnt_posn, 9 ) )
+
+context->json_str     = json_str;
+context->crnt_posn    = json_str;
+context->json_end     = json_str + json_len;
+context->is_final     = is_final;
+context->is_suspended = 0;
+
+parse( context );
+}
+
+
+/**********************************************************
+*	string_copy
+*
+*   Copies the string at the current position, whose closing
+*   quote is at string_end, and moves past it. Strings short
+*   enough to fit in what is left of the current node's
+*   inline storage are kept there and mark the node with
+*   inline_flag. If an error occurs this returns 0 and sets
+*   extracted_string_out to NULL. Otherwise this returns 1
+*   and populates extracted_string_out with the decoded
+*   string.
+*
+**********************************************************/
+static int string_copy
+    (
+    parse_context * context,
+    char const *    string_end,
+    unsigned int    inline_flag,
+    char **         extracted_string_out
+    )
+{
+cJSON *         node;
+char const *    string;
+char *          decoded;
+long            decoded_len;
+size_t          inline_used;
+int             is_allocated;
+int             is_inline;
+
+node         = context->crnt_node;
+string       = &context->crnt_posn[1];
+is_allocated = 0;
+is_inline    = 0;
+
+// The key is copied before the value, so only a value can find the inline
+// storage already partly taken.
+inline_used = ( node->flags & cJSON_KeyInline ) ? strlen( node->string ) + 1 : 0;
+
+if( context->is_in_situ )
     {
-    context->crnt_node->type        = cJSON_Number;
-    context->crnt_node->valuedouble = -INFINITY;
-    context->crnt_posn += 9;
-    next_parse_state( context );
+    // The caller handed us a mutable buffer, so decode the string where it
+    // stands and terminate it, at the latest over its closing quote.
+    decoded = (char*)string;
     }
-else if( ( '-' == context->crnt_posn[0] ) || ( isdigit( context->crnt_posn[0] ) ) )
+else if( inline_used + (size_t)( string_end - string ) < sizeof( node->inline_strings ) )
     {
-    parse_number( context );
+    decoded   = &node->inline_strings[inline_used];
+    is_inline = 1;
     }
-else if( 0 == strncmp( "NaN", context->crnt_posn, 3 ) )
+else
     {
-    context->crnt_node->type        = cJSON_Number;
-    context->crnt_node->valuedouble = NAN;
-    context->crnt_posn += 3;
-    next_parse_state( context );
+    // Decoding never makes a string longer, so allocate for the encoded
+    // length, including the NULL terminator.
+    decoded = (char*)parse_alloc( context, string_end - string + 1 );
+    if( NULL == decoded )
+        {
+        *extracted_string_out = NULL;
+        context->state        = PARSE_STATE_ERROR;
+        return 0;
+        }
+
+    is_allocated = ( NULL == context->arena );
     }
-else if( 0 == strncmp( "Infinity", context->crnt_posn, 8 ) )
+
+decoded_len = string_decode( string, string_end, decoded );
+if( decoded_len < 0 )
     {
-    context->crnt_node->type        = cJSON_Number;
-    context->crnt_node->valuedouble = INFINITY;
-    context->crnt_posn += 8;
-    next_parse_state( context );
+    if( is_allocated )
+        {
+        context->hooks.free_fn( decoded );
+        }
+
+    *extracted_string_out = NULL;
+    context->state        = PARSE_STATE_ERROR;
+    return 0;
     }
-else
+
+if( is_inline )
     {
-    // Invalid input
-    context->state = PARSE_STATE_ERROR;
+    node->flags |= inline_flag;
     }
+
+decoded[decoded_len]  = '\0';
+*extracted_string_out = decoded;
+context->crnt_posn    = string_end + 1;
+
+return 1;
 }
 
 
 /**********************************************************
-*	string_extract_from_crnt_posn
+*	string_find_end
 *
-*   Extracts string from current position in JSON string.
-*	If an error occurs, or if the provided JSON is invalid,
-*	this returns 0 and sets extracted_string_out to NULL.
-*	Otherwise this returns 1 and populates extracted_string_out
+*   Finds the closing quote of the string at the current
+*   position without moving past it. If the input is
+*   invalid or runs out first, this returns 0 and updates
+*   the context's state. Otherwise this returns 1 and
+*   populates string_end_out.
 *
 **********************************************************/
-static int string_extract_from_crnt_posn
+static int string_find_end
     (
     parse_context * context,
-    char **         extracted_string_out
+    char const **   string_end_out
     )
 {
-int             length;
-char const *    crnt_char_ptr;
-
-length = 0;
-*extracted_string_out = NULL;
+char const * crnt_char_ptr;
 
-context->crnt_posn = skip_whitespace( context->crnt_posn );
-
-if( '\"' != context->crnt_posn[0] )
+if( context->crnt_posn == context->json_end )
+    {
+    input_exhausted( context, context->crnt_posn );
+    return 0;
+    }
+else if( '\"' != crnt_char( context ) )
     {
     // Not a string
     context->state = PARSE_STATE_ERROR;
     return 0;
     }
+else if( NULL != context->index )
+    {
+    // Only the closing quote is indexed between the opening quote and the
+    // next token, and the first stage already checked for control characters.
+    if( ( !index_seek( context ) ) || ( context->index_posn + 1 == context->index_cnt ) )
+        {
+        context->state = PARSE_STATE_ERROR;
+        return 0;
+        }
+
+    *string_end_out = &context->json_str[context->index[context->index_posn + 1]];
+    context->index_posn += 2;
+    return 1;
+    }
 
-// Move to the first character past the opening "
-crnt_char_ptr = &context->crnt_posn[1];
+// Move to the first character past the opening " and find the closing one,
+// stepping over any escaped characters along the way.
+crnt_char_ptr = scan_string( &context->crnt_posn[1], context->json_end );
 
-while( ( '\0' != *crnt_char_ptr ) && ( '\"' != *crnt_char_ptr ) )
+while( ( crnt_char_ptr + 1 < context->json_end ) && ( '\\' == crnt_char_ptr[0] ) )
     {
-    crnt_char_ptr++;
-    length++;
+    crnt_char_ptr = scan_string( &crnt_char_ptr[2], context->json_end );
     }
 
-if( '\"' != *crnt_char_ptr )
+if( ( crnt_char_ptr == context->json_end ) || ( crnt_char_ptr + 1 == context->json_end && '\\' == crnt_char_ptr[0] ) )
     {
-    // Invalid input
-    context->state = PARSE_STATE_ERROR;
+    // The string or its last escape sequence is cut off.
+    input_exhausted( context, context->crnt_posn );
     return 0;
     }
-
-// Allocate space to hold the string, including the NULL terminator
-*extracted_string_out = (char*)context->hooks.malloc_fn( length + 1 );
-if( NULL == *extracted_string_out )
+else if( '\"' != *crnt_char_ptr )
     {
+    // Invalid input: an unescaped control character
     context->state = PARSE_STATE_ERROR;
     return 0;
     }
-else
-    {
-    snprintf( *extracted_string_out, length + 1, "%s", &context->crnt_posn[1] );
-    context->crnt_posn += length + 2;
-    }
+
+*string_end_out = crnt_char_ptr;
 
 return 1;
 }
@@ -788,26 +2616,24 @@ return 1;
 /**********************************************************
 *	skip_whitespace
 *
-*   Utility function that returns a pointer to the first
-*   non-whitespace character encountered in the provided
-*   string or the null-terminiator if the entire string is
-*   whitespace.
+*   Utility function that moves the context's current
+*   position to the first non-whitespace character, or to
+*   the end of the string if the rest of it is whitespace.
 *
 **********************************************************/
-static const char * skip_whitespace
+static void skip_whitespace
     (
-    const char * string_in
+    parse_context * context
     )
 {
-int i;
-
-if( NULL == string_in )
+if( NULL == context->index )
     {
-    return NULL;
+    context->crnt_posn = scan_whitespace( context->crnt_posn, context->json_end );
+    }
+else if( ( context->crnt_posn < context->json_end ) && ( is_json_whitespace( context->crnt_posn[0] ) ) )
+    {
+    // Every character following whitespace starts a token, so the next token
+    // in the index is the next non-whitespace character.
+    context->crnt_posn = ( index_seek( context ) ) ? &context->json_str[context->index[context->index_posn]] : context->json_end;
     }
-
-for( i = 0; ( string_in[i] != '\0' ) && ( isspace( string_in[i] ) ); i++ )
-    ;
-
-return &string_in[i];
 }
\ No newline at end of file
@@ -0,0 +1,419 @@
+/*
+ * Contains the compiled path queries. A JSON Pointer (RFC 6901), which may use
+ * "*" as a reference token for every item of an array or member of an object,
+ * is decoded once into a list of steps, each with its key already unescaped
+ * and hashed and its array index already converted. Running the query walks
+ * each document once and collects every value the path reaches, in document
+ * order.
+ */
+
+#include <limits.h>
+#include <string.h>
+
+#include "cJSON2.h"
+#include "cJSON2_private.h"
+
+/****************************************
+Private Types
+****************************************/
+typedef enum
+    {
+    QUERY_STEP_MEMBER,              /* The member or item named by the token */
+    QUERY_STEP_WILDCARD             /* Every member or item                  */
+    } query_step_type;
+
+typedef struct
+    {
+    query_step_type type;
+    char const *    key;            /* Unescaped reference token            */
+    uint32_t        hash;           /* key_hash() of the key                */
+    size_t          index;          /* Array index the key names, or        */
+                                    /* SIZE_MAX if it names none            */
+    } query_step;
+
+struct cJSON_Query
+    {
+    cJSON_Hooks     hooks;
+    size_t          step_cnt;
+    query_step *    steps;          /* Followed by the text of the keys     */
+    };
+
+typedef struct
+    {
+    cJSON_Query const * query;
+    cJSON **            matches;
+    size_t              match_max;
+    size_t              match_cnt;  /* Every match, even those not stored   */
+    } query_run;
+
+
+/****************************************
+Private Function Declarations
+****************************************/
+static cJSON * query_array_item
+    (
+    cJSON const *   array,
+    size_t          index
+    );
+
+static cJSON * query_object_item
+    (
+    cJSON const *       object,
+    query_step const *  step
+    );
+
+static void query_run_step
+    (
+    query_run *     run,
+    cJSON const *   node,
+    size_t          step
+    );
+
+static size_t query_token_index
+    (
+    char const *    token,
+    size_t          token_len
+    );
+
+
+/****************************************
+Public Functions
+****************************************/
+
+/**********************************************************
+*	cJSON_QueryCompile
+*
+*	Compiles a path query, using default hooks.
+*
+**********************************************************/
+cJSON_Query * cJSON_QueryCompile
+    (
+    char const * path
+    )
+{
+cJSON_Hooks default_hooks;
+
+default_hooks.malloc_fn  = malloc;
+default_hooks.realloc_fn = realloc;
+default_hooks.free_fn    = free;
+
+return cJSON_QueryCompileWithHooks( path, &default_hooks );
+}
+
+
+/**********************************************************
+*	cJSON_QueryCompileWithHooks
+*
+*	Compiles a JSON Pointer into a query that can be run
+*   against any number of documents. A reference token of
+*   "*" stands for every item of an array or member of an
+*   object. Returns NULL if the pointer is not valid or
+*   memory runs out. Otherwise, the caller must free the
+*   returned pointer with cJSON_QueryDelete().
+*
+**********************************************************/
+cJSON_Query * cJSON_QueryCompileWithHooks
+    (
+    char const *        path,
+    cJSON_Hooks const * hooks
+    )
+{
+cJSON_Query *   query;
+query_step *    step;
+char *          key;
+char const *    crnt_char;
+size_t          step_cnt;
+size_t          path_len;
+
+if( ( NULL == path ) || ( NULL == hooks ) )
+    {
+    return NULL;
+    }
+else if( ( '\0' != path[0] ) && ( '/' != path[0] ) )
+    {
+    return NULL;
+    }
+
+path_len = strlen( path );
+step_cnt = 0;
+for( crnt_char = path; '\0' != *crnt_char; crnt_char++ )
+    {
+    if( '/' == *crnt_char )
+        {
+        step_cnt++;
+        }
+    else if( ( '~' == crnt_char[0] ) && ( '0' != crnt_char[1] ) && ( '1' != crnt_char[1] ) )
+        {
+        return NULL;
+        }
+    }
+
+// The steps and the keys they point to share one block. Every key is no
+// longer than its token, and takes the place of the '/' before it with its
+// terminator.
+query = (cJSON_Query*)hooks->malloc_fn( sizeof( *query ) + step_cnt * sizeof( *query->steps ) + path_len + 1 );
+if( NULL == query )
+    {
+    return NULL;
+    }
+
+query->hooks    = *hooks;
+query->step_cnt = step_cnt;
+query->steps    = (query_step*)&query[1];
+key             = (char*)&query->steps[step_cnt];
+
+for( step = query->steps, crnt_char = path; '\0' != *crnt_char; step++ )
+    {
+    step->key = key;
+
+    // Step over the '/' and unescape the token, where "~1" stands for '/' and
+    // "~0" for '~'.
+    for( crnt_char++; ( '\0' != *crnt_char ) && ( '/' != *crnt_char ); crnt_char++ )
+        {
+        if( '~' == *crnt_char )
+            {
+            crnt_char++;
+            *key++ = ( '0' == *crnt_char ) ? '~' : '/';
+            }
+        else
+            {
+            *key++ = *crnt_char;
+            }
+        }
+    *key++ = '\0';
+
+    step->type  = ( 0 == strcmp( step->key, "*" ) ) ? QUERY_STEP_WILDCARD : QUERY_STEP_MEMBER;
+    step->hash  = key_hash( step->key, strlen( step->key ) );
+    step->index = query_token_index( step->key, strlen( step->key ) );
+    }
+
+return query;
+}
+
+
+/**********************************************************
+*	cJSON_QueryDelete
+*
+*	Frees a compiled query.
+*
+**********************************************************/
+void cJSON_QueryDelete
+    (
+    cJSON_Query * query
+    )
+{
+if( NULL != query )
+    {
+    query->hooks.free_fn( query );
+    }
+}
+
+
+/**********************************************************
+*	cJSON_QueryRun
+*
+*	Finds every value that a compiled query reaches in a
+*   document, in document order, with one walk. Up to
+*   match_max of them are stored in matches, which may be
+*   NULL if match_max is 0. Returns the number of values
+*   found, which may be more than match_max.
+*
+**********************************************************/
+size_t cJSON_QueryRun
+    (
+    cJSON_Query const * query,
+    cJSON const *       json,
+    cJSON **            matches,
+    size_t              match_max
+    )
+{
+query_run run;
+
+if( ( NULL == query ) || ( NULL == json ) )
+    {
+    return 0;
+    }
+
+run.query     = query;
+run.matches   = matches;
+run.match_max = ( NULL == matches ) ? 0 : match_max;
+run.match_cnt = 0;
+
+query_run_step( &run, json, 0 );
+
+return run.match_cnt;
+}
+
+
+/****************************************
+Private Functions
+****************************************/
+
+/**********************************************************
+*	query_array_item
+*
+*	Returns the item of an array at the provided index, or
+*   NULL if there is none.
+*
+**********************************************************/
+static cJSON * query_array_item
+    (
+    cJSON const *   array,
+    size_t          index
+    )
+{
+cJSON * item;
+
+if( index >= (size_t)array->valueint )
+    {
+    return NULL;
+    }
+else if( array->flags & cJSON_IsIndexed )
+    {
+    return array_index_item( array_index_from_node( array ), index );
+    }
+
+for( item = array->child; 0 != index; index-- )
+    {
+    item = item->next;
+    }
+
+return item;
+}
+
+
+/**********************************************************
+*	query_object_item
+*
+*	Returns the first member of an object with the step's
+*   key, or NULL if there is none.
+*
+**********************************************************/
+static cJSON * query_object_item
+    (
+    cJSON const *       object,
+    query_step const *  step
+    )
+{
+cJSON * item;
+
+if( object->flags & cJSON_IsIndexed )
+    {
+    return object_index_find( object, step->key, step->hash );
+    }
+
+for( item = object->child; NULL != item; item = item->next )
+    {
+    if( 0 == strcmp( step->key, item->string ) )
+        {
+        return item;
+        }
+    }
+
+return NULL;
+}
+
+
+/**********************************************************
+*	query_run_step
+*
+*	Matches the query's steps, from the provided one on,
+*   against a node, recording the node itself if there are
+*   none left.
+*
+**********************************************************/
+static void query_run_step
+    (
+    query_run *     run,
+    cJSON const *   node,
+    size_t          step
+    )
+{
+query_step const *  crnt_step;
+cJSON *             item;
+
+if( step == run->query->step_cnt )
+    {
+    if( run->match_cnt < run->match_max )
+        {
+        run->matches[run->match_cnt] = (cJSON*)node;
+        }
+    run->match_cnt++;
+    return;
+    }
+
+if( ( cJSON_Array != node->type ) && ( cJSON_Object != node->type ) )
+    {
+    return;
+    }
+else if( ( node->flags & cJSON_IsLazy ) && ( !lazy_container_materialize( (cJSON*)node ) ) )
+    {
+    return;
+    }
+
+crnt_step = &run->query->steps[step];
+
+if( QUERY_STEP_WILDCARD == crnt_step->type )
+    {
+    for( item = node->child; NULL != item; item = item->next )
+        {
+        query_run_step( run, item, step + 1 );
+        }
+    return;
+    }
+
+if( cJSON_Array == node->type )
+    {
+    item = ( SIZE_MAX == crnt_step->index ) ? NULL : query_array_item( node, crnt_step->index );
+    }
+else
+    {
+    item = query_object_item( node, crnt_step );
+    }
+
+if( NULL != item )
+    {
+    query_run_step( run, item, step + 1 );
+    }
+}
+
+
+/**********************************************************
+*	query_token_index
+*
+*	Returns the array index a reference token names, or
+*   SIZE_MAX if it names none. Array indexes are decimal
+*   without leading zeros, and no array holds more than
+*   INT_MAX items.
+*
+**********************************************************/
+static size_t query_token_index
+    (
+    char const *    token,
+    size_t          token_len
+    )
+{
+size_t  index;
+size_t  i;
+
+if( ( 0 == token_len ) || ( ( '0' == token[0] ) && ( 1 != token_len ) ) )
+    {
+    return SIZE_MAX;
+    }
+
+for( index = 0, i = 0; i < token_len; i++ )
+    {
+    if( ( token[i] < '0' ) || ( token[i] > '9' ) )
+        {
+        return SIZE_MAX;
+        }
+
+    index = 10 * index + ( token[i] - '0' );
+    if( index > INT_MAX )
+        {
+        return SIZE_MAX;
+        }
+    }
+
+return index;
+}
@@ -0,0 +1,534 @@
+/*
+ * Contains the byte-scanning kernels used in the parser's hot loops. Where the
+ * target supports it, these examine a whole SSE2 (16 byte) or AVX2 (32 byte)
+ * block per step; otherwise they fall back to a byte-at-a-time loop.
+ */
+
+#include <stdint.h>
+
+#include "cJSON2_private.h"
+
+#if defined( __AVX2__ )
+    #include <immintrin.h>
+    #define SCAN_BLOCK_SIZE     ( 32 )
+#elif defined( __SSE2__ )
+    #include <emmintrin.h>
+    #define SCAN_BLOCK_SIZE     ( 16 )
+#endif
+
+/*
+ * Block loads are aligned so that they never cross a page boundary, which
+ * means they may read a few bytes before or after the string being scanned,
+ * even when it is not null-terminated. Those bytes are masked off, but the
+ * sanitizers cannot know that.
+ */
+#if defined( SCAN_BLOCK_SIZE ) && defined( __GNUC__ )
+    #define SCAN_NO_SANITIZE    __attribute__(( no_sanitize_address ))
+#else
+    #define SCAN_NO_SANITIZE
+#endif
+
+/****************************************
+Private Function Declarations
+****************************************/
+static char const * scan_bracket_or_quote
+    (
+    char const * string_in,
+    char const * string_end
+    );
+
+#if defined( SCAN_BLOCK_SIZE )
+static uint32_t bracket_or_quote_mask
+    (
+    char const * block
+    );
+
+static int first_set_bit
+    (
+    uint32_t mask
+    );
+
+static uint32_t non_whitespace_mask
+    (
+    char const * block
+    );
+
+static uint32_t string_plain_end_mask
+    (
+    char const * block
+    );
+
+static uint32_t string_special_mask
+    (
+    char const * block
+    );
+#endif
+
+
+/**********************************************************
+*	scan_container_end
+*
+*	Returns a pointer just past the bracket that closes the
+*   array or object starting at the provided position, or
+*   NULL if it is not closed before string_end or contains
+*   an invalid string. Only brackets and strings are looked
+*   at, so the rest of the container's grammar is unchecked.
+*
+**********************************************************/
+char const * scan_container_end
+    (
+    char const * container,
+    char const * string_end
+    )
+{
+char const *    crnt_char;
+size_t          depth;
+
+depth     = 0;
+crnt_char = container;
+
+for( ;; )
+    {
+    crnt_char = scan_bracket_or_quote( crnt_char, string_end );
+
+    if( crnt_char == string_end )
+        {
+        return NULL;
+        }
+    else if( '\"' == *crnt_char )
+        {
+        // Step over the string, along with any escaped characters in it.
+        crnt_char = scan_string( &crnt_char[1], string_end );
+        while( ( crnt_char + 1 < string_end ) && ( '\\' == *crnt_char ) )
+            {
+            crnt_char = scan_string( &crnt_char[2], string_end );
+            }
+
+        if( ( crnt_char >= string_end ) || ( '\"' != *crnt_char ) )
+            {
+            return NULL;
+            }
+        }
+    else if( ( '[' == *crnt_char ) || ( '{' == *crnt_char ) )
+        {
+        depth++;
+        }
+    else if( 0 == --depth )
+        {
+        return &crnt_char[1];
+        }
+
+    crnt_char++;
+    }
+}
+
+
+/**********************************************************
+*	scan_string
+*
+*	Returns a pointer to the first character at or after the
+*   provided position that needs attention inside a JSON
+*   string: a '"', a '\' or a control character. Returns
+*   string_end if there is no such character.
+*
+**********************************************************/
+SCAN_NO_SANITIZE char const * scan_string
+    (
+    char const * string_in,
+    char const * string_end
+    )
+{
+#if defined( SCAN_BLOCK_SIZE )
+char const *    block;
+char const *    found;
+uintptr_t       offset;
+uint32_t        mask;
+
+if( string_in >= string_end )
+    {
+    return string_end;
+    }
+
+// Examine the aligned block containing the first character, ignoring the
+// bytes that come before it.
+offset = (uintptr_t)string_in & ( SCAN_BLOCK_SIZE - 1 );
+block  = string_in - offset;
+mask   = string_special_mask( block ) >> offset;
+found  = string_in;
+
+while( 0 == mask )
+    {
+    block += SCAN_BLOCK_SIZE;
+    if( block >= string_end )
+        {
+        return string_end;
+        }
+
+    mask  = string_special_mask( block );
+    found = block;
+    }
+
+// The block may extend past the end of the string.
+found += first_set_bit( mask );
+return ( found < string_end ) ? found : string_end;
+#else
+while( ( string_in < string_end ) && ( '\"' != *string_in ) && ( '\\' != *string_in ) && ( (unsigned char)*string_in >= 0x20 ) )
+    {
+    string_in++;
+    }
+
+return string_in;
+#endif
+}
+
+
+/**********************************************************
+*	scan_string_plain
+*
+*	Returns a pointer to the first character at or after the
+*   provided position that can't be copied straight out of a
+*   JSON string: a '"', a '\', a control character or any
+*   non-ASCII byte. Returns string_end if there is no such
+*   character.
+*
+**********************************************************/
+SCAN_NO_SANITIZE char const * scan_string_plain
+    (
+    char const * string_in,
+    char const * string_end
+    )
+{
+#if defined( SCAN_BLOCK_SIZE )
+char const *    block;
+char const *    found;
+uintptr_t       offset;
+uint32_t        mask;
+
+if( string_in >= string_end )
+    {
+    return string_end;
+    }
+
+offset = (uintptr_t)string_in & ( SCAN_BLOCK_SIZE - 1 );
+block  = string_in - offset;
+mask   = string_plain_end_mask( block ) >> offset;
+found  = string_in;
+
+while( 0 == mask )
+    {
+    block += SCAN_BLOCK_SIZE;
+    if( block >= string_end )
+        {
+        return string_end;
+        }
+
+    mask  = string_plain_end_mask( block );
+    found = block;
+    }
+
+// The block may extend past the end of the string.
+found += first_set_bit( mask );
+return ( found < string_end ) ? found : string_end;
+#else
+while( ( string_in < string_end ) && ( '\"' != *string_in ) && ( '\\' != *string_in ) && ( (unsigned char)*string_in >= 0x20 ) && ( (unsigned char)*string_in < 0x80 ) )
+    {
+    string_in++;
+    }
+
+return string_in;
+#endif
+}
+
+
+/**********************************************************
+*	scan_whitespace
+*
+*	Returns a pointer to the first non-whitespace character
+*   at or after the provided position, or string_end if the
+*   rest of the string is whitespace.
+*
+**********************************************************/
+SCAN_NO_SANITIZE char const * scan_whitespace
+    (
+    char const * string_in,
+    char const * string_end
+    )
+{
+#if defined( SCAN_BLOCK_SIZE )
+char const *    block;
+char const *    found;
+uintptr_t       offset;
+uint32_t        mask;
+
+// Most values are separated by at most a single space, so check the first
+// character before paying for a block compare.
+if( ( string_in >= string_end ) || ( !is_json_whitespace( string_in[0] ) ) )
+    {
+    return string_in;
+    }
+
+offset = (uintptr_t)string_in & ( SCAN_BLOCK_SIZE - 1 );
+block  = string_in - offset;
+mask   = non_whitespace_mask( block ) >> offset;
+found  = string_in;
+
+while( 0 == mask )
+    {
+    block += SCAN_BLOCK_SIZE;
+    if( block >= string_end )
+        {
+        return string_end;
+        }
+
+    mask  = non_whitespace_mask( block );
+    found = block;
+    }
+
+// The block may extend past the end of the string.
+found += first_set_bit( mask );
+return ( found < string_end ) ? found : string_end;
+#else
+while( ( string_in < string_end ) && ( is_json_whitespace( *string_in ) ) )
+    {
+    string_in++;
+    }
+
+return string_in;
+#endif
+}
+
+
+/**********************************************************
+*	scan_bracket_or_quote
+*
+*	Returns a pointer to the first '"', '[', ']', '{' or '}'
+*   at or after the provided position, or string_end if there
+*   is no such character.
+*
+**********************************************************/
+SCAN_NO_SANITIZE static char const * scan_bracket_or_quote
+    (
+    char const * string_in,
+    char const * string_end
+    )
+{
+#if defined( SCAN_BLOCK_SIZE )
+char const *    block;
+char const *    found;
+uintptr_t       offset;
+uint32_t        mask;
+
+if( string_in >= string_end )
+    {
+    return string_end;
+    }
+
+offset = (uintptr_t)string_in & ( SCAN_BLOCK_SIZE - 1 );
+block  = string_in - offset;
+mask   = bracket_or_quote_mask( block ) >> offset;
+found  = string_in;
+
+while( 0 == mask )
+    {
+    block += SCAN_BLOCK_SIZE;
+    if( block >= string_end )
+        {
+        return string_end;
+        }
+
+    mask  = bracket_or_quote_mask( block );
+    found = block;
+    }
+
+// The block may extend past the end of the string.
+found += first_set_bit( mask );
+return ( found < string_end ) ? found : string_end;
+#else
+while( ( string_in < string_end ) && ( '\"' != *string_in ) && ( '[' != *string_in ) && ( ']' != *string_in ) && ( '{' != *string_in ) && ( '}' != *string_in ) )
+    {
+    string_in++;
+    }
+
+return string_in;
+#endif
+}
+
+
+#if defined( SCAN_BLOCK_SIZE )
+
+/**********************************************************
+*	bracket_or_quote_mask
+*
+*	Returns a mask with bit i set if byte i of the aligned
+*   block is a '"', '[', ']', '{' or '}'.
+*
+**********************************************************/
+SCAN_NO_SANITIZE static uint32_t bracket_or_quote_mask
+    (
+    char const * block
+    )
+{
+#if defined( __AVX2__ )
+__m256i chars;
+__m256i is_special;
+
+chars      = _mm256_load_si256( (__m256i const *)block );
+is_special = _mm256_or_si256(
+    _mm256_or_si256( _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( '\"' ) ), _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( '[' ) ) ),
+    _mm256_or_si256( _mm256_or_si256( _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( ']' ) ), _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( '{' ) ) ),
+                     _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( '}' ) ) ) );
+
+return (uint32_t)_mm256_movemask_epi8( is_special );
+#else
+__m128i chars;
+__m128i is_special;
+
+chars      = _mm_load_si128( (__m128i const *)block );
+is_special = _mm_or_si128(
+    _mm_or_si128( _mm_cmpeq_epi8( chars, _mm_set1_epi8( '\"' ) ), _mm_cmpeq_epi8( chars, _mm_set1_epi8( '[' ) ) ),
+    _mm_or_si128( _mm_or_si128( _mm_cmpeq_epi8( chars, _mm_set1_epi8( ']' ) ), _mm_cmpeq_epi8( chars, _mm_set1_epi8( '{' ) ) ),
+                  _mm_cmpeq_epi8( chars, _mm_set1_epi8( '}' ) ) ) );
+
+return (uint32_t)_mm_movemask_epi8( is_special );
+#endif
+}
+
+
+/**********************************************************
+*	first_set_bit
+*
+*	Returns the index of the lowest set bit in a non-zero
+*   mask.
+*
+**********************************************************/
+static int first_set_bit
+    (
+    uint32_t mask
+    )
+{
+#if defined( __GNUC__ )
+return __builtin_ctz( mask );
+#else
+int idx;
+
+for( idx = 0; 0 == ( mask & 1 ); idx++ )
+    {
+    mask >>= 1;
+    }
+
+return idx;
+#endif
+}
+
+
+/**********************************************************
+*	non_whitespace_mask
+*
+*	Returns a mask with bit i set if byte i of the aligned
+*   block is not JSON whitespace.
+*
+**********************************************************/
+SCAN_NO_SANITIZE static uint32_t non_whitespace_mask
+    (
+    char const * block
+    )
+{
+#if defined( __AVX2__ )
+__m256i chars;
+__m256i is_space;
+
+chars    = _mm256_load_si256( (__m256i const *)block );
+is_space = _mm256_or_si256(
+    _mm256_or_si256( _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( ' ' ) ), _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( '\n' ) ) ),
+    _mm256_or_si256( _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( '\r' ) ), _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( '\t' ) ) ) );
+
+return ~(uint32_t)_mm256_movemask_epi8( is_space );
+#else
+__m128i chars;
+__m128i is_space;
+
+chars    = _mm_load_si128( (__m128i const *)block );
+is_space = _mm_or_si128(
+    _mm_or_si128( _mm_cmpeq_epi8( chars, _mm_set1_epi8( ' ' ) ), _mm_cmpeq_epi8( chars, _mm_set1_epi8( '\n' ) ) ),
+    _mm_or_si128( _mm_cmpeq_epi8( chars, _mm_set1_epi8( '\r' ) ), _mm_cmpeq_epi8( chars, _mm_set1_epi8( '\t' ) ) ) );
+
+return ~(uint32_t)_mm_movemask_epi8( is_space ) & 0xFFFF;
+#endif
+}
+
+
+/**********************************************************
+*	string_plain_end_mask
+*
+*	Returns a mask with bit i set if byte i of the aligned
+*   block is a '"', a '\', a control character or a non-ASCII
+*   byte.
+*
+**********************************************************/
+SCAN_NO_SANITIZE static uint32_t string_plain_end_mask
+    (
+    char const * block
+    )
+{
+#if defined( __AVX2__ )
+__m256i chars;
+__m256i is_special;
+
+// Non-ASCII bytes have their top bit set, which is all movemask looks at.
+chars      = _mm256_load_si256( (__m256i const *)block );
+is_special = _mm256_or_si256(
+    _mm256_or_si256( _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( '\"' ) ), _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( '\\' ) ) ),
+    _mm256_or_si256( _mm256_cmpeq_epi8( _mm256_max_epu8( chars, _mm256_set1_epi8( 0x1F ) ), _mm256_set1_epi8( 0x1F ) ), chars ) );
+
+return (uint32_t)_mm256_movemask_epi8( is_special );
+#else
+__m128i chars;
+__m128i is_special;
+
+// Non-ASCII bytes have their top bit set, which is all movemask looks at.
+chars      = _mm_load_si128( (__m128i const *)block );
+is_special = _mm_or_si128(
+    _mm_or_si128( _mm_cmpeq_epi8( chars, _mm_set1_epi8( '\"' ) ), _mm_cmpeq_epi8( chars, _mm_set1_epi8( '\\' ) ) ),
+    _mm_or_si128( _mm_cmpeq_epi8( _mm_max_epu8( chars, _mm_set1_epi8( 0x1F ) ), _mm_set1_epi8( 0x1F ) ), chars ) );
+
+return (uint32_t)_mm_movemask_epi8( is_special );
+#endif
+}
+
+
+/**********************************************************
+*	string_special_mask
+*
+*	Returns a mask with bit i set if byte i of the aligned
+*   block is a '"', a '\' or a control character.
+*
+**********************************************************/
+SCAN_NO_SANITIZE static uint32_t string_special_mask
+    (
+    char const * block
+    )
+{
+#if defined( __AVX2__ )
+__m256i chars;
+__m256i is_special;
+
+chars      = _mm256_load_si256( (__m256i const *)block );
+is_special = _mm256_or_si256(
+    _mm256_or_si256( _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( '\"' ) ), _mm256_cmpeq_epi8( chars, _mm256_set1_epi8( '\\' ) ) ),
+    _mm256_cmpeq_epi8( _mm256_max_epu8( chars, _mm256_set1_epi8( 0x1F ) ), _mm256_set1_epi8( 0x1F ) ) );
+
+return (uint32_t)_mm256_movemask_epi8( is_special );
+#else
+__m128i chars;
+__m128i is_special;
+
+chars      = _mm_load_si128( (__m128i const *)block );
+is_special = _mm_or_si128(
+    _mm_or_si128( _mm_cmpeq_epi8( chars, _mm_set1_epi8( '\"' ) ), _mm_cmpeq_epi8( chars, _mm_set1_epi8( '\\' ) ) ),
+    _mm_cmpeq_epi8( _mm_max_epu8( chars, _mm_set1_epi8( 0x1F ) ), _mm_set1_epi8( 0x1F ) ) );
+
+return (uint32_t)_mm_movemask_epi8( is_special );
+#endif
+}
+
+#endif
@@ -0,0 +1,785 @@
+/*
+ * Contains the path-selective parser, which builds nodes only for the values
+ * named by a set of JSON Pointers (RFC 6901) and for their ancestors. Other
+ * values are stepped over by the allocation-free scanners and are only checked
+ * for balanced brackets and well-formed strings.
+ */
+
+#include <string.h>
+
+#include "cJSON2.h"
+#include "cJSON2_private.h"
+
+/****************************************
+Private Types
+****************************************/
+typedef struct
+    {
+    char const *    pointer;
+    char const *    segment;        /* Next reference token, NULL once all matched */
+    size_t          depth;          /* Number of reference tokens matched          */
+    } select_path;
+
+typedef struct
+    {
+    char const *    crnt_posn;
+    char const *    json_end;
+    cJSON_Hooks     hooks;
+    select_path *   paths;
+    size_t          path_cnt;
+    int             is_error;
+    } select_context;
+
+
+/****************************************
+Private Function Declarations
+****************************************/
+static void item_append
+    (
+    cJSON * container,
+    cJSON * item
+    );
+
+static cJSON * new_container
+    (
+    select_context *    context,
+    cJSON_ValueType     type
+    );
+
+static int paths_advance
+    (
+    select_context *    context,
+    size_t              depth,
+    char const *        key,
+    size_t              key_len,
+    size_t              index
+    );
+
+static void paths_restore
+    (
+    select_context *    context,
+    size_t              depth
+    );
+
+static int pointer_segment_matches
+    (
+    char const *    segment,
+    char const *    key,
+    size_t          key_len,
+    size_t          index
+    );
+
+static cJSON * select_array
+    (
+    select_context *    context,
+    size_t              depth
+    );
+
+static int select_char
+    (
+    select_context *    context,
+    char                expected
+    );
+
+static char const * select_key
+    (
+    select_context *    context,
+    size_t *            key_len_out
+    );
+
+static cJSON * select_object
+    (
+    select_context *    context,
+    size_t              depth
+    );
+
+static cJSON * select_value
+    (
+    select_context *    context,
+    size_t              depth
+    );
+
+static char const * select_value_end
+    (
+    select_context *    context
+    );
+
+
+/****************************************
+Public Functions
+****************************************/
+
+/**********************************************************
+*	cJSON_ParseSelect
+*
+*	Parse only the parts of the first json_len characters of
+*   a JSON string selected by the provided JSON Pointers,
+*   using default hooks.
+*
+**********************************************************/
+cJSON * cJSON_ParseSelect
+    (
+    char const *            json_str,
+    size_t                  json_len,
+    char const * const *    paths,
+    size_t                  path_cnt
+    )
+{
+cJSON_Hooks default_hooks;
+
+default_hooks.malloc_fn  = malloc;
+default_hooks.realloc_fn = realloc;
+default_hooks.free_fn    = free;
+
+if( NULL == json_str )
+    {
+    return NULL;
+    }
+
+return cJSON_ParseSelectWithHooks( json_str, json_len, paths, path_cnt, &default_hooks );
+}
+
+
+/**********************************************************
+*	cJSON_ParseSelectWithHooks
+*
+*	Parse the first json_len characters of a JSON string,
+*   building only the values selected by the provided JSON
+*   Pointers along with their ancestors. Selected values that
+*   do not exist are left out. Arrays hold only their
+*   selected items, so those are renumbered from 0: "/list/5"
+*   is item 0 of "list" if it is the only one selected. On
+*   error, this returns NULL.
+*   Otherwise, the caller must free the returned pointer with
+*   cJSON_DeleteWithHooks().
+*
+**********************************************************/
+cJSON * cJSON_ParseSelectWithHooks
+    (
+    char const *            json_str,
+    size_t                  json_len,
+    char const * const *    paths,
+    size_t                  path_cnt,
+    cJSON_Hooks const *     hooks
+    )
+{
+select_context  context;
+cJSON *         root;
+size_t          i;
+
+if( ( NULL == json_str ) || ( ( NULL == paths ) && ( 0 != path_cnt ) ) )
+    {
+    return NULL;
+    }
+
+memset( &context, 0, sizeof( context ) );
+context.crnt_posn = json_str;
+context.json_end  = &json_str[json_len];
+context.hooks     = *hooks;
+context.path_cnt  = path_cnt;
+context.paths     = (select_path*)hooks->malloc_fn( ( path_cnt + 1 ) * sizeof( *context.paths ) );
+
+if( NULL == context.paths )
+    {
+    return NULL;
+    }
+
+for( i = 0; i < path_cnt; i++ )
+    {
+    // A pointer is either empty, selecting the whole document, or a sequence
+    // of '/'-prefixed reference tokens.
+    if( ( NULL == paths[i] ) || ( ( '\0' != paths[i][0] ) && ( '/' != paths[i][0] ) ) )
+        {
+        hooks->free_fn( context.paths );
+        return NULL;
+        }
+
+    context.paths[i].pointer = paths[i];
+    context.paths[i].segment = ( '\0' == paths[i][0] ) ? NULL : &paths[i][1];
+    context.paths[i].depth   = 0;
+    }
+
+root = select_value( &context, 0 );
+
+// Only whitespace may follow the document.
+context.crnt_posn = scan_whitespace( context.crnt_posn, context.json_end );
+if( ( NULL == root ) || ( context.crnt_posn != context.json_end ) )
+    {
+    context.is_error = 1;
+    }
+
+hooks->free_fn( context.paths );
+
+if( context.is_error )
+    {
+    cJSON_DeleteWithHooks( root, hooks );
+    return NULL;
+    }
+
+return root;
+}
+
+
+/****************************************
+Private Functions
+****************************************/
+
+/**********************************************************
+*	item_append
+*
+*	Adds an item to the end of a container's items.
+*
+**********************************************************/
+static void item_append
+    (
+    cJSON * container,
+    cJSON * item
+    )
+{
+cJSON * last;
+
+item->parent = container;
+container->valueint++;
+
+if( NULL == container->child )
+    {
+    container->child = item;
+    return;
+    }
+
+for( last = container->child; NULL != last->next; last = last->next )
+    ;
+
+last->next = item;
+item->prev = last;
+}
+
+
+/**********************************************************
+*	new_container
+*
+*	Creates an empty array or object node.
+*
+**********************************************************/
+static cJSON * new_container
+    (
+    select_context *    context,
+    cJSON_ValueType     type
+    )
+{
+cJSON * node;
+
+node = (cJSON*)context->hooks.malloc_fn( sizeof( *node ) );
+if( NULL == node )
+    {
+    context->is_error = 1;
+    return NULL;
+    }
+
+memset( node, 0, sizeof( *node ) );
+node->type = type;
+
+return node;
+}
+
+
+/**********************************************************
+*	paths_advance
+*
+*	Moves every path that has matched depth tokens and whose
+*   next token names the provided key or array index on to
+*   its following token. Returns the number of paths moved.
+*
+**********************************************************/
+static int paths_advance
+    (
+    select_context *    context,
+    size_t              depth,
+    char const *        key,
+    size_t              key_len,
+    size_t              index
+    )
+{
+select_path *   path;
+char const *    next_segment;
+size_t          i;
+int             advanced_cnt;
+
+advanced_cnt = 0;
+
+for( i = 0; i < context->path_cnt; i++ )
+    {
+    path = &context->paths[i];
+
+    if( ( depth == path->depth ) && ( NULL != path->segment ) && ( pointer_segment_matches( path->segment, key, key_len, index ) ) )
+        {
+        next_segment  = strchr( path->segment, '/' );
+        path->segment = ( NULL == next_segment ) ? NULL : &next_segment[1];
+        path->depth++;
+        advanced_cnt++;
+        }
+    }
+
+return advanced_cnt;
+}
+
+
+/**********************************************************
+*	paths_restore
+*
+*	Undoes paths_advance() for every path that was moved past
+*   depth tokens.
+*
+**********************************************************/
+static void paths_restore
+    (
+    select_context *    context,
+    size_t              depth
+    )
+{
+select_path *   path;
+size_t          i;
+size_t          j;
+
+for( i = 0; i < context->path_cnt; i++ )
+    {
+    path = &context->paths[i];
+
+    if( depth + 1 == path->depth )
+        {
+        // Find the token that was matched by counting from the start.
+        path->segment = &path->pointer[1];
+        for( j = 0; j < depth; j++ )
+            {
+            path->segment = strchr( path->segment, '/' ) + 1;
+            }
+        path->depth = depth;
+        }
+    }
+}
+
+
+/**********************************************************
+*	pointer_segment_matches
+*
+*	Returns 1 if a JSON Pointer reference token names the
+*   provided object key, or, if key is NULL, the provided
+*   array index.
+*
+**********************************************************/
+static int pointer_segment_matches
+    (
+    char const *    segment,
+    char const *    key,
+    size_t          key_len,
+    size_t          index
+    )
+{
+size_t  segment_index;
+char    segment_char;
+
+if( NULL == key )
+    {
+    // Array indexes are decimal without leading zeros.
+    if( ( '0' == segment[0] ) && ( ( '\0' == segment[1] ) || ( '/' == segment[1] ) ) )
+        {
+        return ( 0 == index );
+        }
+    else if( ( segment[0] < '1' ) || ( segment[0] > '9' ) )
+        {
+        return 0;
+        }
+
+    for( segment_index = 0; ( segment[0] >= '0' ) && ( segment[0] <= '9' ); segment++ )
+        {
+        segment_index = 10 * segment_index + ( segment[0] - '0' );
+        }
+
+    return ( ( '\0' == segment[0] ) || ( '/' == segment[0] ) ) && ( segment_index == index );
+    }
+
+while( ( '\0' != segment[0] ) && ( '/' != segment[0] ) )
+    {
+    // "~1" stands for '/' and "~0" for '~'.
+    segment_char = segment[0];
+    if( ( '~' == segment[0] ) && ( ( '0' == segment[1] ) || ( '1' == segment[1] ) ) )
+        {
+        segment_char = ( '0' == segment[1] ) ? '~' : '/';
+        segment++;
+        }
+
+    if( ( 0 == key_len ) || ( segment_char != key[0] ) )
+        {
+        return 0;
+        }
+
+    segment++;
+    key++;
+    key_len--;
+    }
+
+return ( 0 == key_len );
+}
+
+
+/**********************************************************
+*	select_array
+*
+*	Builds an array holding only the selected items of the
+*   array at the context's position.
+*
+**********************************************************/
+static cJSON * select_array
+    (
+    select_context *    context,
+    size_t              depth
+    )
+{
+cJSON * array;
+cJSON * item;
+size_t  index;
+
+array = new_container( context, cJSON_Array );
+context->crnt_posn++;
+
+if( select_char( context, ']' ) )
+    {
+    return array;
+    }
+
+for( index = 0; ( NULL != array ) && ( !context->is_error ); index++ )
+    {
+    if( paths_advance( context, depth, NULL, 0, index ) )
+        {
+        item = select_value( context, depth + 1 );
+        paths_restore( context, depth );
+
+        if( NULL != item )
+            {
+            item_append( array, item );
+            }
+        }
+    else if( NULL == select_value_end( context ) )
+        {
+        break;
+        }
+
+    if( select_char( context, ']' ) )
+        {
+        if( container_index_build( array, &context->hooks, NULL ) )
+            {
+            return array;
+            }
+        break;
+        }
+    else if( !select_char( context, ',' ) )
+        {
+        context->is_error = 1;
+        }
+    }
+
+cJSON_DeleteWithHooks( array, &context->hooks );
+context->is_error = 1;
+
+return NULL;
+}
+
+
+/**********************************************************
+*	select_char
+*
+*	Skips whitespace and then the expected character if it
+*   is next. Returns 1 if it was.
+*
+**********************************************************/
+static int select_char
+    (
+    select_context *    context,
+    char                expected
+    )
+{
+context->crnt_posn = scan_whitespace( context->crnt_posn, context->json_end );
+
+if( ( context->crnt_posn < context->json_end ) && ( expected == context->crnt_posn[0] ) )
+    {
+    context->crnt_posn++;
+    return 1;
+    }
+
+return 0;
+}
+
+
+/**********************************************************
+*	select_key
+*
+*	Moves past an object key and the ':' following it.
+*   Returns a pointer to the key's first character, or NULL
+*   on error.
+*
+**********************************************************/
+static char const * select_key
+    (
+    select_context *    context,
+    size_t *            key_len_out
+    )
+{
+char const * key;
+char const * key_end;
+
+if( !select_char( context, '\"' ) )
+    {
+    return NULL;
+    }
+
+key     = context->crnt_posn;
+key_end = scan_string( key, context->json_end );
+while( ( key_end + 1 < context->json_end ) && ( '\\' == key_end[0] ) )
+    {
+    key_end = scan_string( &key_end[2], context->json_end );
+    }
+
+if( ( key_end >= context->json_end ) || ( '\"' != key_end[0] ) )
+    {
+    return NULL;
+    }
+
+context->crnt_posn = &key_end[1];
+*key_len_out       = key_end - key;
+
+return ( select_char( context, ':' ) ) ? key : NULL;
+}
+
+
+/**********************************************************
+*	select_object
+*
+*	Builds an object holding only the selected members of
+*   the object at the context's position.
+*
+**********************************************************/
+static cJSON * select_object
+    (
+    select_context *    context,
+    size_t              depth
+    )
+{
+cJSON *         object;
+cJSON *         item;
+char const *    key;
+char *          decoded_key;
+size_t          key_len;
+long            decoded_len;
+int             is_failed;
+
+object = new_container( context, cJSON_Object );
+context->crnt_posn++;
+
+if( select_char( context, '}' ) )
+    {
+    return object;
+    }
+
+while( ( NULL != object ) && ( !context->is_error ) )
+    {
+    key = select_key( context, &key_len );
+    if( NULL == key )
+        {
+        break;
+        }
+
+    // Pointers name keys by their decoded text, so escaped keys are decoded
+    // before they're matched.
+    decoded_key = NULL;
+    if( NULL != memchr( key, '\\', key_len ) )
+        {
+        decoded_key = (char*)context->hooks.malloc_fn( key_len + 1 );
+        if( NULL == decoded_key )
+            {
+            break;
+            }
+
+        decoded_len = string_decode( key, &key[key_len], decoded_key );
+        if( decoded_len < 0 )
+            {
+            context->hooks.free_fn( decoded_key );
+            break;
+            }
+
+        key     = decoded_key;
+        key_len = (size_t)decoded_len;
+        }
+
+    is_failed = 0;
+    if( paths_advance( context, depth, key, key_len, 0 ) )
+        {
+        item = select_value( context, depth + 1 );
+        paths_restore( context, depth );
+
+        if( NULL != item )
+            {
+            item_append( object, item );
+
+            item->string = (char*)context->hooks.malloc_fn( key_len + 1 );
+            is_failed    = ( NULL == item->string );
+            if( !is_failed )
+                {
+                memcpy( item->string, key, key_len );
+                item->string[key_len] = '\0';
+                }
+            }
+        }
+    else
+        {
+        is_failed = ( NULL == select_value_end( context ) );
+        }
+
+    if( NULL != decoded_key )
+        {
+        context->hooks.free_fn( decoded_key );
+        }
+
+    if( is_failed )
+        {
+        break;
+        }
+
+    if( select_char( context, '}' ) )
+        {
+        if( container_index_build( object, &context->hooks, NULL ) )
+            {
+            return object;
+            }
+        break;
+        }
+    else if( !select_char( context, ',' ) )
+        {
+        break;
+        }
+    }
+
+cJSON_DeleteWithHooks( object, &context->hooks );
+context->is_error = 1;
+
+return NULL;
+}
+
+
+/**********************************************************
+*	select_value
+*
+*	Builds the parts of the value at the context's position
+*   selected by paths that have matched depth tokens. Returns
+*   NULL if nothing in it is selected, or on error.
+*
+**********************************************************/
+static cJSON * select_value
+    (
+    select_context *    context,
+    size_t              depth
+    )
+{
+char const *    value;
+char const *    value_end;
+cJSON *         node;
+size_t          i;
+
+context->crnt_posn = scan_whitespace( context->crnt_posn, context->json_end );
+value              = context->crnt_posn;
+
+for( i = 0; i < context->path_cnt; i++ )
+    {
+    if( ( depth == context->paths[i].depth ) && ( NULL == context->paths[i].segment ) )
+        {
+        // This whole value is selected.
+        value_end = select_value_end( context );
+        node      = ( NULL == value_end ) ? NULL : cJSON_ParseWithLength( value, value_end - value, &context->hooks );
+        if( NULL == node )
+            {
+            context->is_error = 1;
+            }
+        return node;
+        }
+    }
+
+if( ( value < context->json_end ) && ( '{' == value[0] ) )
+    {
+    return select_object( context, depth );
+    }
+else if( ( value < context->json_end ) && ( '[' == value[0] ) )
+    {
+    return select_array( context, depth );
+    }
+
+// A selected path runs through a value that has no items.
+if( NULL == select_value_end( context ) )
+    {
+    context->is_error = 1;
+    }
+
+return NULL;
+}
+
+
+/**********************************************************
+*	select_value_end
+*
+*	Moves past the value at the context's position without
+*   building it. Returns the end of the value, or NULL and
+*   sets the error flag if it is malformed.
+*
+**********************************************************/
+static char const * select_value_end
+    (
+    select_context *    context
+    )
+{
+char const *    crnt_char;
+char const *    value_end;
+
+crnt_char = scan_whitespace( context->crnt_posn, context->json_end );
+value_end = NULL;
+
+if( crnt_char == context->json_end )
+    {
+    // No value
+    }
+else if( ( '[' == crnt_char[0] ) || ( '{' == crnt_char[0] ) )
+    {
+    value_end = scan_container_end( crnt_char, context->json_end );
+    }
+else if( '\"' == crnt_char[0] )
+    {
+    value_end = scan_string( &crnt_char[1], context->json_end );
+    while( ( value_end + 1 < context->json_end ) && ( '\\' == value_end[0] ) )
+        {
+        value_end = scan_string( &value_end[2], context->json_end );
+        }
+
+    value_end = ( ( value_end < context->json_end ) && ( '\"' == value_end[0] ) ) ? &value_end[1] : NULL;
+    }
+else
+    {
+    // Numbers and literals run up to the next separator.
+    for( value_end = crnt_char; value_end < context->json_end; value_end++ )
+        {
+        if( ( ',' == value_end[0] ) || ( ']' == value_end[0] ) || ( '}' == value_end[0] ) || ( is_json_whitespace( value_end[0] ) ) )
+            {
+            break;
+            }
+        }
+
+    value_end = ( value_end == crnt_char ) ? NULL : value_end;
+    }
+
+if( NULL == value_end )
+    {
+    context->is_error = 1;
+    }
+else
+    {
+    context->crnt_posn = value_end;
+    }
+
+return value_end;
+}
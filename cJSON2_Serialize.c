@@ -1,4 +1,4 @@
-#include <stdio.h>
+#include <stddef.h>
 #include <string.h>
 
 #include "cJSON2.h"
@@ -22,8 +22,8 @@ typedef enum
 typedef struct
     {
     char *          buffer;         // Note: the buffer does not contain a null-terminator until parsing completes
-    int             buffer_len;
-    int             buffer_posn;    // The index of the next open position in the buffer
+    size_t          buffer_len;
+    size_t          buffer_posn;    // The index of the next open position in the buffer
     cJSON_Hooks     hooks;
     cJSON const *   crnt_node;
     serialize_state state;
@@ -41,7 +41,7 @@ static void buffer_finalize
 static void buffer_grow
     (
     serialize_context * context,
-    int                 growth_increment
+    ptrdiff_t           growth_increment
     );
 
 static void next_array_value
@@ -99,11 +99,17 @@ static void serialize_value
     serialize_context * context
     );
 
+static int string_add_escaped_to_buffer
+    (
+    serialize_context * context,
+    char const *        string
+    );
+
 static int string_add_to_buffer
     (
     serialize_context * context,
     char const *        string,
-    int                 string_len
+    size_t              string_len
     );
 
 
@@ -179,7 +185,7 @@ static void buffer_finalize
     serialize_context * context
     )
 {
-int shrink_amount;
+size_t shrink_amount;
 
 if( context->buffer_posn > context->buffer_len )
     {
@@ -196,7 +202,7 @@ else if( context->buffer_len > context->buffer_posn )
     // Need to shrink the buffer so that it is just large enough to hold
     // all characters plus the null-terminator.
     shrink_amount = context->buffer_len - ( context->buffer_posn + 1 );
-    buffer_grow( context, -shrink_amount );
+    buffer_grow( context, -(ptrdiff_t)shrink_amount );
     }
 
 // Finally, add the null-terminator
@@ -220,7 +226,7 @@ if( SERIALIZE_STATE_ERROR != context->state )
 static void buffer_grow
     (
     serialize_context * context,
-    int                 growth_increment
+    ptrdiff_t           growth_increment
     )
 {
 size_t  new_buffer_len;
@@ -468,27 +474,28 @@ else
 *
 *	Serializes a number into the provided object's buffer
 *
-*	TODO: Handle NaN and Infinity
-*
 **********************************************************/
 static void serialize_number
     (
     serialize_context * context
     )
 {
-char * number_buffer;
-int    bytes_printed;
+char            number_buffer[NUMBER_PRINT_SIZE];
+number_value    value;
+int             bytes_printed;
+
+value.valuedouble = context->crnt_node->valuedouble;
+value.valueint64  = context->crnt_node->valueint64;
+value.is_int64    = ( 0 != ( context->crnt_node->flags & cJSON_IsInt64 ) );
 
-bytes_printed = asprintf( &number_buffer, "%f", context->crnt_node->valuedouble );
+bytes_printed = number_print( &value, number_buffer, sizeof( number_buffer ) );
 if( bytes_printed < 0 )
     {
     context->state = SERIALIZE_STATE_ERROR;
     }
-else
+else if( -1 != string_add_to_buffer( context, number_buffer, bytes_printed ) )
     {
-    string_add_to_buffer( context, number_buffer, bytes_printed );
     next_serialize_state( context );
-    free( number_buffer );
     }
 }
 
@@ -545,9 +552,7 @@ if( NULL == context->crnt_node->string )
 else
     {
     // Add the value's key, surrounded by quotes, to the buffer.
-    success = ( -1 != string_add_to_buffer( context, "\"", 1 ) );
-    success = ( success ) && ( -1 != string_add_to_buffer( context, context->crnt_node->string, strlen( context->crnt_node->string ) ) );
-    success = ( success ) && ( -1 != string_add_to_buffer( context, "\"", 1 ) );
+    success = ( -1 != string_add_escaped_to_buffer( context, context->crnt_node->string ) );
     success = ( success ) && ( -1 != string_add_to_buffer( context, ":", 1 ) );
 
     if( success )
@@ -570,14 +575,8 @@ static void serialize_string
     serialize_context * context
     )
 {
-int success;
-
 // Add the string to the buffer, surrounded by quotes.
-success = ( -1 != string_add_to_buffer( context, "\"", 1 ) );
-success = ( success ) && ( -1 != string_add_to_buffer( context, context->crnt_node->valuestring, strlen( context->crnt_node->valuestring ) ) );
-success = ( success ) && ( -1 != string_add_to_buffer( context, "\"", 1 ) );
-
-if( success )
+if( -1 != string_add_escaped_to_buffer( context, context->crnt_node->valuestring ) )
     {
     next_serialize_state( context );
     }
@@ -595,6 +594,14 @@ static void serialize_value
     serialize_context * context
     )
 {
+if( context->crnt_node->flags & cJSON_IsLazy )
+    {
+    // This container was never accessed, so its original text is still exact.
+    string_add_to_buffer( context, context->crnt_node->valuestring, strlen( context->crnt_node->valuestring ) );
+    next_serialize_state( context );
+    return;
+    }
+
 switch ( context->crnt_node->type )
     {
     case cJSON_True:
@@ -635,6 +642,97 @@ switch ( context->crnt_node->type )
 }
 
 
+/**********************************************************
+*	string_add_escaped_to_buffer
+*
+*	Adds the provided string to the end of the provided
+*	serialize context's buffer as a JSON string, surrounded
+*   by quotes and with quotes, backslashes and control
+*   characters escaped. Other characters are added as they
+*   are. Returns -1 on error, like string_add_to_buffer().
+*
+**********************************************************/
+static int string_add_escaped_to_buffer
+    (
+    serialize_context * context,
+    char const *        string
+    )
+{
+static char const   hex_digits[] = "0123456789abcdef";
+char                escape[6];
+int                 escape_len;
+size_t              run_len;
+int                 rcode;
+
+rcode = string_add_to_buffer( context, "\"", 1 );
+
+while( ( -1 != rcode ) && ( '\0' != *string ) )
+    {
+    // Add everything up to the next character needing an escape at once.
+    for( run_len = 0; ( (unsigned char)string[run_len] >= 0x20 ) && ( '\"' != string[run_len] ) && ( '\\' != string[run_len] ); run_len++ )
+        ;
+
+    rcode   = string_add_to_buffer( context, string, run_len );
+    string += run_len;
+
+    if( ( -1 == rcode ) || ( '\0' == *string ) )
+        {
+        break;
+        }
+
+    escape[0]  = '\\';
+    escape_len = 2;
+
+    switch( *string )
+        {
+        case '\"':
+        case '\\':
+            escape[1] = *string;
+            break;
+
+        case '\b':
+            escape[1] = 'b';
+            break;
+
+        case '\f':
+            escape[1] = 'f';
+            break;
+
+        case '\n':
+            escape[1] = 'n';
+            break;
+
+        case '\r':
+            escape[1] = 'r';
+            break;
+
+        case '\t':
+            escape[1] = 't';
+            break;
+
+        default:
+            escape[1]  = 'u';
+            escape[2]  = '0';
+            escape[3]  = '0';
+            escape[4]  = hex_digits[(unsigned char)*string >> 4];
+            escape[5]  = hex_digits[(unsigned char)*string & 0x0F];
+            escape_len = 6;
+            break;
+        }
+
+    rcode = string_add_to_buffer( context, escape, escape_len );
+    string++;
+    }
+
+if( -1 != rcode )
+    {
+    rcode = string_add_to_buffer( context, "\"", 1 );
+    }
+
+return rcode;
+}
+
+
 /**********************************************************
 *	string_add_to_buffer
 *
@@ -652,15 +750,18 @@ static int string_add_to_buffer
     (
     serialize_context * context,
     char const *        string,
-    int                 string_len
+    size_t              string_len
     )
 {
-int rcode;
+int     rcode;
+size_t  new_len;
 
-// Double the buffer if it is not large enough to hold the provided string.
+// Double the buffer until it is large enough to hold the provided string.
 if( ( context->buffer_posn + string_len ) > context->buffer_len )
     {
-    buffer_grow( context, 2 * context->buffer_len );
+    for( new_len = 2 * context->buffer_len; ( context->buffer_posn + string_len ) > new_len; new_len *= 2 )
+        ;
+    buffer_grow( context, (ptrdiff_t)( new_len - context->buffer_len ) );
     }
 
 if( SERIALIZE_STATE_ERROR == context->state )
@@ -0,0 +1,395 @@
+/*
+ * Contains the string decoder, which turns the text between a JSON string's
+ * quotes into the UTF-8 string it stands for. Runs of plain ASCII are found a
+ * vector block at a time and copied in one go; only escape sequences and
+ * non-ASCII characters are looked at a character at a time.
+ */
+
+#include <string.h>
+
+#include "cJSON2_private.h"
+
+/****************************************
+Private Function Declarations
+****************************************/
+static char const * escape_decode
+    (
+    char const *    escape,
+    char const *    string_end,
+    char *          decoded_out,
+    size_t *        decoded_len_out
+    );
+
+static int hex4_decode
+    (
+    char const *    hex,
+    char const *    string_end,
+    uint32_t *      value_out
+    );
+
+static size_t utf8_encode
+    (
+    uint32_t    code_point,
+    char *      encoded_out
+    );
+
+static size_t utf8_sequence_length
+    (
+    char const *    sequence,
+    char const *    string_end
+    );
+
+
+/****************************************
+Private Variables
+****************************************/
+
+// The character each single-character escape stands for, or 0 if invalid.
+static char const escape_values[256] =
+    {
+    ['\"'] = '\"',
+    ['\\'] = '\\',
+    ['/']  = '/',
+    ['b']  = '\b',
+    ['f']  = '\f',
+    ['n']  = '\n',
+    ['r']  = '\r',
+    ['t']  = '\t',
+    };
+
+// The length of the UTF-8 sequence each byte starts, or 0 if it can't start
+// one. C0 and C1 would only start overlong encodings, and F5 and up would go
+// past U+10FFFF.
+static unsigned char const utf8_lengths[256] =
+    {
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,    /* 00 */
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,    /* 10 */
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,    /* 20 */
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,    /* 30 */
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,    /* 40 */
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,    /* 50 */
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,    /* 60 */
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,    /* 70 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,    /* 80 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,    /* 90 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,    /* A0 */
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,    /* B0 */
+    0, 0, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,    /* C0 */
+    2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2,    /* D0 */
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,    /* E0 */
+    4, 4, 4, 4, 4, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,    /* F0 */
+    };
+
+
+/**********************************************************
+*	string_decode
+*
+*	Decodes the contents of a JSON string, from just after
+*   its opening quote up to string_end, into decoded_out,
+*   which needs as much room as the encoded string and may
+*   be the string itself. Escape sequences are decoded and
+*   UTF-8 is validated. If decoded_out is NULL, the string
+*   is only validated. Returns the decoded length, or -1 if
+*   the string is invalid.
+*
+**********************************************************/
+long string_decode
+    (
+    char const *    string_in,
+    char const *    string_end,
+    char *          decoded_out
+    )
+{
+char const *    run_end;
+char const *    next_char;
+char            decoded[4];
+size_t          decoded_len;
+size_t          run_len;
+size_t          total_len;
+
+total_len = 0;
+
+while( string_in < string_end )
+    {
+    // Move everything up to the next escape or non-ASCII character at once.
+    // Decoding never makes a string longer, so in place this stays behind
+    // the characters still to be read.
+    run_end = scan_string_plain( string_in, string_end );
+    run_len = run_end - string_in;
+
+    if( ( NULL != decoded_out ) && ( &decoded_out[total_len] != string_in ) )
+        {
+        memmove( &decoded_out[total_len], string_in, run_len );
+        }
+
+    total_len += run_len;
+    string_in  = run_end;
+
+    if( string_in == string_end )
+        {
+        break;
+        }
+    else if( '\\' == string_in[0] )
+        {
+        next_char = escape_decode( string_in, string_end, decoded, &decoded_len );
+        if( NULL == next_char )
+            {
+            return -1;
+            }
+
+        if( NULL != decoded_out )
+            {
+            memcpy( &decoded_out[total_len], decoded, decoded_len );
+            }
+
+        total_len += decoded_len;
+        string_in  = next_char;
+        }
+    else
+        {
+        // A non-ASCII character is copied through once it's known to be valid.
+        // A control character or a quote is invalid and has a length of 0.
+        run_len = utf8_sequence_length( string_in, string_end );
+        if( 0 == run_len )
+            {
+            return -1;
+            }
+
+        if( NULL != decoded_out )
+            {
+            memmove( &decoded_out[total_len], string_in, run_len );
+            }
+
+        total_len += run_len;
+        string_in += run_len;
+        }
+    }
+
+return (long)total_len;
+}
+
+
+/**********************************************************
+*	escape_decode
+*
+*	Decodes the escape sequence starting at the provided
+*   backslash into UTF-8. Returns a pointer just past the
+*   sequence, or NULL if it is invalid.
+*
+**********************************************************/
+static char const * escape_decode
+    (
+    char const *    escape,
+    char const *    string_end,
+    char *          decoded_out,
+    size_t *        decoded_len_out
+    )
+{
+uint32_t code_point;
+uint32_t low_surrogate;
+
+if( escape + 1 >= string_end )
+    {
+    return NULL;
+    }
+else if( 'u' != escape[1] )
+    {
+    decoded_out[0]   = escape_values[(unsigned char)escape[1]];
+    *decoded_len_out = 1;
+    return ( 0 == decoded_out[0] ) ? NULL : &escape[2];
+    }
+
+if( !hex4_decode( &escape[2], string_end, &code_point ) )
+    {
+    return NULL;
+    }
+
+escape += 6;
+
+if( ( code_point >= 0xD800 ) && ( code_point <= 0xDBFF ) )
+    {
+    // A high surrogate must be followed by an escaped low surrogate.
+    if( ( escape + 1 >= string_end ) || ( '\\' != escape[0] ) || ( 'u' != escape[1] )
+     || ( !hex4_decode( &escape[2], string_end, &low_surrogate ) )
+     || ( low_surrogate < 0xDC00 ) || ( low_surrogate > 0xDFFF ) )
+        {
+        return NULL;
+        }
+
+    code_point = 0x10000 + ( ( code_point - 0xD800 ) << 10 ) + ( low_surrogate - 0xDC00 );
+    escape    += 6;
+    }
+else if( ( code_point >= 0xDC00 ) && ( code_point <= 0xDFFF ) )
+    {
+    // A low surrogate on its own
+    return NULL;
+    }
+
+*decoded_len_out = utf8_encode( code_point, decoded_out );
+
+return escape;
+}
+
+
+/**********************************************************
+*	hex4_decode
+*
+*	Decodes the four hex digits of a \u escape. Returns 0 if
+*   there aren't four.
+*
+**********************************************************/
+static int hex4_decode
+    (
+    char const *    hex,
+    char const *    string_end,
+    uint32_t *      value_out
+    )
+{
+int         i;
+uint32_t    value;
+char        digit;
+
+if( string_end - hex < 4 )
+    {
+    return 0;
+    }
+
+value = 0;
+for( i = 0; i < 4; i++ )
+    {
+    digit = hex[i];
+
+    if( ( digit >= '0' ) && ( digit <= '9' ) )
+        {
+        value = ( value << 4 ) | (uint32_t)( digit - '0' );
+        }
+    else if( ( digit >= 'a' ) && ( digit <= 'f' ) )
+        {
+        value = ( value << 4 ) | (uint32_t)( digit - 'a' + 10 );
+        }
+    else if( ( digit >= 'A' ) && ( digit <= 'F' ) )
+        {
+        value = ( value << 4 ) | (uint32_t)( digit - 'A' + 10 );
+        }
+    else
+        {
+        return 0;
+        }
+    }
+
+*value_out = value;
+
+return 1;
+}
+
+
+/**********************************************************
+*	utf8_encode
+*
+*	Encodes a code point as UTF-8. Returns the number of
+*   bytes written.
+*
+**********************************************************/
+static size_t utf8_encode
+    (
+    uint32_t    code_point,
+    char *      encoded_out
+    )
+{
+if( code_point < 0x80 )
+    {
+    encoded_out[0] = (char)code_point;
+    return 1;
+    }
+else if( code_point < 0x800 )
+    {
+    encoded_out[0] = (char)( 0xC0 | ( code_point >> 6 ) );
+    encoded_out[1] = (char)( 0x80 | ( code_point & 0x3F ) );
+    return 2;
+    }
+else if( code_point < 0x10000 )
+    {
+    encoded_out[0] = (char)( 0xE0 | ( code_point >> 12 ) );
+    encoded_out[1] = (char)( 0x80 | ( ( code_point >> 6 ) & 0x3F ) );
+    encoded_out[2] = (char)( 0x80 | ( code_point & 0x3F ) );
+    return 3;
+    }
+
+encoded_out[0] = (char)( 0xF0 | ( code_point >> 18 ) );
+encoded_out[1] = (char)( 0x80 | ( ( code_point >> 12 ) & 0x3F ) );
+encoded_out[2] = (char)( 0x80 | ( ( code_point >> 6 ) & 0x3F ) );
+encoded_out[3] = (char)( 0x80 | ( code_point & 0x3F ) );
+return 4;
+}
+
+
+/**********************************************************
+*	utf8_sequence_length
+*
+*	Returns the length of the valid UTF-8 sequence for a
+*   non-ASCII character at the provided position, or 0 if it
+*   is not valid.
+*
+**********************************************************/
+static size_t utf8_sequence_length
+    (
+    char const *    sequence,
+    char const *    string_end
+    )
+{
+unsigned char const *   bytes;
+size_t                  len;
+size_t                  i;
+unsigned char           min_second;
+unsigned char           max_second;
+
+bytes = (unsigned char const *)sequence;
+len   = utf8_lengths[bytes[0]];
+
+if( ( len < 2 ) || ( (size_t)( string_end - sequence ) < len ) )
+    {
+    return 0;
+    }
+
+// Some lead bytes narrow the range of their second byte to rule out
+// overlong encodings, surrogates and code points past U+10FFFF.
+min_second = 0x80;
+max_second = 0xBF;
+
+switch( bytes[0] )
+    {
+    case 0xE0:
+        min_second = 0xA0;
+        break;
+
+    case 0xED:
+        max_second = 0x9F;
+        break;
+
+    case 0xF0:
+        min_second = 0x90;
+        break;
+
+    case 0xF4:
+        max_second = 0x8F;
+        break;
+
+    default:
+        break;
+    }
+
+if( ( bytes[1] < min_second ) || ( bytes[1] > max_second ) )
+    {
+    return 0;
+    }
+
+for( i = 2; i < len; i++ )
+    {
+    if( 0x80 != ( bytes[i] & 0xC0 ) )
+        {
+        return 0;
+        }
+    }
+
+return len;
+}
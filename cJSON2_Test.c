@@ -27,17 +27,128 @@ typedef struct
     double          exptd_value;
     } parse_number_test_case;
 
+typedef struct
+    {
+    char const *    ndjson_str;
+    int             is_ordered;     /* Records arrived in input order        */
+    int             next_id;
+    size_t          record_cnt;
+    size_t          invalid_cnt;
+    long long       id_sum;
+    size_t          stop_after;     /* Number of records to accept           */
+    } ndjson_log;
+
+typedef struct
+    {
+    char    text[256];
+    size_t  len;
+    int     stop_after;     /* Number of events to accept, or -1 for all */
+    } sax_log;
+
+static size_t counted_malloc_cnt;
+
+
+static void * counted_malloc
+    (
+    size_t size
+    );
+
+static int ndjson_log_record
+    (
+    void *  log,
+    size_t  record_offset,
+    cJSON * record
+    );
+
+static int sax_log_boolean
+    (
+    void *  log,
+    int     value
+    );
+
+static int sax_log_end_array
+    (
+    void * log
+    );
+
+static int sax_log_end_object
+    (
+    void * log
+    );
+
+static int sax_log_int64
+    (
+    void *  log,
+    int64_t value
+    );
+
+static int sax_log_key
+    (
+    void *          log,
+    char const *    key,
+    size_t          key_len
+    );
+
+static int sax_log_null
+    (
+    void * log
+    );
+
+static int sax_log_number
+    (
+    void *  log,
+    double  value
+    );
+
+static int sax_log_start_array
+    (
+    void * log
+    );
+
+static int sax_log_start_object
+    (
+    void * log
+    );
+
+static int sax_log_string
+    (
+    void *          log,
+    char const *    value,
+    size_t          value_len
+    );
+
+static int sax_log_write
+    (
+    void *          log,
+    char const *    text,
+    size_t          text_len
+    );
 
 static int serialize_test_case_run
     (
     char const * original_json
     );
 
+static int test_array_index
+    (
+    void
+    );
+
 static int test_get_object_item
     (
     void
     );
 
+static int test_object_index
+    (
+    void
+    );
+
+static int test_parse_arena
+    (
+    void
+    );
+
 static int test_parse_array_empty
     (
     void
@@ -48,11 +159,56 @@ static int test_parse_array_simple_values
     void
     );
 
+static int test_parse_chunked
+    (
+    void
+    );
+
+static int test_parse_compact
+    (
+    void
+    );
+
+static int test_parse_document
+    (
+    void
+    );
+
 static int test_parse_false
     (
     void
     );
 
+static int test_parse_file
+    (
+    void
+    );
+
+static int test_parse_in_situ
+    (
+    void
+    );
+
+static int test_parse_inline_strings
+    (
+    void
+    );
+
+static int test_parse_intern_keys
+    (
+    void
+    );
+
+static int test_parse_lazy
+    (
+    void
+    );
+
+static int test_parse_ndjson
+    (
+    void
+    );
+
 static int test_parse_null
     (
     void
@@ -63,6 +219,16 @@ static int test_parse_number
     void
     );
 
+static int test_parse_number_exact
+    (
+    void
+    );
+
+static int test_parse_number_int64
+    (
+    void
+    );
+
 static int test_parse_object_simple_values
     (
     void
@@ -73,6 +239,21 @@ static int test_parse_object_empty
     void
     );
 
+static int test_parse_parallel
+    (
+    void
+    );
+
+static int test_parse_sax
+    (
+    void
+    );
+
+static int test_parse_select
+    (
+    void
+    );
+
 static int test_parse_string
     (
     void
@@ -83,11 +264,46 @@ static int test_parse_string_empty
     void
     );
 
+static int test_parse_string_escapes
+    (
+    void
+    );
+
+static int test_parse_string_special
+    (
+    void
+    );
+
+static int test_parse_structural_index
+    (
+    void
+    );
+
 static int test_parse_true
     (
     void
     );
 
+static int test_parse_whitespace
+    (
+    void
+    );
+
+static int test_parse_with_length
+    (
+    void
+    );
+
+static int test_parser_reuse
+    (
+    void
+    );
+
+static int test_query
+    (
+    void
+    );
+
 static int test_serialize_array_empty
     (
     void
@@ -113,6 +329,11 @@ static int test_serialize_number
     void
     );
 
+static int test_serialize_number_exact
+    (
+    void
+    );
+
 static int test_serialize_object_empty
     (
     void
@@ -138,6 +359,11 @@ static int test_serialize_true
     void
     );
 
+static int test_validate
+    (
+    void
+    );
+
 
 /**********************************************************
 *	cJSON_test_suite
@@ -162,27 +388,53 @@ char const * TEST_FAILED = "FAILED";
 
 test tests[] =
     {/*     description,                    test_func                           */
+    {   "Array index",                      test_array_index                    },
     {   "Get object items",                 test_get_object_item                },
+    {   "Object index",                     test_object_index                   },
+    {   "Parse into arena",                 test_parse_arena                    },
     {   "Parse empty array",                test_parse_array_empty              },
     {   "Parse simple-valued array",        test_parse_array_simple_values      },
+    {   "Parse chunked",                    test_parse_chunked                  },
+    {   "Parse into a compact tree",        test_parse_compact                  },
+    {   "Parse into a tape document",       test_parse_document                 },
     {   "Parse false",                      test_parse_false                    },
+    {   "Parse file",                       test_parse_file                     },
+    {   "Parse in situ",                    test_parse_in_situ                  },
+    {   "Parse inline strings",             test_parse_inline_strings           },
+    {   "Parse with interned keys",         test_parse_intern_keys              },
+    {   "Parse lazily",                     test_parse_lazy                     },
+    {   "Parse NDJSON",                     test_parse_ndjson                   },
     {   "Parse null",                       test_parse_null                     },
     {   "Parse number",                     test_parse_number                   },
+    {   "Parse numbers exactly",            test_parse_number_exact             },
+    {   "Parse 64-bit integers",            test_parse_number_int64             },
     {   "Parse simple valued-object",       test_parse_object_simple_values     },
     {   "Parse empty object",               test_parse_object_empty             },
+    {   "Parse in parallel",                test_parse_parallel                 },
+    {   "Parse with SAX events",            test_parse_sax                      },
+    {   "Parse selected paths",             test_parse_select                   },
     {   "Parse string",                     test_parse_string                   },
     {   "Parse empty string",               test_parse_string_empty             },
+    {   "Parse string escapes",             test_parse_string_escapes           },
+    {   "Parse string special characters",  test_parse_string_special           },
+    {   "Parse with structural index",      test_parse_structural_index         },
     {   "Parse true",                       test_parse_true                     },
+    {   "Parse with whitespace",            test_parse_whitespace               },
+    {   "Parse with length",                test_parse_with_length              },
+    {   "Reuse parser across documents",    test_parser_reuse                   },
+    {   "Run compiled path queries",        test_query                          },
     {   "Serialize empty array",            test_serialize_array_empty          },
     {   "Serialize simple-valued array",    test_serialize_array_simple_values  },
     {   "Serialize false",                  test_serialize_false                },
     {   "Serialize null",                   test_serialize_null                 },
     {   "Serialize number",                 test_serialize_number               },
+    {   "Serialize numbers exactly",        test_serialize_number_exact         },
     {   "Serialize empty object",           test_serialize_object_empty         },
     {   "Serialize simple-valued object",   test_serialize_object_simple_values },
     {   "Serialize string",                 test_serialize_string               },
     {   "Serialize empty string",           test_serialize_string_empty         },
     {   "Serialize true",                   test_serialize_true                 },
+    {   "Validate",                         test_validate                       },
     };
 
 num_tests  = cnt_of_array( tests );
@@ -212,110 +464,1823 @@ printf( "%d PASSED, %d FAILED\n", num_passed, num_failed );
 
 
 /**********************************************************
-*	serialize_test_case_run
+*	counted_malloc
 *
-*	Runs a serialization test case. Returns 1 if the test
-*	passes, 0 if it fails.
+*	Allocates memory like malloc(), counting each call.
 *
 **********************************************************/
-static int serialize_test_case_run
+static void * counted_malloc
     (
-    char const * original_json
+    size_t size
     )
 {
-int     did_pass;
-cJSON * json;
-char *  serialized_json;
-size_t  original_json_len;
+counted_malloc_cnt++;
 
-original_json_len = strlen( original_json );
+return malloc( size );
+}
 
-json = cJSON_Parse( original_json );
-serialized_json = cJSON_Print( json );
 
-did_pass = ( NULL != serialized_json );
-did_pass = ( did_pass ) && ( 0 == strncmp( original_json, serialized_json, original_json_len ) );
+/**********************************************************
+*	ndjson_log_record
+*
+*	Records a record delivered by the NDJSON parser, making
+*   sure that it was found at the offset it was reported at.
+*
+**********************************************************/
+static int ndjson_log_record
+    (
+    void *  log,
+    size_t  record_offset,
+    cJSON * record
+    )
+{
+ndjson_log *    ndjson_log_ptr;
+cJSON *         id;
 
-// Make sure that a null-terminator was added at the end of the serialized string
-did_pass = ( did_pass ) && ( '\0' == serialized_json[original_json_len] );
+ndjson_log_ptr = (ndjson_log*)log;
+id             = cJSON_GetObjectItem( record, "id" );
 
-// Clean up.
-cJSON_Delete( json );
-free( serialized_json );
+if( NULL == id )
+    {
+    ndjson_log_ptr->invalid_cnt++;
+    }
+else
+    {
+    ndjson_log_ptr->is_ordered = ( ndjson_log_ptr->is_ordered ) && ( id->valueint == ndjson_log_ptr->next_id );
+    ndjson_log_ptr->is_ordered = ( ndjson_log_ptr->is_ordered ) && ( 0 == strncmp( &ndjson_log_ptr->ndjson_str[record_offset], "{\"id\"", 5 ) );
+    ndjson_log_ptr->next_id    = id->valueint + 1;
+    ndjson_log_ptr->id_sum    += id->valueint;
+    }
 
-return  did_pass;
+cJSON_Delete( record );
+ndjson_log_ptr->record_cnt++;
+
+return ( ndjson_log_ptr->record_cnt < ndjson_log_ptr->stop_after );
 }
 
 
 /**********************************************************
-*	test_get_object_item
+*	sax_log_boolean
 *
-*	Tests looking up items from objects by key
+*	Records a boolean event.
 *
 **********************************************************/
-static int test_get_object_item
+static int sax_log_boolean
     (
-    void
+    void *  log,
+    int     value
     )
 {
-int     did_pass;
-cJSON * json_object;
-cJSON * json_item;
-int     i;
+return ( value ) ? sax_log_write( log, "true ", 5 ) : sax_log_write( log, "false ", 6 );
+}
 
-get_object_item_test_case test_cases[] =
-    {
-        {   "trueKey",      cJSON_True      },
-        {   "arrayKey",     cJSON_Array     },
-        {   "objectKey",    cJSON_Object    },
-        {   "numberKey",    cJSON_Number    },
-        {   "nullKey",      cJSON_Null      },
-    };
 
-// Should return NULL for NULL objects
-json_item = cJSON_GetObjectItem( NULL, "key" );
-did_pass  = ( NULL == json_item );
+/**********************************************************
+*	sax_log_end_array
+*
+*	Records an end of array event.
+*
+**********************************************************/
+static int sax_log_end_array
+    (
+    void * log
+    )
+{
+return sax_log_write( log, "]", 1 );
+}
 
-// Should return NULL for an empty object.
-json_object = cJSON_Parse( "{}" );
-json_item   = cJSON_GetObjectItem( json_object, "key" );
-did_pass    = ( did_pass ) && ( NULL == json_item );
-cJSON_Delete( json_object );
 
-// Should return objects for valid keys in a valid object
-json_object = cJSON_Parse(
-    "{ \"trueKey\": true, \"arrayKey\": [], \"objectKey\" : {},"
-     " \"numberKey\": 17.12, \"nullKey\": null, \"stringKey\": \"hello\" }"
-    );
-did_pass = ( did_pass ) && ( NULL != json_object );
+/**********************************************************
+*	sax_log_end_object
+*
+*	Records an end of object event.
+*
+**********************************************************/
+static int sax_log_end_object
+    (
+    void * log
+    )
+{
+return sax_log_write( log, "}", 1 );
+}
+
+
+/**********************************************************
+*	sax_log_int64
+*
+*	Records a 64-bit integer event.
+*
+**********************************************************/
+static int sax_log_int64
+    (
+    void *  log,
+    int64_t value
+    )
+{
+char buffer[32];
+
+return sax_log_write( log, buffer, sprintf( buffer, "i%lld ", (long long)value ) );
+}
+
+
+/**********************************************************
+*	sax_log_key
+*
+*	Records an object key event.
+*
+**********************************************************/
+static int sax_log_key
+    (
+    void *          log,
+    char const *    key,
+    size_t          key_len
+    )
+{
+return ( sax_log_write( log, key, key_len ) ) && ( sax_log_write( log, ":", 1 ) );
+}
+
+
+/**********************************************************
+*	sax_log_null
+*
+*	Records a null event.
+*
+**********************************************************/
+static int sax_log_null
+    (
+    void * log
+    )
+{
+return sax_log_write( log, "null ", 5 );
+}
+
+
+/**********************************************************
+*	sax_log_number
+*
+*	Records a number event.
+*
+**********************************************************/
+static int sax_log_number
+    (
+    void *  log,
+    double  value
+    )
+{
+char buffer[32];
+
+return sax_log_write( log, buffer, sprintf( buffer, "d%g ", value ) );
+}
+
+
+/**********************************************************
+*	sax_log_start_array
+*
+*	Records a start of array event.
+*
+**********************************************************/
+static int sax_log_start_array
+    (
+    void * log
+    )
+{
+return sax_log_write( log, "[", 1 );
+}
+
+
+/**********************************************************
+*	sax_log_start_object
+*
+*	Records a start of object event.
+*
+**********************************************************/
+static int sax_log_start_object
+    (
+    void * log
+    )
+{
+return sax_log_write( log, "{", 1 );
+}
+
+
+/**********************************************************
+*	sax_log_string
+*
+*	Records a string event.
+*
+**********************************************************/
+static int sax_log_string
+    (
+    void *          log,
+    char const *    value,
+    size_t          value_len
+    )
+{
+return ( sax_log_write( log, "'", 1 ) ) && ( sax_log_write( log, value, value_len ) ) && ( sax_log_write( log, "' ", 2 ) );
+}
+
+
+/**********************************************************
+*	sax_log_write
+*
+*	Appends text to a SAX event log. Returns 0 once the log
+*   has accepted as many events as it was told to.
+*
+**********************************************************/
+static int sax_log_write
+    (
+    void *          log,
+    char const *    text,
+    size_t          text_len
+    )
+{
+sax_log * sax_log_ptr;
+
+sax_log_ptr = (sax_log*)log;
+
+if( ( 0 == sax_log_ptr->stop_after ) || ( sax_log_ptr->len + text_len >= sizeof( sax_log_ptr->text ) ) )
+    {
+    return 0;
+    }
+
+memcpy( &sax_log_ptr->text[sax_log_ptr->len], text, text_len );
+sax_log_ptr->len += text_len;
+sax_log_ptr->text[sax_log_ptr->len] = '\0';
+
+if( sax_log_ptr->stop_after > 0 )
+    {
+    sax_log_ptr->stop_after--;
+    }
+
+return 1;
+}
+
+
+/**********************************************************
+*	serialize_test_case_run
+*
+*	Runs a serialization test case. Returns 1 if the test
+*	passes, 0 if it fails.
+*
+**********************************************************/
+static int serialize_test_case_run
+    (
+    char const * original_json
+    )
+{
+int     did_pass;
+cJSON * json;
+char *  serialized_json;
+size_t  original_json_len;
+
+original_json_len = strlen( original_json );
+
+json = cJSON_Parse( original_json );
+serialized_json = cJSON_Print( json );
+
+did_pass = ( NULL != serialized_json );
+did_pass = ( did_pass ) && ( 0 == strncmp( original_json, serialized_json, original_json_len ) );
+
+// Make sure that a null-terminator was added at the end of the serialized string
+did_pass = ( did_pass ) && ( '\0' == serialized_json[original_json_len] );
+
+// Clean up.
+cJSON_Delete( json );
+free( serialized_json );
+
+return  did_pass;
+}
+
+
+/**********************************************************
+*	test_array_index
+*
+*	Tests indexing into and detaching items of a large, indexed array
+*
+**********************************************************/
+static int test_array_index
+    (
+    void
+    )
+{
+int             did_pass;
+cJSON_Hooks     hooks;
+cJSON *         json;
+cJSON *         item;
+char            json_str[1024];
+size_t          json_len;
+int             i;
+
+hooks.malloc_fn  = malloc;
+hooks.realloc_fn = realloc;
+hooks.free_fn    = free;
+
+// Enough items to be indexed. The array is written after a '[' so that it
+// can also be parsed as an item of another array.
+json_str[0] = '[';
+json_len    = 1 + (size_t)sprintf( &json_str[1], "[ 0" );
+for( i = 1; i < 100; i++ )
+    {
+    json_len += (size_t)sprintf( &json_str[json_len], ", %d", i );
+    }
+json_len += (size_t)sprintf( &json_str[json_len], " ]" );
+
+json     = cJSON_Parse( &json_str[1] );
+did_pass = ( NULL != json ) && ( json->flags & cJSON_IsIndexed );
+did_pass = ( did_pass ) && ( 100 == cJSON_GetArraySize( json ) );
+
+for( i = 0; ( did_pass ) && ( i < 100 ); i++ )
+    {
+    item     = cJSON_GetArrayItem( json, i );
+    did_pass = ( NULL != item ) && ( i == item->valueint );
+    }
+did_pass = ( did_pass ) && ( NULL == cJSON_GetArrayItem( json, 100 ) );
+did_pass = ( did_pass ) && ( NULL == cJSON_GetArrayItem( json, -1 ) );
+
+// Detaching items shifts the ones after them down.
+item     = cJSON_DetachItemFromArray( json, 0 );
+did_pass = ( did_pass ) && ( NULL != item ) && ( 0 == item->valueint ) && ( NULL == item->parent ) && ( NULL == item->next );
+cJSON_Delete( item );
+cJSON_DeleteItemFromArray( json, 98 );
+cJSON_DeleteItemFromArray( json, 49 );
+did_pass = ( did_pass ) && ( NULL == cJSON_DetachItemFromArray( json, 97 ) );
+did_pass = ( did_pass ) && ( 97 == cJSON_GetArraySize( json ) );
+
+for( i = 0; ( did_pass ) && ( i < 97 ); i++ )
+    {
+    item     = cJSON_GetArrayItem( json, i );
+    did_pass = ( NULL != item ) && ( ( ( i < 49 ) ? i + 1 : i + 2 ) == item->valueint );
+    }
+did_pass = ( did_pass ) && ( 1 == json->child->valueint ) && ( NULL == cJSON_GetArrayItem( json, 96 )->next );
+cJSON_Delete( json );
+
+// Arrays parsed lazily are indexed once they are materialized.
+json_str[json_len++] = ']';
+json     = cJSON_ParseWithFlags( json_str, json_len, cJSON_ParseLazy, &hooks );
+item     = cJSON_GetArrayItem( cJSON_GetArrayItem( json, 0 ), 99 );
+did_pass = ( did_pass ) && ( NULL != item ) && ( 99 == item->valueint ) && ( item->parent->flags & cJSON_IsIndexed );
+cJSON_Delete( json );
+
+// Small arrays are walked instead.
+json     = cJSON_Parse( "[ 1, 2, 3 ]" );
+did_pass = ( did_pass ) && ( NULL != json ) && ( !( json->flags & cJSON_IsIndexed ) );
+cJSON_DeleteItemFromArray( json, 1 );
+did_pass = ( did_pass ) && ( 2 == cJSON_GetArraySize( json ) ) && ( 3 == cJSON_GetArrayItem( json, 1 )->valueint );
+cJSON_Delete( json );
+
+return did_pass;
+}
+
+
+/**********************************************************
+*	test_get_object_item
+*
+*	Tests looking up items from objects by key
+*
+**********************************************************/
+static int test_get_object_item
+    (
+    void
+    )
+{
+int     did_pass;
+cJSON * json_object;
+cJSON * json_item;
+int     i;
+
+get_object_item_test_case test_cases[] =
+    {
+        {   "trueKey",      cJSON_True      },
+        {   "arrayKey",     cJSON_Array     },
+        {   "objectKey",    cJSON_Object    },
+        {   "numberKey",    cJSON_Number    },
+        {   "nullKey",      cJSON_Null      },
+    };
+
+// Should return NULL for NULL objects
+json_item = cJSON_GetObjectItem( NULL, "key" );
+did_pass  = ( NULL == json_item );
+
+// Should return NULL for an empty object.
+json_object = cJSON_Parse( "{}" );
+json_item   = cJSON_GetObjectItem( json_object, "key" );
+did_pass    = ( did_pass ) && ( NULL == json_item );
+cJSON_Delete( json_object );
+
+// Should return objects for valid keys in a valid object
+json_object = cJSON_Parse(
+    "{ \"trueKey\": true, \"arrayKey\": [], \"objectKey\" : {},"
+     " \"numberKey\": 17.12, \"nullKey\": null, \"stringKey\": \"hello\" }"
+    );
+did_pass = ( did_pass ) && ( NULL != json_object );
+
+for( i = 0; ( did_pass ) && ( i < cnt_of_array( test_cases ) ); i++ )
+    {
+    json_item = cJSON_GetObjectItem( json_object, test_cases[i].key );
+    did_pass = ( NULL != json_item );
+    did_pass = ( did_pass ) && ( test_cases[i].value_type == json_item->type );
+
+    // The has item function should return true
+    did_pass = ( did_pass ) && ( cJSON_ObjectHasItem( json_object, test_cases[i].key ) );
+    }
+
+// Should fail to look up keys that are not in the object
+json_item = cJSON_GetObjectItem( json_object, "notAKey" );
+did_pass = ( did_pass ) && ( NULL == json_item );
+
+cJSON_Delete( json_object );
+
+return did_pass;
+}
+
+
+/**********************************************************
+*	test_object_index
+*
+*	Tests looking up and detaching members of a large, indexed object
+*
+**********************************************************/
+static int test_object_index
+    (
+    void
+    )
+{
+int             did_pass;
+cJSON_Hooks     hooks;
+cJSON *         json;
+cJSON *         item;
+char            json_str[2048];
+char            key[16];
+size_t          json_len;
+int             i;
+
+hooks.malloc_fn  = malloc;
+hooks.realloc_fn = realloc;
+hooks.free_fn    = free;
+
+// Enough members to be indexed, with "k7" given twice. The object is
+// written after a '[' so that it can also be parsed as an array item.
+json_str[0] = '[';
+json_len    = 1 + (size_t)sprintf( &json_str[1], "{ \"k7\": -1" );
+for( i = 0; i < 100; i++ )
+    {
+    json_len += (size_t)sprintf( &json_str[json_len], ", \"k%d\": %d", i, i );
+    }
+json_len += (size_t)sprintf( &json_str[json_len], " }" );
+
+json     = cJSON_Parse( &json_str[1] );
+did_pass = ( NULL != json ) && ( json->flags & cJSON_IsIndexed );
+
+for( i = 0; ( did_pass ) && ( i < 100 ); i++ )
+    {
+    sprintf( key, "k%d", i );
+    item     = cJSON_GetObjectItem( json, key );
+    did_pass = ( NULL != item ) && ( 0 == strcmp( key, item->string ) ) && ( ( ( 7 == i ) ? -1 : i ) == item->valueint );
+    }
+did_pass = ( did_pass ) && ( NULL == cJSON_GetObjectItem( json, "missing" ) );
+
+// Detaching the first "k7" uncovers the second one.
+item     = cJSON_DetachItemFromObject( json, "k7" );
+did_pass = ( did_pass ) && ( NULL != item ) && ( -1 == item->valueint ) && ( NULL == item->parent ) && ( NULL == item->next );
+cJSON_Delete( item );
+item     = cJSON_GetObjectItem( json, "k7" );
+did_pass = ( did_pass ) && ( NULL != item ) && ( 7 == item->valueint );
+cJSON_DeleteItemFromObject( json, "k7" );
+did_pass = ( did_pass ) && ( NULL == cJSON_GetObjectItem( json, "k7" ) );
+
+// The members left can still be found once half of them are gone.
+for( i = 0; i < 100; i += 2 )
+    {
+    sprintf( key, "k%d", i );
+    cJSON_DeleteItemFromObject( json, key );
+    }
+
+for( i = 0; ( did_pass ) && ( i < 100 ); i++ )
+    {
+    sprintf( key, "k%d", i );
+    item     = cJSON_GetObjectItem( json, key );
+    did_pass = ( ( 0 == i % 2 ) || ( 7 == i ) ) ? ( NULL == item ) : ( ( NULL != item ) && ( i == item->valueint ) );
+    }
+
+did_pass = ( did_pass ) && ( NULL == cJSON_DetachItemFromObject( json, "k0" ) );
+cJSON_Delete( json );
+
+// Objects parsed lazily are indexed once they are materialized.
+json_str[json_len++] = ']';
+json     = cJSON_ParseWithFlags( json_str, json_len, cJSON_ParseLazy, &hooks );
+item     = cJSON_GetObjectItem( cJSON_GetArrayItem( json, 0 ), "k99" );
+did_pass = ( did_pass ) && ( NULL != item ) && ( 99 == item->valueint ) && ( item->parent->flags & cJSON_IsIndexed );
+cJSON_Delete( json );
+
+// Small objects are walked instead.
+json     = cJSON_Parse( "{ \"a\": 1, \"b\": 2 }" );
+did_pass = ( did_pass ) && ( NULL != json ) && ( !( json->flags & cJSON_IsIndexed ) );
+cJSON_DeleteItemFromObject( json, "a" );
+did_pass = ( did_pass ) && ( NULL == cJSON_GetObjectItem( json, "a" ) ) && ( json->child == cJSON_GetObjectItem( json, "b" ) );
+cJSON_Delete( json );
+
+return did_pass;
+}
+
+
+/**********************************************************
+*	test_parse_arena
+*
+*	Tests parsing documents into an arena
+*
+**********************************************************/
+static int test_parse_arena
+    (
+    void
+    )
+{
+int             did_pass;
+cJSON_Arena *   arena;
+cJSON *         json;
+cJSON *         item;
+int             i;
+
+arena    = cJSON_ArenaCreate();
+did_pass = ( NULL != arena );
+
+// Parse a few times with a reset in between so that chunks are reused.
+for( i = 0; ( did_pass ) && ( i < 3 ); i++ )
+    {
+    json = cJSON_ParseArena( "{ \"name\": \"arena\", \"values\": [1, 2, 3], \"nested\": { \"ok\": true } }", arena );
+    did_pass = ( NULL != json );
+    did_pass = ( did_pass ) && ( json->flags & cJSON_InArena );
+
+    item     = cJSON_GetObjectItem( json, "name" );
+    did_pass = ( did_pass ) && ( NULL != item );
+    did_pass = ( did_pass ) && ( 0 == strcmp( "arena", item->valuestring ) );
+
+    item     = cJSON_GetObjectItem( json, "values" );
+    did_pass = ( did_pass ) && ( 3 == cJSON_GetArraySize( item ) );
+
+    item     = cJSON_GetObjectItem( cJSON_GetObjectItem( json, "nested" ), "ok" );
+    did_pass = ( did_pass ) && ( NULL != item );
+    did_pass = ( did_pass ) && ( cJSON_True == item->type );
+
+    // Deleting an arena tree must be a harmless no-op.
+    cJSON_Delete( json );
+    cJSON_ArenaReset( arena );
+    }
+
+// Invalid input should still fail cleanly.
+did_pass = ( did_pass ) && ( NULL == cJSON_ParseArena( "[1, 2", arena ) );
+
+cJSON_ArenaDelete( arena );
+
+return did_pass;
+}
+
+
+/**********************************************************
+*	test_parse_array_empty
+*
+*	Tests parsing an empty JSON array.
+*
+**********************************************************/
+static int test_parse_array_empty
+    (
+    void
+    )
+{
+int     did_pass;
+cJSON * json;
+
+json = cJSON_Parse( "[]" );
+
+did_pass = ( NULL != json );
+did_pass = ( did_pass ) && ( cJSON_Array == json->type );
+did_pass = ( did_pass ) && ( 0 == cJSON_GetArraySize( json ) );
+did_pass = ( did_pass ) && ( NULL == cJSON_GetArrayItem( json, 0 ) );
+
+cJSON_Delete( json );
+
+return did_pass;
+}
+
+
+/**********************************************************
+*	test_parse_array_simple_values
+*
+*	Tests parsing an JSON array containing simple values.
+*
+**********************************************************/
+static int test_parse_array_simple_values
+    (
+    void
+    )
+{
+int     did_pass;
+cJSON * json;
+int     idx;
+cJSON * array_item;
+
+const cJSON_ValueType exptd_values[] =
+    {
+    cJSON_Null,
+    cJSON_False,
+    cJSON_Array,
+    cJSON_Object,
+    cJSON_String,
+    cJSON_Number,
+    cJSON_True,
+    cJSON_Array,
+    };
+
+json = cJSON_Parse( "[null, false, [], {}, \"hello\", 1.0,  true, []]" );
+
+did_pass = ( NULL != json );
+did_pass = ( did_pass ) && ( cJSON_Array == json->type );
+did_pass = ( did_pass ) && ( cJSON_GetArraySize( json ) == cnt_of_array( exptd_values ) );
+
+for( idx = 0; ( did_pass ) && ( idx < cnt_of_array( exptd_values ) ); idx++ )
+    {
+    array_item = cJSON_GetArrayItem( json, idx );
+    did_pass = ( did_pass ) && ( NULL != array_item );
+    did_pass = ( did_pass ) && ( exptd_values[idx] == array_item->type );
+    }
+
+cJSON_Delete( json );
+
+return did_pass;
+}
+
+
+/**********************************************************
+*	test_parse_chunked
+*
+*	Tests feeding a document to the incremental parser in chunks
+*
+**********************************************************/
+static int test_parse_chunked
+    (
+    void
+    )
+{
+static char const * json_strs[] =
+    {
+    "{ \"name\": \"chunked \\\"parser\\\"\", \"values\": [ 1, -2.5e3, 12345678901234, true, false, null ], \"nested\": { \"empty\": [], \"obj\": {} } }",
+    "[ NaN, Infinity, -Infinity, \"\", 0 ]",
+    "  -0.125  ",
+    "\"top\""
+    };
+
+static size_t const chunk_lens[] = { 1, 2, 3, 7, 64 };
+
+int             did_pass;
+size_t          i;
+size_t          j;
+size_t          posn;
+size_t          len;
+char *          expected;
+char *          actual;
+cJSON *         json;
+cJSON_Parser *  parser;
+
+parser   = cJSON_ParserCreate();
+did_pass = ( NULL != parser );
+
+// Feeding a document in pieces should give the same tree as parsing it at once.
+// The same parser is reused for every document.
+for( i = 0; ( did_pass ) && ( i < sizeof( json_strs ) / sizeof( json_strs[0] ) ); i++ )
+    {
+    json     = cJSON_Parse( json_strs[i] );
+    expected = cJSON_Print( json );
+    cJSON_Delete( json );
+
+    for( j = 0; ( did_pass ) && ( j < sizeof( chunk_lens ) / sizeof( chunk_lens[0] ) ); j++ )
+        {
+        for( posn = 0; ( did_pass ) && ( posn < strlen( json_strs[i] ) ); posn += len )
+            {
+            len      = strlen( &json_strs[i][posn] );
+            len      = ( len < chunk_lens[j] ) ? len : chunk_lens[j];
+            did_pass = cJSON_ParserFeed( parser, &json_strs[i][posn], len );
+            }
+
+        json     = cJSON_ParserFinish( parser );
+        actual   = cJSON_Print( json );
+        did_pass = ( did_pass ) && ( NULL != actual ) && ( NULL != expected ) && ( 0 == strcmp( expected, actual ) );
+
+        free( actual );
+        cJSON_Delete( json );
+        }
+
+    free( expected );
+    }
+
+// Invalid input should be reported as soon as it is fed.
+did_pass = ( did_pass ) && ( cJSON_ParserFeed( parser, "[ 1, ", 5 ) );
+did_pass = ( did_pass ) && ( !cJSON_ParserFeed( parser, "}", 1 ) );
+did_pass = ( did_pass ) && ( NULL == cJSON_ParserFinish( parser ) );
+
+// Incomplete input should only be reported when the document is finished.
+did_pass = ( did_pass ) && ( cJSON_ParserFeed( parser, "{ \"key\": \"val", 13 ) );
+did_pass = ( did_pass ) && ( NULL == cJSON_ParserFinish( parser ) );
+did_pass = ( did_pass ) && ( cJSON_ParserFeed( parser, "nul", 3 ) );
+did_pass = ( did_pass ) && ( NULL == cJSON_ParserFinish( parser ) );
+did_pass = ( did_pass ) && ( NULL == cJSON_ParserFinish( parser ) );
+
+cJSON_ParserDelete( parser );
+
+// A parser with a half-built document should clean up after itself.
+parser   = cJSON_ParserCreate();
+did_pass = ( did_pass ) && ( NULL != parser );
+did_pass = ( did_pass ) && ( cJSON_ParserFeed( parser, "[ [ \"a\", 1 ], { \"b\":", 20 ) );
+cJSON_ParserDelete( parser );
+
+return did_pass;
+}
+
+
+/**********************************************************
+*	test_parse_compact
+*
+*	Tests parsing into a compact tree of indexed nodes and walking it
+*
+**********************************************************/
+static int test_parse_compact
+    (
+    void
+    )
+{
+int             did_pass;
+cJSON_Compact * compact;
+uint32_t        node;
+uint32_t        item;
+size_t          len;
+char const *    text;
+char const *    json_str;
+char            nested_str[512];
+
+json_str = "{ \"id\": 12345678901234, \"ratio\": -2.5, \"tags\": [ \"a\\u0000b\", [], {}, [ true ] ], \"ok\": false, \"none\": null, \"key\\\"\": \"v\" }";
+compact  = cJSON_CompactParse( json_str, strlen( json_str ) );
+did_pass = ( NULL != compact );
+did_pass = ( did_pass ) && ( cJSON_Object == cJSON_CompactGetType( compact, 0 ) );
+did_pass = ( did_pass ) && ( 6 == cJSON_CompactGetSize( compact, 0 ) );
+did_pass = ( did_pass ) && ( 12 == cJSON_CompactGetNodeCount( compact ) );
+
+// Integers that fit in 64 bits are kept exactly.
+node     = cJSON_CompactGetObjectItem( compact, 0, "id" );
+did_pass = ( did_pass ) && ( 0 != node );
+did_pass = ( did_pass ) && ( cJSON_Number == cJSON_CompactGetType( compact, node ) );
+did_pass = ( did_pass ) && ( cJSON_CompactIsInt64( compact, node ) );
+did_pass = ( did_pass ) && ( 12345678901234 == cJSON_CompactGetInt64( compact, node ) );
+
+node     = cJSON_CompactGetObjectItem( compact, 0, "ratio" );
+did_pass = ( did_pass ) && ( !cJSON_CompactIsInt64( compact, node ) );
+did_pass = ( did_pass ) && ( -2.5 == cJSON_CompactGetNumber( compact, node ) );
+
+// Strings keep their length, escaped null characters included.
+node     = cJSON_CompactGetObjectItem( compact, 0, "tags" );
+did_pass = ( did_pass ) && ( cJSON_Array == cJSON_CompactGetType( compact, node ) );
+did_pass = ( did_pass ) && ( 4 == cJSON_CompactGetSize( compact, node ) );
+text     = cJSON_CompactGetString( compact, cJSON_CompactGetArrayItem( compact, node, 0 ), &len );
+did_pass = ( did_pass ) && ( NULL != text ) && ( 3 == len ) && ( 0 == memcmp( "a\0b", text, 4 ) );
+
+// Every node knows its parent, and the root is its own.
+item     = cJSON_CompactGetArrayItem( compact, node, 3 );
+did_pass = ( did_pass ) && ( node == cJSON_CompactGetParent( compact, item ) );
+did_pass = ( did_pass ) && ( item == cJSON_CompactGetParent( compact, cJSON_CompactGetChild( compact, item ) ) );
+did_pass = ( did_pass ) && ( 0 == cJSON_CompactGetParent( compact, node ) );
+did_pass = ( did_pass ) && ( 0 == cJSON_CompactGetParent( compact, 0 ) );
+
+// Empty containers have no children.
+item     = cJSON_CompactGetArrayItem( compact, node, 1 );
+did_pass = ( did_pass ) && ( 0 == cJSON_CompactGetChild( compact, item ) );
+did_pass = ( did_pass ) && ( 0 == cJSON_CompactGetSize( compact, item ) );
+did_pass = ( did_pass ) && ( cJSON_Object == cJSON_CompactGetType( compact, cJSON_CompactGetNext( compact, item ) ) );
+did_pass = ( did_pass ) && ( 0 == cJSON_CompactGetArrayItem( compact, node, 4 ) );
+
+// Members are visited in order, each with its decoded key.
+len = 0;
+for( item = cJSON_CompactGetChild( compact, 0 ); 0 != item; item = cJSON_CompactGetNext( compact, item ) )
+    {
+    len++;
+    }
+did_pass = ( did_pass ) && ( 6 == len );
+
+node     = cJSON_CompactGetObjectItem( compact, 0, "key\"" );
+text     = cJSON_CompactGetKey( compact, node, &len );
+did_pass = ( did_pass ) && ( NULL != text ) && ( 4 == len ) && ( 0 == strcmp( "key\"", text ) );
+did_pass = ( did_pass ) && ( 0 == strcmp( "v", cJSON_CompactGetString( compact, node, NULL ) ) );
+did_pass = ( did_pass ) && ( cJSON_False == cJSON_CompactGetType( compact, cJSON_CompactGetObjectItem( compact, 0, "ok" ) ) );
+did_pass = ( did_pass ) && ( cJSON_Null == cJSON_CompactGetType( compact, cJSON_CompactGetObjectItem( compact, 0, "none" ) ) );
+did_pass = ( did_pass ) && ( 0 == cJSON_CompactGetObjectItem( compact, 0, "missing" ) );
+
+// Array items and the root have no keys.
+did_pass = ( did_pass ) && ( NULL == cJSON_CompactGetKey( compact, 0, NULL ) );
+did_pass = ( did_pass ) && ( NULL == cJSON_CompactGetKey( compact, cJSON_CompactGetArrayItem( compact, cJSON_CompactGetObjectItem( compact, 0, "tags" ), 0 ), NULL ) );
+cJSON_CompactDelete( compact );
+
+// A scalar can be a whole document.
+compact  = cJSON_CompactParse( "\"text\"", 6 );
+did_pass = ( did_pass ) && ( NULL != compact );
+did_pass = ( did_pass ) && ( 0 == strcmp( "text", cJSON_CompactGetString( compact, 0, NULL ) ) );
+did_pass = ( did_pass ) && ( 1 == cJSON_CompactGetNodeCount( compact ) );
+cJSON_CompactDelete( compact );
+
+// Enough nesting to move the stack of open containers while children are
+// linked in. Every level holds its child and a 2.
+for( len = 0; len < 64; len++ )
+    {
+    nested_str[len] = '[';
+    nested_str[64 + 1 + 3 * len]     = ',';
+    nested_str[64 + 1 + 3 * len + 1] = '2';
+    nested_str[64 + 1 + 3 * len + 2] = ']';
+    }
+nested_str[64] = '1';
+
+compact  = cJSON_CompactParse( nested_str, 64 + 1 + 3 * 64 );
+did_pass = ( did_pass ) && ( NULL != compact );
+for( node = 0, len = 0; ( did_pass ) && ( len < 64 ); len++ )
+    {
+    did_pass = ( cJSON_Array == cJSON_CompactGetType( compact, node ) ) && ( 2 == cJSON_CompactGetSize( compact, node ) );
+    node     = cJSON_CompactGetChild( compact, node );
+    item     = cJSON_CompactGetNext( compact, node );
+    did_pass = ( did_pass ) && ( 0 != item ) && ( 2 == cJSON_CompactGetNumber( compact, item ) ) && ( 0 == cJSON_CompactGetNext( compact, item ) );
+    }
+did_pass = ( did_pass ) && ( 1 == cJSON_CompactGetNumber( compact, node ) );
+cJSON_CompactDelete( compact );
+
+// Invalid documents are rejected.
+did_pass = ( did_pass ) && ( NULL == cJSON_CompactParse( "[ 1, 2 }", 8 ) );
+did_pass = ( did_pass ) && ( NULL == cJSON_CompactParse( "{ \"a\": [ 1 }", 12 ) );
+
+return did_pass;
+}
+
+
+/**********************************************************
+*	test_parse_document
+*
+*	Tests parsing into a flat tape document and walking it
+*
+**********************************************************/
+static int test_parse_document
+    (
+    void
+    )
+{
+int                 did_pass;
+cJSON_Document *    document;
+size_t              value;
+size_t              item;
+size_t              len;
+char const *        text;
+char const *        json_str;
+char                nested_str[512];
+
+json_str = "{ \"id\": 12345678901234, \"ratio\": -2.5, \"tags\": [ \"a\\u0000b\", [], {}, [ true ] ], \"ok\": false, \"none\": null, \"key\\\"\": \"v\" }";
+document = cJSON_DocumentParse( json_str, strlen( json_str ) );
+did_pass = ( NULL != document );
+did_pass = ( did_pass ) && ( cJSON_Object == cJSON_DocumentGetType( document, 0 ) );
+did_pass = ( did_pass ) && ( 6 == cJSON_DocumentGetSize( document, 0 ) );
+
+// Integers that fit in 64 bits are kept exactly.
+value    = cJSON_DocumentGetObjectItem( document, 0, "id" );
+did_pass = ( did_pass ) && ( 0 != value );
+did_pass = ( did_pass ) && ( cJSON_Number == cJSON_DocumentGetType( document, value ) );
+did_pass = ( did_pass ) && ( cJSON_DocumentIsInt64( document, value ) );
+did_pass = ( did_pass ) && ( 12345678901234 == cJSON_DocumentGetInt64( document, value ) );
+
+value    = cJSON_DocumentGetObjectItem( document, 0, "ratio" );
+did_pass = ( did_pass ) && ( !cJSON_DocumentIsInt64( document, value ) );
+did_pass = ( did_pass ) && ( -2.5 == cJSON_DocumentGetNumber( document, value ) );
+
+// Strings keep their length, escaped null characters included.
+value    = cJSON_DocumentGetObjectItem( document, 0, "tags" );
+did_pass = ( did_pass ) && ( cJSON_Array == cJSON_DocumentGetType( document, value ) );
+did_pass = ( did_pass ) && ( 4 == cJSON_DocumentGetSize( document, value ) );
+text     = cJSON_DocumentGetString( document, cJSON_DocumentGetArrayItem( document, value, 0 ), &len );
+did_pass = ( did_pass ) && ( NULL != text ) && ( 3 == len ) && ( 0 == memcmp( "a\0b", text, 4 ) );
+
+// Empty containers have no children, and stepping over them lands on the
+// next value.
+item     = cJSON_DocumentGetArrayItem( document, value, 1 );
+did_pass = ( did_pass ) && ( 0 == cJSON_DocumentGetChild( document, item ) );
+did_pass = ( did_pass ) && ( 0 == cJSON_DocumentGetSize( document, item ) );
+did_pass = ( did_pass ) && ( cJSON_Object == cJSON_DocumentGetType( document, cJSON_DocumentGetNext( document, item ) ) );
+item     = cJSON_DocumentGetArrayItem( document, value, 3 );
+did_pass = ( did_pass ) && ( cJSON_True == cJSON_DocumentGetType( document, cJSON_DocumentGetChild( document, item ) ) );
+did_pass = ( did_pass ) && ( 0 == cJSON_DocumentGetNext( document, item ) );
+did_pass = ( did_pass ) && ( 0 == cJSON_DocumentGetArrayItem( document, value, 4 ) );
+
+// Members are visited in order, each with its decoded key.
+len = 0;
+for( item = cJSON_DocumentGetChild( document, 0 ); 0 != item; item = cJSON_DocumentGetNext( document, item ) )
+    {
+    len++;
+    }
+did_pass = ( did_pass ) && ( 6 == len );
+
+value    = cJSON_DocumentGetObjectItem( document, 0, "key\"" );
+text     = cJSON_DocumentGetKey( document, value, &len );
+did_pass = ( did_pass ) && ( NULL != text ) && ( 4 == len ) && ( 0 == strcmp( "key\"", text ) );
+did_pass = ( did_pass ) && ( 0 == strcmp( "v", cJSON_DocumentGetString( document, value, NULL ) ) );
+did_pass = ( did_pass ) && ( cJSON_False == cJSON_DocumentGetType( document, cJSON_DocumentGetObjectItem( document, 0, "ok" ) ) );
+did_pass = ( did_pass ) && ( cJSON_Null == cJSON_DocumentGetType( document, cJSON_DocumentGetObjectItem( document, 0, "none" ) ) );
+did_pass = ( did_pass ) && ( 0 == cJSON_DocumentGetObjectItem( document, 0, "missing" ) );
+
+// Array items and the root have no keys.
+did_pass = ( did_pass ) && ( NULL == cJSON_DocumentGetKey( document, 0, NULL ) );
+did_pass = ( did_pass ) && ( NULL == cJSON_DocumentGetKey( document, cJSON_DocumentGetArrayItem( document, cJSON_DocumentGetObjectItem( document, 0, "tags" ), 1 ), NULL ) );
+cJSON_DocumentDelete( document );
+
+// A scalar can be a whole document.
+document = cJSON_DocumentParse( "\"text\"", 6 );
+did_pass = ( did_pass ) && ( NULL != document );
+did_pass = ( did_pass ) && ( 0 == strcmp( "text", cJSON_DocumentGetString( document, 0, NULL ) ) );
+did_pass = ( did_pass ) && ( 0 == cJSON_DocumentGetNext( document, 0 ) );
+cJSON_DocumentDelete( document );
+
+// Enough nesting to move the stack of open containers while they are
+// counted. Every level holds its child and a 2.
+for( len = 0; len < 64; len++ )
+    {
+    nested_str[len] = '[';
+    nested_str[64 + 1 + 3 * len]     = ',';
+    nested_str[64 + 1 + 3 * len + 1] = '2';
+    nested_str[64 + 1 + 3 * len + 2] = ']';
+    }
+nested_str[64] = '1';
+
+document = cJSON_DocumentParse( nested_str, 64 + 1 + 3 * 64 );
+did_pass = ( did_pass ) && ( NULL != document );
+for( value = 0, len = 0; ( did_pass ) && ( len < 64 ); len++ )
+    {
+    did_pass = ( cJSON_Array == cJSON_DocumentGetType( document, value ) ) && ( 2 == cJSON_DocumentGetSize( document, value ) );
+    value    = cJSON_DocumentGetChild( document, value );
+    item     = cJSON_DocumentGetNext( document, value );
+    did_pass = ( did_pass ) && ( 0 != item ) && ( 2 == cJSON_DocumentGetNumber( document, item ) ) && ( 0 == cJSON_DocumentGetNext( document, item ) );
+    }
+did_pass = ( did_pass ) && ( 1 == cJSON_DocumentGetNumber( document, value ) );
+cJSON_DocumentDelete( document );
+
+// Invalid documents are rejected.
+did_pass = ( did_pass ) && ( NULL == cJSON_DocumentParse( "[ 1, 2 }", 8 ) );
+did_pass = ( did_pass ) && ( NULL == cJSON_DocumentParse( "{ \"a\": [ 1 }", 12 ) );
+
+return did_pass;
+}
+
+
+/**********************************************************
+*	test_parse_false
+*
+*	Tests parsing a simple single false JSON value
+*
+**********************************************************/
+static int test_parse_false
+    (
+    void
+    )
+{
+int     did_pass;
+cJSON * json;
+
+json = cJSON_Parse( "false" );
+
+did_pass = ( NULL != json );
+did_pass = ( did_pass ) && ( cJSON_False == json->type );
+
+cJSON_Delete( json );
+
+return did_pass;
+}    
+
+
+/**********************************************************
+*	test_parse_file
+*
+*	Tests parsing a file by mapping it into memory
+*
+**********************************************************/
+static int test_parse_file
+    (
+    void
+    )
+{
+int         did_pass;
+cJSON *     json;
+FILE *      file;
+char        path[] = "/tmp/cJSON2_test_XXXXXX";
+int         fd;
+
+fd       = mkstemp( path );
+file     = ( fd < 0 ) ? NULL : fdopen( fd, "w" );
+did_pass = ( NULL != file );
+
+if( did_pass )
+    {
+    fputs( "{ \"name\": \"catalog\", \"items\": [ { \"id\": 1 }, { \"id\": 2 } ] }\n", file );
+    fclose( file );
+    }
+
+json     = cJSON_ParseFile( path, cJSON_ParseInternKeys );
+did_pass = ( did_pass ) && ( NULL != json );
+did_pass = ( did_pass ) && ( 0 == strcmp( "catalog", cJSON_GetObjectItem( json, "name" )->valuestring ) );
+did_pass = ( did_pass ) && ( 2 == cJSON_GetObjectItem( cJSON_GetArrayItem( cJSON_GetObjectItem( json, "items" ), 1 ), "id" )->valueint );
+cJSON_Delete( json );
+
+// Lazy containers keep their own copy of the mapped text.
+json     = cJSON_ParseFile( path, cJSON_ParseLazy );
+did_pass = ( did_pass ) && ( NULL != json );
+did_pass = ( did_pass ) && ( 2 == cJSON_GetArraySize( cJSON_GetObjectItem( json, "items" ) ) );
+cJSON_Delete( json );
+
+remove( path );
+
+// Missing files and things that are not regular files can't be parsed.
+did_pass = ( did_pass ) && ( NULL == cJSON_ParseFile( path, 0 ) );
+did_pass = ( did_pass ) && ( NULL == cJSON_ParseFile( "/tmp", 0 ) );
+
+return did_pass;
+}
+
+
+/**********************************************************
+*	test_parse_in_situ
+*
+*	Tests parsing a mutable buffer without copying strings
+*
+**********************************************************/
+static int test_parse_in_situ
+    (
+    void
+    )
+{
+int         did_pass;
+cJSON *     json;
+cJSON *     item;
+cJSON_Hooks hooks;
+char        buffer[] = "{ \"greeting\": \"hello\", \"list\": [ \"a\", \"bc\" ], \"empty\": \"\" }";
+
+hooks.malloc_fn  = malloc;
+hooks.realloc_fn = realloc;
+hooks.free_fn    = free;
+
+json = cJSON_ParseInSitu( buffer, strlen( buffer ), &hooks );
+did_pass = ( NULL != json );
+
+// Strings and keys should point into the buffer rather than being copied.
+item     = cJSON_GetObjectItem( json, "greeting" );
+did_pass = ( did_pass ) && ( NULL != item );
+did_pass = ( did_pass ) && ( 0 == strcmp( "hello", item->valuestring ) );
+did_pass = ( did_pass ) && ( item->valuestring > buffer ) && ( item->valuestring < buffer + sizeof( buffer ) );
+did_pass = ( did_pass ) && ( item->string > buffer ) && ( item->string < buffer + sizeof( buffer ) );
+
+item     = cJSON_GetArrayItem( cJSON_GetObjectItem( json, "list" ), 1 );
+did_pass = ( did_pass ) && ( NULL != item );
+did_pass = ( did_pass ) && ( 0 == strcmp( "bc", item->valuestring ) );
+
+item     = cJSON_GetObjectItem( json, "empty" );
+did_pass = ( did_pass ) && ( NULL != item );
+did_pass = ( did_pass ) && ( 0 == strcmp( "", item->valuestring ) );
+
+// Must not try to free the referenced strings.
+cJSON_Delete( json );
+
+return did_pass;
+}
+
+
+/**********************************************************
+*	test_parse_inline_strings
+*
+*	Tests that short keys and string values are stored in their node
+*
+**********************************************************/
+static int test_parse_inline_strings
+    (
+    void
+    )
+{
+int             did_pass;
+cJSON *         json;
+cJSON *         item;
+char const *    json_str;
+
+json_str = "{ \"id\": \"short\", \"a key too long to be kept inline\": \"x\", \"name\": \"a value too long to fit after its key\", \"esc\\n\": \"\\u00e9\" }";
+json     = cJSON_Parse( json_str );
+did_pass = ( NULL != json );
+
+// A short key and value share the node's inline storage.
+item     = ( did_pass ) ? json->child : NULL;
+did_pass = ( did_pass ) && ( ( cJSON_KeyInline | cJSON_ValueInline ) == ( item->flags & ( cJSON_KeyInline | cJSON_ValueInline ) ) );
+did_pass = ( did_pass ) && ( item->string == item->inline_strings ) && ( 0 == strcmp( "id", item->string ) );
+did_pass = ( did_pass ) && ( item->valuestring == &item->inline_strings[3] ) && ( 0 == strcmp( "short", item->valuestring ) );
+
+// Either one can spill to the heap on its own.
+item     = ( did_pass ) ? item->next : NULL;
+did_pass = ( did_pass ) && ( !( item->flags & cJSON_KeyInline ) ) && ( item->flags & cJSON_ValueInline );
+did_pass = ( did_pass ) && ( item->valuestring == item->inline_strings ) && ( 0 == strcmp( "x", item->valuestring ) );
+item     = ( did_pass ) ? item->next : NULL;
+did_pass = ( did_pass ) && ( item->flags & cJSON_KeyInline ) && ( !( item->flags & cJSON_ValueInline ) );
+did_pass = ( did_pass ) && ( 0 == strcmp( "a value too long to fit after its key", item->valuestring ) );
+
+// Inline strings are decoded like any other.
+item     = ( did_pass ) ? item->next : NULL;
+did_pass = ( did_pass ) && ( item->flags & cJSON_KeyInline ) && ( item->flags & cJSON_ValueInline );
+did_pass = ( did_pass ) && ( 0 == strcmp( "esc\n", item->string ) ) && ( 0 == strcmp( "\xC3\xA9", item->valuestring ) );
+did_pass = ( did_pass ) && ( item == cJSON_GetObjectItem( json, "esc\n" ) );
+
+cJSON_Delete( json );
+
+return did_pass;
+}
+
+
+/**********************************************************
+*	test_parse_intern_keys
+*
+*	Tests sharing one copy of each repeated object key
+*
+**********************************************************/
+static int test_parse_intern_keys
+    (
+    void
+    )
+{
+int             did_pass;
+cJSON *         json;
+cJSON *         first;
+cJSON *         second;
+cJSON_Parser *  parser;
+cJSON_Hooks     hooks;
+char const *    json_str;
+
+hooks.malloc_fn  = malloc;
+hooks.realloc_fn = realloc;
+hooks.free_fn    = free;
+
+json_str = "[{\"id\":1,\"name\":\"a\",\"tags\":{\"id\":3}},{\"id\":2,\"name\":\"b\"},{\"name\":\"c\",\"other\":null}]";
+json     = cJSON_ParseWithFlags( json_str, strlen( json_str ), cJSON_ParseInternKeys, &hooks );
+did_pass = ( NULL != json );
+
+// Every occurrence of a key shares one copy, at any depth.
+first    = cJSON_GetArrayItem( json, 0 );
+second   = cJSON_GetArrayItem( json, 1 );
+did_pass = ( did_pass ) && ( first->child->flags & cJSON_KeyInterned );
+did_pass = ( did_pass ) && ( first->child->string == second->child->string );
+did_pass = ( did_pass ) && ( first->child->string == cJSON_GetObjectItem( cJSON_GetObjectItem( first, "tags" ), "id" )->string );
+did_pass = ( did_pass ) && ( 0 == strcmp( "other", cJSON_GetArrayItem( json, 2 )->child->next->string ) );
+
+// Looking a key up with an interned pointer finds the same item.
+did_pass = ( did_pass ) && ( 2 == cJSON_GetObjectItem( second, first->child->string )->valueint );
+
+// Shared keys are freed once, when the last node using them is deleted.
+cJSON_Delete( json );
+
+// Whole documents parsed by a parser intern their keys too.
+parser   = cJSON_ParserCreate();
+json     = cJSON_ParserParse( parser, json_str, strlen( json_str ) );
+did_pass = ( did_pass ) && ( NULL != json );
+did_pass = ( did_pass ) && ( cJSON_GetArrayItem( json, 0 )->child->string == cJSON_GetArrayItem( json, 1 )->child->string );
+json     = cJSON_ParserParse( parser, "{\"k\":[{\"k\":1}]}", 15 );
+did_pass = ( did_pass ) && ( NULL != json ) && ( json->child->string == json->child->child->child->string );
+cJSON_ParserDelete( parser );
+
+return did_pass;
+}
+
+
+/**********************************************************
+*	test_parse_lazy
+*
+*	Tests parsing nested containers only when they are accessed
+*
+**********************************************************/
+static int test_parse_lazy
+    (
+    void
+    )
+{
+int         did_pass;
+cJSON *     json;
+cJSON *     item;
+char *      printed;
+cJSON_Hooks hooks;
+char const* json_str;
+
+hooks.malloc_fn  = malloc;
+hooks.realloc_fn = realloc;
+hooks.free_fn    = free;
+
+json_str = "{\"id\":7,\"user\":{ \"name\" : \"a]}\\\"b\", \"roles\": [ \"admin\", { \"x\": [] } ] },\"list\":[1, [2, 3]],\"bad\":[1 2]}";
+json     = cJSON_ParseWithFlags( json_str, strlen( json_str ), cJSON_ParseLazy, &hooks );
+did_pass = ( NULL != json );
+
+// Only the top-level object is parsed; nested containers keep their text.
+item     = cJSON_GetObjectItem( json, "user" );
+did_pass = ( did_pass ) && ( NULL != item ) && ( cJSON_Object == item->type );
+did_pass = ( did_pass ) && ( item->flags & cJSON_IsLazy ) && ( NULL == item->child );
+
+// Untouched containers are printed exactly as they were written.
+printed  = cJSON_Print( json );
+did_pass = ( did_pass ) && ( NULL != printed ) && ( 0 == strcmp( json_str, printed ) );
+free( printed );
+
+// Accessing a container parses one more level.
+item     = cJSON_GetObjectItem( item, "roles" );
+did_pass = ( did_pass ) && ( NULL != item ) && ( item->flags & cJSON_IsLazy );
+did_pass = ( did_pass ) && ( 2 == cJSON_GetArraySize( item ) ) && ( !( item->flags & cJSON_IsLazy ) );
+did_pass = ( did_pass ) && ( 0 == strcmp( "admin", cJSON_GetArrayItem( item, 0 )->valuestring ) );
+did_pass = ( did_pass ) && ( item == cJSON_GetArrayItem( item, 1 )->parent );
+did_pass = ( did_pass ) && ( 0 == strcmp( "a]}\"b", cJSON_GetObjectItem( cJSON_GetObjectItem( json, "user" ), "name" )->valuestring ) );
+did_pass = ( did_pass ) && ( 3 == cJSON_GetArrayItem( cJSON_GetArrayItem( cJSON_GetObjectItem( json, "list" ), 1 ), 1 )->valueint );
+
+printed  = cJSON_Print( json );
+did_pass = ( did_pass ) && ( NULL != printed ) && ( 0 == strcmp( "{\"id\":7,\"user\":{\"name\":\"a]}\\\"b\",\"roles\":[\"admin\",{ \"x\": [] }]},\"list\":[1,[2,3]],\"bad\":[1 2]}", printed ) );
+free( printed );
+
+// Invalid containers are only found when accessed.
+item     = cJSON_GetObjectItem( json, "bad" );
+did_pass = ( did_pass ) && ( NULL == cJSON_GetArrayItem( item, 0 ) ) && ( -1 == cJSON_GetArraySize( item ) );
+did_pass = ( did_pass ) && ( item->flags & cJSON_IsLazy );
+
+cJSON_Delete( json );
+
+// Unbalanced brackets are still rejected up front.
+json_str = "{\"a\":[1,{\"b\":2]}";
+did_pass = ( did_pass ) && ( NULL == cJSON_ParseWithFlags( json_str, strlen( json_str ), cJSON_ParseLazy, &hooks ) );
+
+return did_pass;
+}
+
+
+/**********************************************************
+*	test_parse_ndjson
+*
+*	Tests parsing newline-delimited JSON records on several threads
+*
+**********************************************************/
+static int test_parse_ndjson
+    (
+    void
+    )
+{
+int         did_pass;
+int         in_order;
+int         i;
+char *      ndjson_str;
+size_t      ndjson_len;
+ndjson_log  log;
+int         record_cnt;
+
+record_cnt = 20000;
+
+// Make the input big enough to be split into several batches.
+ndjson_str = (char*)malloc( record_cnt * 64 );
+ndjson_len = 0;
+did_pass   = ( NULL != ndjson_str );
+
+for( i = 0; ( did_pass ) && ( i < record_cnt ); i++ )
+    {
+    ndjson_len += sprintf( &ndjson_str[ndjson_len], "{\"id\":%d,\"tags\":[\"a\",\"b\"],\"ok\":true}\n%s", i, ( 0 == i % 1000 ) ? "\r\n" : "" );
+    }
+
+for( in_order = 0; ( did_pass ) && ( in_order <= 1 ); in_order++ )
+    {
+    memset( &log, 0, sizeof( log ) );
+    log.ndjson_str = ndjson_str;
+    log.is_ordered = 1;
+    log.stop_after = (size_t)-1;
+
+    did_pass = cJSON_ParseNDJSON( ndjson_str, ndjson_len, 4, in_order, ndjson_log_record, &log );
+    did_pass = ( did_pass ) && ( record_cnt == log.record_cnt );
+    did_pass = ( did_pass ) && ( 0 == log.invalid_cnt );
+    did_pass = ( did_pass ) && ( (long long)record_cnt * ( record_cnt - 1 ) / 2 == log.id_sum );
+    did_pass = ( did_pass ) && ( ( !in_order ) || ( log.is_ordered ) );
+    }
+
+// The handler can stop the parse.
+memset( &log, 0, sizeof( log ) );
+log.ndjson_str = ndjson_str;
+log.is_ordered = 1;
+log.stop_after = 10;
+did_pass = ( did_pass ) && ( !cJSON_ParseNDJSON( ndjson_str, ndjson_len, 4, 1, ndjson_log_record, &log ) );
+did_pass = ( did_pass ) && ( 10 == log.record_cnt ) && ( log.is_ordered );
+
+// Invalid records are delivered as NULL without stopping the parse.
+memset( &log, 0, sizeof( log ) );
+log.ndjson_str = "{\"id\":0}\n[ 1, \n{\"id\":1}";
+log.is_ordered = 1;
+log.stop_after = (size_t)-1;
+did_pass = ( did_pass ) && ( !cJSON_ParseNDJSON( log.ndjson_str, strlen( log.ndjson_str ), 0, 1, ndjson_log_record, &log ) );
+did_pass = ( did_pass ) && ( 3 == log.record_cnt ) && ( 1 == log.invalid_cnt ) && ( log.is_ordered );
+
+free( ndjson_str );
+
+return did_pass;
+}
+
+
+/**********************************************************
+*	test_parse_null
+*
+*	Tests parsing a simple single null JSON value
+*
+**********************************************************/
+static int test_parse_null
+    (
+    void
+    )
+{
+int     did_pass;
+cJSON * json;
+
+json = cJSON_Parse( "null" );
+
+did_pass = ( NULL != json );
+did_pass = ( did_pass ) && ( cJSON_Null == json->type );
+
+cJSON_Delete( json );
+
+return did_pass;
+}
+
+
+/**********************************************************
+*	test_parse_number
+*
+*	Tests parsing numbers
+*
+**********************************************************/
+static int test_parse_number
+    (
+    void
+    )
+{
+parse_number_test_case test_cases[] =
+    {/*     JSON,       should_parse_succeed,   exptd_value     */
+        {   "1.0",      1,                      1.0             },
+        {   "1",        1,                      1.0             },
+        {   "1.7e3",    1,                      1.7e3           },
+        {   "Infinity", 1,                      INFINITY        },
+        {   "-Infinity",1,                     -INFINITY        },
+        {   "-1.0",     1,                      -1.0            },
+        {   "-0",       1,                      0.0             },
+        {   "0.125",    1,                      0.125           },
+        {   "1E+2",     1,                      100.0           },
+        {   "25e-1",    1,                      2.5             },
+        {   "-hello",   0,                      0.0             },
+        {   "1.hello",  0,                      0.0             },
+        {   "1,0hello", 0,                      0.0             },
+        {   "01",       0,                      0.0             },
+        {   "+1",       0,                      0.0             },
+        {   ".5",       0,                      0.0             },
+        {   "1.",       0,                      0.0             },
+        {   "1e",       0,                      0.0             },
+        {   "-",        0,                      0.0             },
+        {   "1e400",    0,                      0.0             },
+        {   "1e-400",   0,                      0.0             }
+    };
+
+cJSON * json;
+int     i;
+int     did_pass;
+
+did_pass = 1;
+
+for( i = 0; ( did_pass ) && ( i < cnt_of_array( test_cases ) ); i++ )
+    {
+    json = cJSON_Parse( test_cases[i].json );
+
+    if( test_cases[i].should_parse_succeed )
+        {
+        did_pass = ( NULL != json );
+        did_pass = ( did_pass ) && ( cJSON_Number == json->type );
+        did_pass = ( did_pass ) && ( test_cases[i].exptd_value == json->valuedouble );
+        }
+    else
+        {
+        did_pass = ( NULL == json );
+        }
+
+    cJSON_Delete( json );
+    }
+
+// Special test for parsing NaN
+json = cJSON_Parse( "NaN" );
+did_pass = ( did_pass ) && ( NULL != json );
+did_pass = ( did_pass ) && ( cJSON_Number == json->type );
+did_pass = ( did_pass ) && ( isnan( json->valuedouble ) );
+cJSON_Delete( json );
+
+return did_pass;
+}
+
+
+/**********************************************************
+*	test_parse_number_exact
+*
+*	Tests that parsed numbers are correctly rounded
+*
+**********************************************************/
+static int test_parse_number_exact
+    (
+    void
+    )
+{
+int             did_pass;
+cJSON *         json;
+cJSON_Arena *   arena;
+cJSON_Hooks     hooks;
+size_t          malloc_cnt;
+int             i;
+
+// Results must be identical to a correctly rounded conversion, whether they
+// take the fast path or not.
+char const * numbers[] =
+    {
+    "0.1",
+    "-122.41941550000001",
+    "37.774929",
+    "1234567890123",
+    "9007199254740993",
+    "123.456e-5",
+    "3.14159265358979323846264338327950288",
+    "2.2250738585072014e-308",
+    "1.7976931348623157e308",
+    "4.9e-324",
+    "0.000000000000000000000000000001",
+    "123456789012345678901234567890",
+    "1e22",
+    "1e23",
+    "8.98846567431158e307",
+    "0.000000000000000000000000000000000000000000000000000000000000123456789012345678",
+    "-0",
+    };
+
+did_pass = 1;
+
+for( i = 0; ( did_pass ) && ( i < cnt_of_array( numbers ) ); i++ )
+    {
+    json = cJSON_Parse( numbers[i] );
+    did_pass = ( NULL != json );
+    did_pass = ( did_pass ) && ( cJSON_Number == json->type );
+    did_pass = ( did_pass ) && ( strtod( numbers[i], NULL ) == json->valuedouble );
+    did_pass = ( did_pass ) && ( !signbit( strtod( numbers[i], NULL ) ) == !signbit( json->valuedouble ) );
+    cJSON_Delete( json );
+    }
+
+// Numbers too long for the stack, like the long fraction above, are copied
+// with the parse's hooks, or into its arena.
+hooks.malloc_fn  = counted_malloc;
+hooks.realloc_fn = realloc;
+hooks.free_fn    = free;
+
+malloc_cnt = counted_malloc_cnt;
+json       = cJSON_ParseWithLength( numbers[15], strlen( numbers[15] ), &hooks );
+did_pass   = ( did_pass ) && ( NULL != json ) && ( strtod( numbers[15], NULL ) == json->valuedouble );
+did_pass   = ( did_pass ) && ( malloc_cnt + 2 == counted_malloc_cnt );
+cJSON_Delete( json );
+
+arena    = cJSON_ArenaCreate();
+json     = cJSON_ParseArena( numbers[15], arena );
+did_pass = ( did_pass ) && ( NULL != json ) && ( strtod( numbers[15], NULL ) == json->valuedouble );
+cJSON_ArenaDelete( arena );
+
+// Values outside the range of an int saturate.
+json = cJSON_Parse( "[1e10, -1e10, 7.9]" );
+did_pass = ( did_pass ) && ( NULL != json );
+did_pass = ( did_pass ) && ( 2147483647 == cJSON_GetArrayItem( json, 0 )->valueint );
+did_pass = ( did_pass ) && ( -2147483647 - 1 == cJSON_GetArrayItem( json, 1 )->valueint );
+did_pass = ( did_pass ) && ( 7 == cJSON_GetArrayItem( json, 2 )->valueint );
+cJSON_Delete( json );
+
+return did_pass;
+}
+
+
+/**********************************************************
+*	test_parse_number_int64
+*
+*	Tests that integers are kept exactly in 64 bits
+*
+**********************************************************/
+static int test_parse_number_int64
+    (
+    void
+    )
+{
+int     did_pass;
+cJSON * json;
+cJSON * item;
+
+json = cJSON_Parse( "[9007199254740993, -9223372036854775808, 9223372036854775807, 9223372036854775808, 1.0, 1e2, -0]" );
+did_pass = ( NULL != json );
+
+// Integers above 2^53 must keep every digit.
+item     = cJSON_GetArrayItem( json, 0 );
+did_pass = ( did_pass ) && ( item->flags & cJSON_IsInt64 );
+did_pass = ( did_pass ) && ( INT64_C( 9007199254740993 ) == item->valueint64 );
+did_pass = ( did_pass ) && ( 9007199254740992.0 == item->valuedouble );
+did_pass = ( did_pass ) && ( 2147483647 == item->valueint );
+
+item     = cJSON_GetArrayItem( json, 1 );
+did_pass = ( did_pass ) && ( item->flags & cJSON_IsInt64 );
+did_pass = ( did_pass ) && ( INT64_MIN == item->valueint64 );
+
+item     = cJSON_GetArrayItem( json, 2 );
+did_pass = ( did_pass ) && ( item->flags & cJSON_IsInt64 );
+did_pass = ( did_pass ) && ( INT64_MAX == item->valueint64 );
+
+// Out of range for an int64, or not written as an integer.
+item     = cJSON_GetArrayItem( json, 3 );
+did_pass = ( did_pass ) && ( !( item->flags & cJSON_IsInt64 ) );
+did_pass = ( did_pass ) && ( 9223372036854775808.0 == item->valuedouble );
+
+item     = cJSON_GetArrayItem( json, 4 );
+did_pass = ( did_pass ) && ( !( item->flags & cJSON_IsInt64 ) );
+
+item     = cJSON_GetArrayItem( json, 5 );
+did_pass = ( did_pass ) && ( !( item->flags & cJSON_IsInt64 ) );
+
+// An int64 can't hold the sign of -0.
+item     = cJSON_GetArrayItem( json, 6 );
+did_pass = ( did_pass ) && ( !( item->flags & cJSON_IsInt64 ) );
+did_pass = ( did_pass ) && ( 0.0 == item->valuedouble ) && ( signbit( item->valuedouble ) );
+
+cJSON_Delete( json );
+
+return did_pass;
+}
+
+
+/**********************************************************
+*	test_parse_object_simple_values
+*
+*	Tests parsing an object
+*
+**********************************************************/
+static int test_parse_object_simple_values
+    (
+    void
+    )
+{
+int     did_pass;
+cJSON * json;
+
+json = cJSON_Parse( "{ \"hello\" : \"world\", \"array\": [], \"null\": null, \"true\" : true }" );
+did_pass = ( NULL != json );
+did_pass = ( did_pass ) && ( cJSON_Object == json->type );
+
+cJSON_Delete( json );
+
+return did_pass;
+}
+
+
+/**********************************************************
+*	test_parse_object_empty
+*
+*	Tests parsing an empty object
+*
+**********************************************************/
+static int test_parse_object_empty
+    (
+    void
+    )
+{
+int     did_pass;
+cJSON * json;
+
+json = cJSON_Parse( "{}" );
+did_pass = ( NULL != json );
+did_pass = ( did_pass ) && ( cJSON_Object == json->type );
+
+cJSON_Delete( json );
+
+return did_pass;
+}
+
+
+/**********************************************************
+*	test_parse_parallel
+*
+*	Tests splitting a large document into segments parsed in parallel
+*
+**********************************************************/
+static int test_parse_parallel
+    (
+    void
+    )
+{
+int             did_pass;
+size_t          i;
+size_t          json_len;
+char *          json_str;
+char *          printed;
+char *          expected;
+cJSON *         json;
+cJSON_Hooks     hooks;
+char const *    item = "{\"id\":12,\"tags\":[\"a,b\",\"]\\\"\"],\"nested\":{\"x\":[1,[2]]}},";
+char            member[32];
+
+hooks.malloc_fn  = malloc;
+hooks.realloc_fn = realloc;
+hooks.free_fn    = free;
+
+// An array big enough to split into several segments, whose strings hold
+// commas, brackets and escaped quotes.
+json_str = (char*)malloc( 4 * 1024 * 1024 + 64 );
+did_pass = ( NULL != json_str );
+if( !did_pass )
+    {
+    return 0;
+    }
+
+json_str[0] = '[';
+for( json_len = 1; json_len < 4 * 1024 * 1024; json_len += strlen( item ) )
+    {
+    memcpy( &json_str[json_len], item, strlen( item ) );
+    }
+json_str[json_len - 1] = ']';
+
+json     = cJSON_ParseWithLength( json_str, json_len, &hooks );
+expected = cJSON_Print( json );
+cJSON_Delete( json );
+
+json     = cJSON_ParseParallel( json_str, json_len, 4 );
+printed  = cJSON_Print( json );
+did_pass = ( NULL != json ) && ( NULL != expected ) && ( NULL != printed ) && ( 0 == strcmp( expected, printed ) );
+did_pass = ( did_pass ) && ( json == json->child->next->parent );
+did_pass = ( did_pass ) && ( json == cJSON_GetArrayItem( json, cJSON_GetArraySize( json ) - 1 )->parent );
+free( printed );
+cJSON_Delete( json );
+
+// An error in any segment fails the whole parse, as does a trailing comma.
+json_str[json_len - 9] = '@';
+did_pass = ( did_pass ) && ( NULL == cJSON_ParseParallel( json_str, json_len, 4 ) );
+json_str[json_len - 9] = '1';
+json_str[json_len - 1]  = ',';
+json_str[json_len]      = ']';
+did_pass = ( did_pass ) && ( NULL == cJSON_ParseParallel( json_str, json_len + 1, 4 ) );
+free( expected );
+
+// Objects are split between members.
+json_str[0] = '{';
+json_len    = 1;
+for( i = 0; json_len < 3 * 1024 * 1024; i++ )
+    {
+    json_len += sprintf( &json_str[json_len], "\"k%lu\":[%lu,\"}\"],", (unsigned long)i, (unsigned long)i );
+    }
+json_str[json_len - 1] = '}';
+
+json     = cJSON_ParseWithLength( json_str, json_len, &hooks );
+expected = cJSON_Print( json );
+cJSON_Delete( json );
+
+json     = cJSON_ParseParallel( json_str, json_len, 3 );
+printed  = cJSON_Print( json );
+did_pass = ( did_pass ) && ( NULL != json ) && ( NULL != expected ) && ( NULL != printed ) && ( 0 == strcmp( expected, printed ) );
+sprintf( member, "k%lu", (unsigned long)( i - 1 ) );
+did_pass = ( did_pass ) && ( NULL != cJSON_GetObjectItem( json, member ) );
+free( printed );
+free( expected );
+cJSON_Delete( json );
+free( json_str );
+
+// Small documents and scalars are parsed on the calling thread.
+json     = cJSON_ParseParallel( "[1,2,3]", 7, 4 );
+did_pass = ( did_pass ) && ( NULL != json ) && ( 3 == cJSON_GetArraySize( json ) );
+cJSON_Delete( json );
+
+json     = cJSON_ParseParallel( " 7 ", 3, 0 );
+did_pass = ( did_pass ) && ( NULL != json ) && ( 7 == json->valueint );
+cJSON_Delete( json );
+
+return did_pass;
+}
+
+
+/**********************************************************
+*	test_parse_sax
+*
+*	Tests reporting a document's values through SAX callbacks
+*
+**********************************************************/
+static int test_parse_sax
+    (
+    void
+    )
+{
+int                 did_pass;
+sax_log             log;
+cJSON_SaxHandler    handler;
+char const *        json_str;
+
+memset( &handler, 0, sizeof( handler ) );
+handler.start_object = sax_log_start_object;
+handler.end_object   = sax_log_end_object;
+handler.start_array  = sax_log_start_array;
+handler.end_array    = sax_log_end_array;
+handler.key          = sax_log_key;
+handler.string       = sax_log_string;
+handler.number       = sax_log_number;
+handler.int64        = sax_log_int64;
+handler.boolean      = sax_log_boolean;
+handler.null         = sax_log_null;
+
+json_str = "{ \"a\": [ 1, 2.5, \"x\\\"y\", [], {} ], \"b\": { \"c\": null, \"d\": true }, \"e\": false }";
+
+// Every value should be reported in document order.
+memset( &log, 0, sizeof( log ) );
+log.stop_after = -1;
+did_pass = cJSON_ParseSax( json_str, strlen( json_str ), &handler, &log );
+did_pass = ( did_pass ) && ( 0 == strcmp( "{a:[i1 d2.5 'x\"y' []{}]b:{c:null d:true }e:false }", log.text ) );
+
+// Without an int64 callback, integers are reported as doubles.
+handler.int64 = NULL;
+memset( &log, 0, sizeof( log ) );
+log.stop_after = -1;
+did_pass = ( did_pass ) && ( cJSON_ParseSax( "[ 7, -Infinity ]", 16, &handler, &log ) );
+did_pass = ( did_pass ) && ( 0 == strcmp( "[d7 d-inf ]", log.text ) );
+
+// A callback can stop the parse.
+memset( &log, 0, sizeof( log ) );
+log.stop_after = 4;
+did_pass = ( did_pass ) && ( !cJSON_ParseSax( json_str, strlen( json_str ), &handler, &log ) );
+did_pass = ( did_pass ) && ( 0 == strcmp( "{a:[", log.text ) );
+
+// Invalid documents are reported after the events leading up to the error.
+memset( &log, 0, sizeof( log ) );
+log.stop_after = -1;
+did_pass = ( did_pass ) && ( !cJSON_ParseSax( "[ 1, 2 }", 8, &handler, &log ) );
+did_pass = ( did_pass ) && ( !cJSON_ParseSax( "[ 1 ] 2", 7, &handler, &log ) );
+did_pass = ( did_pass ) && ( !cJSON_ParseSax( "{ \"a\" 1 }", 9, &handler, &log ) );
+
+// Callbacks that aren't set are skipped.
+memset( &handler, 0, sizeof( handler ) );
+did_pass = ( did_pass ) && ( cJSON_ParseSax( json_str, strlen( json_str ), &handler, NULL ) );
+
+return did_pass;
+}
+
+
+/**********************************************************
+*	test_parse_select
+*
+*	Tests parsing only the values selected by JSON Pointers
+*
+**********************************************************/
+static int test_parse_select
+    (
+    void
+    )
+{
+int                 did_pass;
+cJSON *             json;
+char *              printed;
+char const *        json_str;
+char const * const  paths[] = { "/user/name", "/list/1", "/a~1b", "/missing/x", "/id/x" };
+char const * const  whole[] = { "" };
+char const * const  bad[]   = { "user" };
+
+json_str = "{\"id\":7,\"user\":{ \"name\" : \"a]}\\\"b\", \"roles\": [ \"admin\", { \"x\": [] } ] },\"list\":[1, [2, 3], tru],\"a/b\":{\"c\":null}}";
+json     = cJSON_ParseSelect( json_str, strlen( json_str ), paths, cnt_of_array( paths ) );
+did_pass = ( NULL != json );
 
-for( i = 0; ( did_pass ) && ( i < cnt_of_array( test_cases ) ); i++ )
-    {
-    json_item = cJSON_GetObjectItem( json_object, test_cases[i].key );
-    did_pass = ( NULL != json_item );
-    did_pass = ( did_pass ) && ( test_cases[i].value_type == json_item->type );
+// Only the selected values and their ancestors are built.
+printed  = cJSON_Print( json );
+did_pass = ( did_pass ) && ( NULL != printed ) && ( 0 == strcmp( "{\"user\":{\"name\":\"a]}\\\"b\"},\"list\":[[2,3]],\"a/b\":{\"c\":null}}", printed ) );
+free( printed );
+did_pass = ( did_pass ) && ( json == cJSON_GetObjectItem( json, "list" )->parent );
 
-    // The has item function should return true
-    did_pass = ( did_pass ) && ( cJSON_ObjectHasItem( json_object, test_cases[i].key ) );
-    }
+// Selected array items are renumbered among themselves.
+did_pass = ( did_pass ) && ( 1 == cJSON_GetArraySize( cJSON_GetObjectItem( json, "list" ) ) );
+did_pass = ( did_pass ) && ( 3 == cJSON_GetArrayItem( cJSON_GetArrayItem( cJSON_GetObjectItem( json, "list" ), 0 ), 1 )->valueint );
+cJSON_Delete( json );
 
-// Should fail to look up keys that are not in the object
-json_item = cJSON_GetObjectItem( json_object, "notAKey" );
-did_pass = ( did_pass ) && ( NULL == json_item );
+// The empty pointer selects the whole document. Only json_len characters
+// are parsed.
+json     = cJSON_ParseSelect( "[1, {\"a\":2}] trailing", 12, whole, cnt_of_array( whole ) );
+printed  = cJSON_Print( json );
+did_pass = ( did_pass ) && ( NULL != printed ) && ( 0 == strcmp( "[1,{\"a\":2}]", printed ) );
+free( printed );
+cJSON_Delete( json );
 
-cJSON_Delete( json_object );
+// Skipped values must still be balanced, selected values must be valid.
+did_pass = ( did_pass ) && ( NULL == cJSON_ParseSelect( "{\"id\":[1,{]},\"user\":{}}", 23, paths, cnt_of_array( paths ) ) );
+did_pass = ( did_pass ) && ( NULL == cJSON_ParseSelect( "{\"list\":[1,[2,]]}", 17, paths, cnt_of_array( paths ) ) );
+did_pass = ( did_pass ) && ( NULL == cJSON_ParseSelect( "{\"id\":7} 1", 10, paths, cnt_of_array( paths ) ) );
+did_pass = ( did_pass ) && ( NULL == cJSON_ParseSelect( "{\"id\":7}", 8, bad, cnt_of_array( bad ) ) );
 
 return did_pass;
 }
 
 
 /**********************************************************
-*	test_parse_array_empty
+*	test_parse_string
 *
-*	Tests parsing an empty JSON array.
+*	Tests parsing a simple string
 *
 **********************************************************/
-static int test_parse_array_empty
+static int test_parse_string
     (
     void
     )
@@ -323,12 +2288,12 @@ static int test_parse_array_empty
 int     did_pass;
 cJSON * json;
 
-json = cJSON_Parse( "[]" );
-
+json = cJSON_Parse( "\"hello\"" );
 did_pass = ( NULL != json );
-did_pass = ( did_pass ) && ( cJSON_Array == json->type );
-did_pass = ( did_pass ) && ( 0 == cJSON_GetArraySize( json ) );
-did_pass = ( did_pass ) && ( NULL == cJSON_GetArrayItem( json, 0 ) );
+did_pass = ( did_pass ) && ( cJSON_String == json->type );
+did_pass = ( did_pass ) && ( NULL != json->valuestring  );
+did_pass = ( did_pass ) && ( strlen( "hello" ) == strlen( json->valuestring ) );
+did_pass = ( did_pass ) && ( 0 == strcmp( "hello", json->valuestring ) );
 
 cJSON_Delete( json );
 
@@ -337,45 +2302,24 @@ return did_pass;
 
 
 /**********************************************************
-*	test_parse_array_simple_values
+*	test_parse_string_empty
 *
-*	Tests parsing an JSON array containing simple values.
+*	Tests parsing an empty string
 *
 **********************************************************/
-static int test_parse_array_simple_values
+static int test_parse_string_empty
     (
     void
     )
 {
 int     did_pass;
 cJSON * json;
-int     idx;
-cJSON * array_item;
-
-const cJSON_ValueType exptd_values[] =
-    {
-    cJSON_Null,
-    cJSON_False,
-    cJSON_Array,
-    cJSON_Object,
-    cJSON_String,
-    cJSON_Number,
-    cJSON_True,
-    cJSON_Array,
-    };
-
-json = cJSON_Parse( "[null, false, [], {}, \"hello\", 1.0,  true, []]" );
 
+json = cJSON_Parse( "\"\"" );
 did_pass = ( NULL != json );
-did_pass = ( did_pass ) && ( cJSON_Array == json->type );
-did_pass = ( did_pass ) && ( cJSON_GetArraySize( json ) == cnt_of_array( exptd_values ) );
-
-for( idx = 0; ( did_pass ) && ( idx < cnt_of_array( exptd_values ) ); idx++ )
-    {
-    array_item = cJSON_GetArrayItem( json, idx );
-    did_pass = ( did_pass ) && ( NULL != array_item );
-    did_pass = ( did_pass ) && ( exptd_values[idx] == array_item->type );
-    }
+did_pass = ( did_pass ) && ( cJSON_String == json->type );
+did_pass = ( did_pass ) && ( NULL != json->valuestring  );
+did_pass = ( did_pass ) && ( 0 == strcmp( "", json->valuestring ) );
 
 cJSON_Delete( json );
 
@@ -384,37 +2328,109 @@ return did_pass;
 
 
 /**********************************************************
-*	test_parse_false
+*	test_parse_string_escapes
 *
-*	Tests parsing a simple single false JSON value
+*	Tests decoding escape sequences, validating UTF-8 and escaping them again when printing
 *
 **********************************************************/
-static int test_parse_false
+static int test_parse_string_escapes
     (
     void
     )
 {
-int     did_pass;
-cJSON * json;
+int                 did_pass;
+size_t              i;
+cJSON *             json;
+cJSON_Hooks         hooks;
+sax_log             log;
+cJSON_SaxHandler    handler;
+char *              printed;
+char const *        json_str;
+char                buffer[] = "[\"a\\tb\\u00e9\\ud83d\\ude00\"]";
+char const *        invalid[] =
+    {
+    "\"\\x\"",              /* Unknown escape               */
+    "\"\\u12\"",            /* Short escape                 */
+    "\"\\ud83d\"",          /* High surrogate on its own    */
+    "\"\\ude00\"",          /* Low surrogate on its own     */
+    "\"\\ud83d\\u0041\"",   /* High surrogate, no low one   */
+    "\"\xc0\xaf\"",         /* Overlong encoding            */
+    "\"\xe0\x80\xaf\"",     /* Overlong encoding            */
+    "\"\xed\xa0\x80\"",     /* Encoded surrogate            */
+    "\"\xf4\x90\x80\x80\"", /* Past U+10FFFF                */
+    "\"\xe2\x82\"",         /* Truncated sequence           */
+    "\"\x80\"",             /* Stray continuation byte      */
+    "\"a\x01\"",            /* Unescaped control character  */
+    };
 
-json = cJSON_Parse( "false" );
+hooks.malloc_fn  = malloc;
+hooks.realloc_fn = realloc;
+hooks.free_fn    = free;
 
+// Escapes decode to the characters they stand for, including pairs of
+// surrogates, and valid UTF-8 passes through.
+json = cJSON_Parse( "{\"k\\\"\\\\\\/\": \"\\b\\f\\n\\r\\t\\u0041\\u00e9\\u20ac\\ud83d\\ude00 \xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80\"}" );
 did_pass = ( NULL != json );
-did_pass = ( did_pass ) && ( cJSON_False == json->type );
+did_pass = ( did_pass ) && ( 0 == strcmp( "k\"\\/", json->child->string ) );
+did_pass = ( did_pass ) && ( 0 == strcmp( "\b\f\n\r\tA\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80 \xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80", json->child->valuestring ) );
+
+// Printing escapes quotes, backslashes and control characters again.
+printed  = cJSON_Print( json );
+did_pass = ( did_pass ) && ( NULL != printed );
+did_pass = ( did_pass ) && ( 0 == strcmp( "{\"k\\\"\\\\/\":\"\\b\\f\\n\\r\\tA\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80 \xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80\"}", printed ) );
+free( printed );
+cJSON_Delete( json );
+
+json     = cJSON_Parse( "\"\\u0001\\u001f\"" );
+printed  = cJSON_Print( json );
+did_pass = ( did_pass ) && ( NULL != printed ) && ( 0 == strcmp( "\"\\u0001\\u001f\"", printed ) );
+free( printed );
+cJSON_Delete( json );
+
+// Keys interned by their decoded text share one copy however they're spelled.
+json_str = "[{\"ab\":1},{\"a\\u0062\":2}]";
+json     = cJSON_ParseWithFlags( json_str, strlen( json_str ), cJSON_ParseInternKeys, &hooks );
+did_pass = ( did_pass ) && ( NULL != json );
+did_pass = ( did_pass ) && ( json->child->child->string == json->child->next->child->string );
+cJSON_Delete( json );
 
+// In situ, strings are decoded where they lie.
+json = cJSON_ParseInSitu( buffer, strlen( buffer ), &hooks );
+did_pass = ( did_pass ) && ( NULL != json );
+did_pass = ( did_pass ) && ( json->child->valuestring == &buffer[2] );
+did_pass = ( did_pass ) && ( 0 == strcmp( "a\tb\xc3\xa9\xf0\x9f\x98\x80", json->child->valuestring ) );
 cJSON_Delete( json );
 
+// SAX events get decoded text too.
+memset( &handler, 0, sizeof( handler ) );
+handler.key    = sax_log_key;
+handler.string = sax_log_string;
+memset( &log, 0, sizeof( log ) );
+log.stop_after = -1;
+json_str = "{\"\\u0041\":\"x\\ny\"}";
+did_pass = ( did_pass ) && ( cJSON_ParseSax( json_str, strlen( json_str ), &handler, &log ) );
+did_pass = ( did_pass ) && ( 0 == strcmp( "A:'x\ny' ", log.text ) );
+
+for( i = 0; i < sizeof( invalid ) / sizeof( invalid[0] ); i++ )
+    {
+    json     = cJSON_Parse( invalid[i] );
+    did_pass = ( did_pass ) && ( NULL == json );
+    did_pass = ( did_pass ) && ( !cJSON_Validate( invalid[i], strlen( invalid[i] ) ) );
+    did_pass = ( did_pass ) && ( !cJSON_ParseSax( invalid[i], strlen( invalid[i] ), &handler, &log ) );
+    cJSON_Delete( json );
+    }
+
 return did_pass;
-}    
+}
 
 
 /**********************************************************
-*	test_parse_null
+*	test_parse_string_special
 *
-*	Tests parsing a simple single null JSON value
+*	Tests parsing strings containing escapes and control characters
 *
 **********************************************************/
-static int test_parse_null
+static int test_parse_string_special
     (
     void
     )
@@ -422,82 +2438,105 @@ static int test_parse_null
 int     did_pass;
 cJSON * json;
 
-json = cJSON_Parse( "null" );
-
+// Long strings cross several scan blocks.
+json = cJSON_Parse( "\"The quick brown fox jumps over the lazy dog. The quick brown fox jumps over the lazy dog.\"" );
 did_pass = ( NULL != json );
-did_pass = ( did_pass ) && ( cJSON_Null == json->type );
+did_pass = ( did_pass ) && ( 0 == strcmp( "The quick brown fox jumps over the lazy dog. The quick brown fox jumps over the lazy dog.", json->valuestring ) );
+cJSON_Delete( json );
 
+// An escaped quote must not terminate the string.
+json = cJSON_Parse( "[\"say \\\"hi\\\"\", 1]" );
+did_pass = ( did_pass ) && ( NULL != json );
+did_pass = ( did_pass ) && ( 2 == cJSON_GetArraySize( json ) );
 cJSON_Delete( json );
 
+// Unescaped control characters and unterminated strings are invalid.
+json = cJSON_Parse( "\"tab\there\"" );
+did_pass = ( did_pass ) && ( NULL == json );
+
+json = cJSON_Parse( "\"unterminated" );
+did_pass = ( did_pass ) && ( NULL == json );
+
+json = cJSON_Parse( "\"trailing backslash\\" );
+did_pass = ( did_pass ) && ( NULL == json );
+
 return did_pass;
 }
 
 
 /**********************************************************
-*	test_parse_number
+*	test_parse_structural_index
 *
-*	Tests parsing numbers
+*	Tests parsing with a structural index built ahead of time
 *
 **********************************************************/
-static int test_parse_number
+static int test_parse_structural_index
     (
     void
     )
 {
-parse_number_test_case test_cases[] =
-    {/*     JSON,       should_parse_succeed,   exptd_value     */
-        {   "1.0",      1,                      1.0             },
-        {   "1",        1,                      1.0             },
-        {   "1.7e3",    1,                      1.7e3           },
-        {   "Infinity", 1,                      INFINITY        },
-        {   "-Infinity",1,                     -INFINITY        },
-        {   "-1.0",     1,                      -1.0            },
-        {   "-hello",   0,                      0.0             },
-        {   "1.hello",  0,                      0.0             },
-        {   "1,0hello", 0,                      0.0             }
+static char const * json_strs[] =
+    {
+    "{ \"a\": [ 1, 2.5, \"x\\\"y\", [], {} ], \"b\": { \"c\": null, \"d\": true }, \"e\": false }",
+    "  [ \"a string long enough to cross into the next block of sixty-four bytes\", \"\\\\\", \"\\\\\\\"\" ]  ",
+    "[ \"-------------------------------------------------------------\\\\\", 1 ]",
+    "[ \"--------------------------------------------------------------\\\"\", 2 ]",
+    "-12.5e2",
+    "\"top\"",
+    "[ 1, 2 }",
+    "[ \"a\"1 ]",
+    "[ 12ab ]",
+    "[ true false ]",
+    "{ \"a\" 1 }",
+    "[ \"unterminated ]",
+    "[ \"control \x01 character\" ]",
+    "[ 1 ] x",
+    "",
+    "   "
     };
 
-cJSON * json;
-int     i;
-int     did_pass;
+int             did_pass;
+size_t          i;
+cJSON *         json;
+cJSON *         indexed_json;
+char *          expected;
+char *          actual;
+cJSON_Hooks     hooks;
+
+hooks.malloc_fn  = malloc;
+hooks.realloc_fn = realloc;
+hooks.free_fn    = free;
 
 did_pass = 1;
 
-for( i = 0; ( did_pass ) && ( i < cnt_of_array( test_cases ) ); i++ )
+// Parsing with an index should accept and reject exactly the same documents.
+for( i = 0; ( did_pass ) && ( i < cnt_of_array( json_strs ) ); i++ )
     {
-    json = cJSON_Parse( test_cases[i].json );
+    json         = cJSON_ParseWithFlags( json_strs[i], strlen( json_strs[i] ), 0, &hooks );
+    indexed_json = cJSON_ParseWithFlags( json_strs[i], strlen( json_strs[i] ), cJSON_ParseStructuralIndex, &hooks );
+    expected     = cJSON_Print( json );
+    actual       = cJSON_Print( indexed_json );
 
-    if( test_cases[i].should_parse_succeed )
-        {
-        did_pass = ( NULL != json );
-        did_pass = ( did_pass ) && ( cJSON_Number == json->type );
-        did_pass = ( did_pass ) && ( test_cases[i].exptd_value == json->valuedouble );
-        }
-    else
-        {
-        did_pass = ( NULL == json );
-        }
+    did_pass = ( ( NULL == json ) == ( NULL == indexed_json ) );
+    did_pass = ( did_pass ) && ( ( NULL == json ) || ( 0 == strcmp( expected, actual ) ) );
 
+    free( expected );
+    free( actual );
     cJSON_Delete( json );
+    cJSON_Delete( indexed_json );
     }
 
-// Special test for parsing NaN
-json = cJSON_Parse( "NaN" );
-did_pass = ( did_pass ) && ( NULL != json );
-did_pass = ( did_pass ) && ( cJSON_Number == json->type );
-did_pass = ( did_pass ) && ( isnan( json->valuedouble ) );
-
 return did_pass;
 }
 
 
 /**********************************************************
-*	test_parse_object_simple_values
+*	test_parse_true
 *
-*	Tests parsing an object
+*	Tests parsing a simple single true JSON value
 *
 **********************************************************/
-static int test_parse_object_simple_values
+static int test_parse_true
     (
     void
     )
@@ -505,9 +2544,10 @@ static int test_parse_object_simple_values
 int     did_pass;
 cJSON * json;
 
-json = cJSON_Parse( "{ \"hello\" : \"world\", \"array\": [], \"null\": null, \"true\" : true }" );
+json = cJSON_Parse( "true" );
+
 did_pass = ( NULL != json );
-did_pass = ( did_pass ) && ( cJSON_Object == json->type );
+did_pass = ( did_pass ) && ( cJSON_True == json->type );
 
 cJSON_Delete( json );
 
@@ -516,23 +2556,41 @@ return did_pass;
 
 
 /**********************************************************
-*	test_parse_object_empty
+*	test_parse_whitespace
 *
-*	Tests parsing an empty object
+*	Tests parsing pretty-printed JSON with long runs of whitespace
 *
 **********************************************************/
-static int test_parse_object_empty
+static int test_parse_whitespace
     (
     void
     )
 {
 int     did_pass;
 cJSON * json;
+cJSON * item;
+
+json = cJSON_Parse(
+    "{\r\n"
+    "\t\"key\"   :\t[\n"
+    "                                        1,\n"
+    "                                        \"two\"   ,\n"
+    "                                        null\n"
+    "                                    ],\n"
+    "    \"other\" :                                         true\n"
+    "}"
+    );
 
-json = cJSON_Parse( "{}" );
 did_pass = ( NULL != json );
 did_pass = ( did_pass ) && ( cJSON_Object == json->type );
 
+item     = cJSON_GetObjectItem( json, "key" );
+did_pass = ( did_pass ) && ( 3 == cJSON_GetArraySize( item ) );
+
+item     = cJSON_GetObjectItem( json, "other" );
+did_pass = ( did_pass ) && ( NULL != item );
+did_pass = ( did_pass ) && ( cJSON_True == item->type );
+
 cJSON_Delete( json );
 
 return did_pass;
@@ -540,79 +2598,223 @@ return did_pass;
 
 
 /**********************************************************
-*	test_parse_string
+*	test_parse_with_length
 *
-*	Tests parsing a simple string
+*	Tests parsing length-bounded strings that are not null-terminated
 *
 **********************************************************/
-static int test_parse_string
+static int test_parse_with_length
     (
     void
     )
 {
-int     did_pass;
-cJSON * json;
-
-json = cJSON_Parse( "\"hello\"" );
+int         did_pass;
+cJSON *     json;
+char *      buffer;
+cJSON_Hooks hooks;
+
+hooks.malloc_fn  = malloc;
+hooks.realloc_fn = realloc;
+hooks.free_fn    = free;
+
+// Parse out of a buffer that has no null-terminator at all.
+buffer = (char*)malloc( 7 );
+memcpy( buffer, "[1,2,3]", 7 );
+json = cJSON_ParseWithLength( buffer, 7, &hooks );
 did_pass = ( NULL != json );
-did_pass = ( did_pass ) && ( cJSON_String == json->type );
-did_pass = ( did_pass ) && ( NULL != json->valuestring  );
-did_pass = ( did_pass ) && ( strlen( "hello" ) == strlen( json->valuestring ) );
-did_pass = ( did_pass ) && ( 0 == strcmp( "hello", json->valuestring ) );
+did_pass = ( did_pass ) && ( 3 == cJSON_GetArraySize( json ) );
+cJSON_Delete( json );
+free( buffer );
+
+// Characters past the length must be ignored.
+json = cJSON_ParseWithLength( "truex", 4, &hooks );
+did_pass = ( did_pass ) && ( NULL != json );
+did_pass = ( did_pass ) && ( cJSON_True == json->type );
+cJSON_Delete( json );
+
+json = cJSON_ParseWithLength( "123456", 3, &hooks );
+did_pass = ( did_pass ) && ( NULL != json );
+did_pass = ( did_pass ) && ( 123.0 == json->valuedouble );
+cJSON_Delete( json );
 
+json = cJSON_ParseWithLength( "{ \"key\": [ null ] }   \n", 22, &hooks );
+did_pass = ( did_pass ) && ( NULL != json );
+did_pass = ( did_pass ) && ( cJSON_ObjectHasItem( json, "key" ) );
 cJSON_Delete( json );
 
+// Values cut off by the length are invalid.
+did_pass = ( did_pass ) && ( NULL == cJSON_ParseWithLength( "\"abc\"", 4, &hooks ) );
+did_pass = ( did_pass ) && ( NULL == cJSON_ParseWithLength( "null", 3, &hooks ) );
+did_pass = ( did_pass ) && ( NULL == cJSON_ParseWithLength( "[1, 2]", 5, &hooks ) );
+did_pass = ( did_pass ) && ( NULL == cJSON_ParseWithLength( "[]", 0, &hooks ) );
+
 return did_pass;
 }
 
 
 /**********************************************************
-*	test_parse_string_empty
+*	test_parser_reuse
 *
-*	Tests parsing an empty string
+*	Tests parsing several documents with one parser
 *
 **********************************************************/
-static int test_parse_string_empty
+static int test_parser_reuse
     (
     void
     )
 {
-int     did_pass;
-cJSON * json;
+int             did_pass;
+cJSON_Parser *  parser;
+cJSON *         json;
+cJSON_Hooks     hooks;
+int             i;
+size_t          malloc_cnt;
+char const *    json_strs[] =
+    {
+    "{ \"id\": 1, \"name\": \"first\", \"tags\": [\"a\", \"b\"] }",
+    "{ \"id\": 2, \"name\": \"second\", \"tags\": [\"c\"] }",
+    "{ \"id\": 3, \"name\": \"third\", \"tags\": [] }",
+    };
 
-json = cJSON_Parse( "\"\"" );
-did_pass = ( NULL != json );
-did_pass = ( did_pass ) && ( cJSON_String == json->type );
-did_pass = ( did_pass ) && ( NULL != json->valuestring  );
-did_pass = ( did_pass ) && ( 0 == strcmp( "", json->valuestring ) );
+hooks.malloc_fn  = counted_malloc;
+hooks.realloc_fn = realloc;
+hooks.free_fn    = free;
+
+parser   = cJSON_ParserCreateWithHooks( &hooks );
+did_pass = ( NULL != parser );
+
+for( i = 0; ( did_pass ) && ( i < (int)cnt_of_array( json_strs ) ); i++ )
+    {
+    malloc_cnt = counted_malloc_cnt;
+    json       = cJSON_ParserParse( parser, json_strs[i], strlen( json_strs[i] ) );
+    did_pass   = ( NULL != json ) && ( json->flags & cJSON_InArena );
+    did_pass   = ( did_pass ) && ( i + 1 == cJSON_GetObjectItem( json, "id" )->valueint );
+
+    // Once the first document has been parsed, its memory is reused.
+    did_pass   = ( did_pass ) && ( ( 0 == i ) || ( malloc_cnt == counted_malloc_cnt ) );
+
+    // Deleting a parser-owned tree must be a harmless no-op.
+    cJSON_Delete( json );
+    }
 
+// A failed parse leaves the parser usable.
+did_pass = ( did_pass ) && ( NULL == cJSON_ParserParse( parser, "[1, 2", 5 ) );
+json     = cJSON_ParserParse( parser, "[1, 2]", 6 );
+did_pass = ( did_pass ) && ( NULL != json ) && ( 2 == cJSON_GetArraySize( json ) );
+
+// Resetting abandons a document being fed, keeping the parser usable.
+did_pass = ( did_pass ) && ( cJSON_ParserFeed( parser, "{\"a\": [1,", 9 ) );
+cJSON_ParserReset( parser );
+did_pass = ( did_pass ) && ( cJSON_ParserFeed( parser, "[true]", 6 ) );
+json     = cJSON_ParserFinish( parser );
+did_pass = ( did_pass ) && ( NULL != json ) && ( cJSON_True == json->child->type );
 cJSON_Delete( json );
 
+cJSON_ParserDelete( parser );
+
 return did_pass;
 }
 
 
 /**********************************************************
-*	test_parse_true
+*	test_query
 *
-*	Tests parsing a simple single true JSON value
+*	Tests running compiled path queries against documents
 *
 **********************************************************/
-static int test_parse_true
+static int test_query
     (
     void
     )
 {
-int     did_pass;
-cJSON * json;
+int             did_pass;
+cJSON_Hooks     hooks;
+cJSON_Query *   query;
+cJSON *         json;
+cJSON *         matches[4];
+char            json_str[2048];
+size_t          json_len;
+size_t          match_cnt;
+int             i;
 
-json = cJSON_Parse( "true" );
+hooks.malloc_fn  = malloc;
+hooks.realloc_fn = realloc;
+hooks.free_fn    = free;
+
+json_str[0] = '[';
+json_len    = 1 + (size_t)sprintf( &json_str[1], "{ \"user\": { \"id\": 7 }, \"a/b\": { \"~\": true }, \"items\": [ { \"price\": 1 }, { \"price\": 2 }, { \"name\": \"x\" }, { \"price\": 3 } ], \"big\": [ 0" );
+for( i = 1; i < 100; i++ )
+    {
+    json_len += (size_t)sprintf( &json_str[json_len], ", { \"k%d\": %d }", i, i );
+    }
+json_len += (size_t)sprintf( &json_str[json_len], " ] }" );
 
+json     = cJSON_Parse( &json_str[1] );
 did_pass = ( NULL != json );
-did_pass = ( did_pass ) && ( cJSON_True == json->type );
 
+// Plain pointers find one value.
+query     = cJSON_QueryCompile( "/user/id" );
+match_cnt = cJSON_QueryRun( query, json, matches, 4 );
+did_pass  = ( did_pass ) && ( 1 == match_cnt ) && ( 7 == matches[0]->valueint );
+cJSON_QueryDelete( query );
+
+query     = cJSON_QueryCompile( "/a~1b/~0" );
+match_cnt = cJSON_QueryRun( query, json, matches, 4 );
+did_pass  = ( did_pass ) && ( 1 == match_cnt ) && ( cJSON_True == matches[0]->type );
+cJSON_QueryDelete( query );
+
+query     = cJSON_QueryCompile( "/items/1/price" );
+match_cnt = cJSON_QueryRun( query, json, matches, 4 );
+did_pass  = ( did_pass ) && ( 1 == match_cnt ) && ( 2 == matches[0]->valueint );
+cJSON_QueryDelete( query );
+
+// Indexed containers are looked up through their index.
+query     = cJSON_QueryCompile( "/big/57/k57" );
+match_cnt = cJSON_QueryRun( query, json, matches, 4 );
+did_pass  = ( did_pass ) && ( 1 == match_cnt ) && ( 57 == matches[0]->valueint );
+cJSON_QueryDelete( query );
+
+// The empty pointer is the whole document.
+query     = cJSON_QueryCompile( "" );
+match_cnt = cJSON_QueryRun( query, json, matches, 4 );
+did_pass  = ( did_pass ) && ( 1 == match_cnt ) && ( json == matches[0] );
+cJSON_QueryDelete( query );
+
+// Wildcards find every match in document order, and all are counted even
+// when there is no room to store them.
+query     = cJSON_QueryCompile( "/items/*/price" );
+match_cnt = cJSON_QueryRun( query, json, matches, 4 );
+did_pass  = ( did_pass ) && ( 3 == match_cnt ) && ( 1 == matches[0]->valueint ) && ( 2 == matches[1]->valueint ) && ( 3 == matches[2]->valueint );
+did_pass  = ( did_pass ) && ( 3 == cJSON_QueryRun( query, json, matches, 1 ) ) && ( 3 == cJSON_QueryRun( query, json, NULL, 0 ) );
+cJSON_QueryDelete( query );
+
+query    = cJSON_QueryCompile( "/*" );
+did_pass = ( did_pass ) && ( 4 == cJSON_QueryRun( query, json, NULL, 0 ) );
+cJSON_QueryDelete( query );
+
+// Values the path doesn't reach match nothing.
+query    = cJSON_QueryCompile( "/items/01/price" );
+did_pass = ( did_pass ) && ( 0 == cJSON_QueryRun( query, json, matches, 4 ) );
+cJSON_QueryDelete( query );
+
+query    = cJSON_QueryCompile( "/user/id/x" );
+did_pass = ( did_pass ) && ( 0 == cJSON_QueryRun( query, json, matches, 4 ) );
+cJSON_QueryDelete( query );
+
+cJSON_Delete( json );
+
+// Lazy containers are parsed as the query reaches them.
+json_str[json_len++] = ']';
+json      = cJSON_ParseWithFlags( json_str, json_len, cJSON_ParseLazy, &hooks );
+query     = cJSON_QueryCompile( "/0/big/*/k99" );
+match_cnt = cJSON_QueryRun( query, json, matches, 4 );
+did_pass  = ( did_pass ) && ( 1 == match_cnt ) && ( 99 == matches[0]->valueint );
+cJSON_QueryDelete( query );
 cJSON_Delete( json );
 
+// Pointers must start with '/' and use only "~0" and "~1" escapes.
+did_pass = ( did_pass ) && ( NULL == cJSON_QueryCompile( "user" ) ) && ( NULL == cJSON_QueryCompile( "/a~2" ) ) && ( NULL == cJSON_QueryCompile( "/a~" ) );
+
 return did_pass;
 }
 
@@ -677,6 +2879,26 @@ return serialize_test_case_run( "null" );
 }
 
 
+/**********************************************************
+*	test_serialize_number_exact
+*
+*	Tests that serialized numbers read back as the same value
+*
+**********************************************************/
+static int test_serialize_number_exact
+    (
+    void
+    )
+{
+int did_pass;
+
+did_pass = serialize_test_case_run( "[9223372036854775807,-9223372036854775808,12345678901234567,0,-1,100]" );
+did_pass = ( did_pass ) && ( serialize_test_case_run( "[0.1,-2.5,1e+300,0.30000000000000004,NaN,-Infinity]" ) );
+
+return did_pass;
+}
+
+
 /**********************************************************
 *	test_serialize_object_simple_values
 *
@@ -766,3 +2988,49 @@ static int test_serialize_true
 {
 return serialize_test_case_run( "true" );
 }
+
+
+/**********************************************************
+*	test_validate
+*
+*	Tests checking documents without building them
+*
+**********************************************************/
+static int test_validate
+    (
+    void
+    )
+{
+int         did_pass;
+int         i;
+char        deep[2 * 1100 + 1];
+char const* valid[]   = { "{\"a\":[1,-2.5e3,\"x\\\"y\",true,false,null,{}],\"b\":{\"c\":[]}}", " 7 ", "\"s\"" };
+char const* invalid[] = { "", "{\"a\":}", "[1,]", "[1 2]", "{\"a\" 1}", "tru", "[1]]", "\"x", "{} {}" };
+
+did_pass = 1;
+
+for( i = 0; i < cnt_of_array( valid ); i++ )
+    {
+    did_pass = ( did_pass ) && ( cJSON_Validate( valid[i], strlen( valid[i] ) ) );
+    }
+
+for( i = 0; i < cnt_of_array( invalid ); i++ )
+    {
+    did_pass = ( did_pass ) && ( !cJSON_Validate( invalid[i], strlen( invalid[i] ) ) );
+    }
+
+// Only the given length is checked.
+did_pass = ( did_pass ) && ( cJSON_Validate( "[1] trailing", 3 ) );
+
+// Nesting deeper than the fixed-size stack is rejected.
+for( i = 0; i < 1100; i++ )
+    {
+    deep[i]                = '[';
+    deep[2 * 1100 - 1 - i] = ']';
+    }
+deep[2 * 1100] = '\0';
+did_pass = ( did_pass ) && ( !cJSON_Validate( deep, strlen( deep ) ) );
+did_pass = ( did_pass ) && ( cJSON_Validate( &deep[1100 - 1000], 2 * 1000 ) );
+
+return did_pass;
+}
\ No newline at end of file
@@ -1,6 +1,106 @@
 
+#include <limits.h>
+
 #include "cJSON2_private.h"
 
+#define BUFFER_MIN_SIZE         ( 64 )
+
+
+/**********************************************************
+*	buffer_reserve
+*
+*	Makes sure a buffer, whose size in bytes is tracked by
+*   buffer_size, holds at least needed_size bytes, doubling
+*   it as needed. Returns 0 if memory runs out, leaving the
+*   buffer as it was.
+*
+**********************************************************/
+int buffer_reserve
+    (
+    cJSON_Hooks const * hooks,
+    void **             buffer,
+    size_t *            buffer_size,
+    size_t              needed_size
+    )
+{
+void *  new_buffer;
+size_t  new_size;
+
+if( needed_size <= *buffer_size )
+    {
+    return 1;
+    }
+
+for( new_size = ( 0 == *buffer_size ) ? BUFFER_MIN_SIZE : 2 * *buffer_size; new_size < needed_size; new_size *= 2 )
+    ;
+
+new_buffer = hooks->realloc_fn( *buffer, new_size );
+if( NULL == new_buffer )
+    {
+    return 0;
+    }
+
+*buffer      = new_buffer;
+*buffer_size = new_size;
+
+return 1;
+}
+
+
+/**********************************************************
+*	double_to_int
+*
+*	Converts a double to an int, saturating values that are
+*   out of range instead of invoking undefined behavior.
+*
+**********************************************************/
+int double_to_int
+    (
+    double value
+    )
+{
+if( value >= INT_MAX )
+    {
+    return INT_MAX;
+    }
+else if( value <= INT_MIN )
+    {
+    return INT_MIN;
+    }
+else if( value != value )
+    {
+    // NaN
+    return 0;
+    }
+
+return (int)value;
+}
+
+
+/**********************************************************
+*	int64_to_int
+*
+*	Converts a 64-bit integer to an int, saturating values
+*   that are out of range.
+*
+**********************************************************/
+int int64_to_int
+    (
+    int64_t value
+    )
+{
+if( value > INT_MAX )
+    {
+    return INT_MAX;
+    }
+else if( value < INT_MIN )
+    {
+    return INT_MIN;
+    }
+
+return (int)value;
+}
+
 
 /**********************************************************
 *	parent_node_is_array
@@ -11,8 +11,202 @@ extern "C"
 #endif
 
 
+#include <stddef.h>
+
 #include "cJSON2.h"
 
+#define NUMBER_PRINT_SIZE       ( 32 )
+
+// Arrays and objects with at least this many children get an index of them
+// when parsed. Override with -DCJSON_ARRAY_INDEX_THRESHOLD=<n> or
+// -DCJSON_OBJECT_INDEX_THRESHOLD=<n> when building.
+#ifndef CJSON_ARRAY_INDEX_THRESHOLD
+    #define CJSON_ARRAY_INDEX_THRESHOLD     ( 32 )
+#endif
+
+#ifndef CJSON_OBJECT_INDEX_THRESHOLD
+    #define CJSON_OBJECT_INDEX_THRESHOLD    ( 32 )
+#endif
+
+#define ARRAY_INDEX_CHUNK_SIZE  ( 512 )
+
+#define array_index_from_node( _node ) ( (array_index*)(void*)(_node)->valuestring )
+
+#define array_index_item( _index, _i ) ( (_index)->chunks[(_i) / ARRAY_INDEX_CHUNK_SIZE][(_i) % ARRAY_INDEX_CHUNK_SIZE] )
+
+#define interned_key_from_string( _string ) ( (interned_key*)( (_string) - offsetof( interned_key, text ) ) )
+
+#define lazy_container_from_node( _node ) ( (lazy_container*)( (_node)->valuestring - offsetof( lazy_container, text ) ) )
+
+#define object_index_from_node( _node ) ( (object_index*)(void*)(_node)->valuestring )
+
+#define is_json_whitespace( _c ) ( ( ' ' == (_c) ) || ( '\n' == (_c) ) || ( '\r' == (_c) ) || ( '\t' == (_c) ) )
+
+/****************************************
+Types
+****************************************/
+// The items are kept in fixed-size chunks rather than one growing vector, so
+// that the index of a large array never needs a block big enough to upset
+// how the allocator reuses the memory of the nodes around it.
+typedef struct
+    {
+    size_t      size;           /* Slots in chunks, NULL past the last used */
+    cJSON **    chunks[1];      /* ARRAY_INDEX_CHUNK_SIZE items each, in order */
+    } array_index;
+
+typedef struct
+    {
+    size_t      ref_cnt;        /* Nodes whose string is this key       */
+    size_t      len;
+    char        text[1];
+    } interned_key;
+
+typedef struct
+    {
+    interned_key ** entries;        /* Open addressing, NULL if empty   */
+    size_t          size;           /* Number of slots, a power of 2    */
+    size_t          cnt;
+    } key_table;
+
+typedef struct
+    {
+    double      valuedouble;
+    int64_t     valueint64;
+    int         is_int64;       /* valueint64 holds the exact value */
+    } number_value;
+
+typedef struct
+    {
+    cJSON_Hooks     hooks;          /* Used to parse the container's items  */
+    cJSON_Arena *   arena;
+    char            text[1];        /* The container's unparsed JSON text   */
+    } lazy_container;
+
+typedef struct
+    {
+    size_t          size;           /* Number of slots, a power of 2    */
+    int             has_duplicates; /* Some members share a key         */
+    cJSON *         entries[1];     /* First member with each key, open */
+                                    /* addressing, NULL if empty        */
+    } object_index;
+
+
+/****************************************
+Functions
+****************************************/
+
+void * arena_alloc
+    (
+    cJSON_Arena *   arena,
+    size_t          size
+    );
+
+int array_index_append
+    (
+    cJSON *             array,
+    cJSON *             item,
+    cJSON_Hooks const * hooks,
+    cJSON_Arena *       arena
+    );
+
+void array_index_remove
+    (
+    cJSON * array,
+    size_t  index
+    );
+
+int buffer_reserve
+    (
+    cJSON_Hooks const * hooks,
+    void **             buffer,
+    size_t *            buffer_size,
+    size_t              needed_size
+    );
+
+int container_index_build
+    (
+    cJSON *             container,
+    cJSON_Hooks const * hooks,
+    cJSON_Arena *       arena
+    );
+
+void container_index_free
+    (
+    cJSON *             container,
+    cJSON_Hooks const * hooks
+    );
+
+int double_to_int
+    (
+    double value
+    );
+
+int int64_to_int
+    (
+    int64_t value
+    );
+
+void interned_key_release
+    (
+    char *              key,
+    cJSON_Hooks const * hooks
+    );
+
+uint32_t key_hash
+    (
+    char const *    key,
+    size_t          key_len
+    );
+
+void key_table_clear
+    (
+    key_table * table
+    );
+
+void key_table_free
+    (
+    key_table *         table,
+    cJSON_Hooks const * hooks
+    );
+
+char * key_table_intern
+    (
+    key_table *         table,
+    cJSON_Hooks const * hooks,
+    cJSON_Arena *       arena,
+    char const *        key,
+    size_t              key_len
+    );
+
+char const * number_parse
+    (
+    char const *        str,
+    char const *        str_end,
+    cJSON_Hooks const * hooks,
+    cJSON_Arena *       arena,
+    number_value *      value_out
+    );
+
+int number_print
+    (
+    number_value const *    value,
+    char *                  buffer,
+    size_t                  buffer_len
+    );
+
+cJSON * object_index_find
+    (
+    cJSON const *   object,
+    char const *    key,
+    uint32_t        hash
+    );
+
+void object_index_remove
+    (
+    cJSON * object,
+    cJSON * item
+    );
+
 int parent_node_is_array
     (
     cJSON const * node
@@ -23,6 +217,58 @@ int parent_node_is_object
     cJSON const * node
     );
 
+int lazy_container_materialize
+    (
+    cJSON * node
+    );
+
+long structural_index_build
+    (
+    char const *    json_str,
+    size_t          json_len,
+    uint32_t *      index_out
+    );
+
+int sax_parse
+    (
+    char const *                json_str,
+    size_t                      json_len,
+    cJSON_SaxHandler const *    handler,
+    void *                      user_data,
+    cJSON_Hooks const *         hooks
+    );
+
+char const * scan_container_end
+    (
+    char const * container,
+    char const * string_end
+    );
+
+char const * scan_string
+    (
+    char const * string_in,
+    char const * string_end
+    );
+
+char const * scan_string_plain
+    (
+    char const * string_in,
+    char const * string_end
+    );
+
+char const * scan_whitespace
+    (
+    char const * string_in,
+    char const * string_end
+    );
+
+long string_decode
+    (
+    char const *    string_in,
+    char const *    string_end,
+    char *          decoded_out
+    );
+
 
 #ifdef __cplusplus
 }